@@ -22,21 +22,9 @@
 
 #include <asm/io.h>
 
-#define BOOTROM_COLD_RESET_BRANCH 0x0000019c
-
 #define SMCTR_BASE 0x38096000
 #define SMCTR_BOOT_REMAP (SMCTR_BASE + 0x4)
 
-#define ARM_PERIPHBASE 0x39000000
-#define SCU_BASE ARM_PERIPHBASE
-#define SCU_POWER_STATUS (SCU_BASE + 0x8)
-#define SCU_PM_NORMAL	0
-#define SCU_PM_DORMANT	2
-#define SCU_PM_POWEROFF	3
-
-#define PMCTR_BASE 0x38095000
-#define PMCTR_SYS_PWR_STATUS (PMCTR_BASE + 0x0c)
-
 /* SD/MMC does not work with big baseclkfreq value (#MCOM02SW-55).
  * As a workaround set baseclkfreq to 32 MHz if real frequency exceeds
  * 100 MHz. */
@@ -0,0 +1,118 @@
+/*
+ * Secondary CPU control for MCom platform
+ *
+ * CPU1 is powered off by the SPL. When it is powered up again, Bootrom
+ * branches to the address held in ALWAYS_MISC0.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/arch/regs.h>
+#include <asm/armv7.h>
+#include <asm/io.h>
+#include <linux/errno.h>
+
+#define MCOM_CPUS 2
+
+static bool cpu_powered(u32 nr)
+{
+	return !(readl(PMCTR_SYS_PWR_STATUS) & BIT(nr + 1));
+}
+
+int is_core_valid(unsigned int core)
+{
+	return core < MCOM_CPUS;
+}
+
+int cpu_status(u32 nr)
+{
+	printf("core %d => %d\n", nr, cpu_powered(nr));
+	return 0;
+}
+
+int cpu_reset(u32 nr)
+{
+	return -ENOSYS;
+}
+
+static bool cpu_wait_off(u32 nr, ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+
+	while (cpu_powered(nr)) {
+		if (get_timer(start) > timeout_ms)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * The CPU powers itself off, as the SPL does, so that it is not cut off while
+ * cleaning its cache. Wait for that to happen, forcing it off if it does not.
+ */
+int cpu_disable(u32 nr)
+{
+	if (nr == 0 || !is_core_valid(nr))
+		return 1;
+
+	if (!cpu_wait_off(nr, 1000)) {
+		writel(BIT(nr + 1), PMCTR_SYS_PWR_DOWN);
+		if (!cpu_wait_off(nr, 1000))
+			return 1;
+	}
+	writel(BOOTROM_COLD_RESET_BRANCH, PMCTR_ALWAYS_MISC0);
+
+	return 0;
+}
+
+int cpu_release(u32 nr, int argc, char *const argv[])
+{
+	ulong boot_addr;
+	u32 val;
+
+	if (nr == 0 || !is_core_valid(nr) || cpu_powered(nr))
+		return 1;
+
+	boot_addr = simple_strtoul(argv[0], NULL, 16);
+
+	/* The CPUs only see each other's caches through the SCU */
+	if (!(readl(SCU_CTRL) & SCU_CTRL_ENABLE)) {
+		setbits_le32(SCU_CTRL, SCU_CTRL_ENABLE);
+		flush_dcache_all();
+	}
+
+	/* CPU1 set this to power-off before the SPL parked it */
+	val = readl(SCU_POWER_STATUS);
+	val &= ~(SCU_PM_POWEROFF << (nr * 8));
+	writel(val, SCU_POWER_STATUS);
+
+	writel(boot_addr, PMCTR_ALWAYS_MISC0);
+	writel(BIT(nr + 1), PMCTR_SYS_PWR_UP);
+	while (!cpu_powered(nr))
+		continue;
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(MP_JOB)
+/* Restore ALWAYS_MISC0 so that the SoC can be rebooted correctly */
+void arm_mp_job_cpu_started(int cpu)
+{
+	writel(BOOTROM_COLD_RESET_BRANCH, PMCTR_ALWAYS_MISC0);
+}
+
+/* Ask the PMCTR to power this CPU off once it is in WFI */
+void arm_mp_job_cpu_off(int cpu)
+{
+	u32 val;
+
+	val = readl(SCU_POWER_STATUS);
+	val |= SCU_PM_POWEROFF << (cpu * 8);
+	writel(val, SCU_POWER_STATUS);
+
+	for (;;)
+		wfi();
+}
+#endif
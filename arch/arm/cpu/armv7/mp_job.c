@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running jobs on secondary ARMv7 CPUs
+ *
+ * A secondary CPU is released with cpu_release() the first time a job is
+ * given to it. It joins the boot CPU in the coherency domain, switches to
+ * the boot CPU's page tables and then waits in WFE for jobs. A CPU which
+ * fails to start is not used again. Before the OS starts, each CPU cleans
+ * its cache, leaves the coherency domain and is handed to cpu_disable().
+ *
+ * The boot CPU must already be in SMP mode, see cpu_init_cp15, and memory
+ * is mapped Shareable, see set_section_dcache(). Otherwise neither the
+ * caches nor the exclusive monitors are kept coherent between the CPUs.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <watchdog.h>
+#include <asm/armv7.h>
+#include <asm/system.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define ARM_MP_JOB_STACK_SIZE	SZ_32K
+#define ARM_MP_JOB_TIMEOUT_MS	1000
+
+/* ACTLR bits for taking part in coherency and cache maintenance broadcast */
+#define ACTLR_SMP	(1 << 6)
+#define ACTLR_FW	(1 << 0)
+
+/*
+ * Values read by arm_mp_job_entry before the MMU is enabled. The order
+ * must match mp_job_entry.S
+ */
+enum {
+	MP_BOOT_TTBR0,
+	MP_BOOT_TTBCR,
+	MP_BOOT_DACR,
+	MP_BOOT_SCTLR,
+	MP_BOOT_GD,
+
+	MP_BOOT_COUNT,
+};
+
+ulong arm_mp_job_boot[MP_BOOT_COUNT];
+ulong arm_mp_job_stack[MP_JOB_MAX_CPUS + 1];
+
+/**
+ * struct arm_mp_job_cpu - State of a secondary CPU
+ *
+ * @job:	Job for the CPU to run, cleared by the CPU when it takes it
+ * @stack:	Stack allocated for the CPU
+ * @running:	true once the CPU is waiting for jobs
+ * @stop:	Set to tell the CPU to stop waiting for jobs
+ * @failed:	true if the CPU could not be started
+ */
+struct arm_mp_job_cpu {
+	struct mp_job *job;
+	void *stack;
+	bool running;
+	bool stop;
+	bool failed;
+};
+
+static struct arm_mp_job_cpu arm_mp_job_cpus[MP_JOB_MAX_CPUS + 1];
+
+static inline void wfe(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+static inline void sev(void)
+{
+	asm volatile("sev" : : : "memory");
+}
+
+static inline u32 read_actlr(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 1" : "=r" (val));
+
+	return val;
+}
+
+__weak void arm_mp_job_cpu_started(int cpu)
+{
+}
+
+/*
+ * Called on a secondary CPU by arm_mp_job_exit(), once its cache is off and
+ * clean and it has left the coherency domain. The SoC may power the CPU down
+ * from here. This must not return, nor rely on anything the CPU wrote to
+ * its stack before.
+ */
+__weak void arm_mp_job_cpu_off(int cpu)
+{
+	for (;;)
+		wfi();
+}
+
+static int arm_mp_job_release(int cpu)
+{
+	struct arm_mp_job_cpu *priv = &arm_mp_job_cpus[cpu];
+	char addr[20];
+	char *argv[] = { addr };
+	ulong start;
+	void *stack;
+	u32 val;
+
+	/* The SMP bit cannot be changed now that the caches are on */
+	if ((read_actlr() & (ACTLR_SMP | ACTLR_FW)) != (ACTLR_SMP | ACTLR_FW)) {
+		debug("%s: Boot CPU is not in SMP mode\n", __func__);
+		priv->failed = true;
+		return -ENXIO;
+	}
+
+	stack = memalign(16, ARM_MP_JOB_STACK_SIZE);
+	if (!stack)
+		return -ENOMEM;
+	arm_mp_job_stack[cpu] = (ulong)stack + ARM_MP_JOB_STACK_SIZE;
+
+	asm volatile("mrc p15, 0, %0, c2, c0, 0" : "=r" (val));
+	arm_mp_job_boot[MP_BOOT_TTBR0] = val;
+	asm volatile("mrc p15, 0, %0, c2, c0, 2" : "=r" (val));
+	arm_mp_job_boot[MP_BOOT_TTBCR] = val;
+	asm volatile("mrc p15, 0, %0, c3, c0, 0" : "=r" (val));
+	arm_mp_job_boot[MP_BOOT_DACR] = val;
+	arm_mp_job_boot[MP_BOOT_SCTLR] = get_cr();
+	arm_mp_job_boot[MP_BOOT_GD] = (ulong)gd;
+
+	/* The CPU reads these with its MMU and caches off */
+	flush_dcache_all();
+
+	snprintf(addr, sizeof(addr), "%lx", (ulong)arm_mp_job_entry);
+	if (cpu_release(cpu, 1, argv)) {
+		debug("%s: Cannot release CPU %d\n", __func__, cpu);
+		free(stack);
+		priv->failed = true;
+		return -EIO;
+	}
+
+	priv->stack = stack;
+	priv->stop = false;
+	start = get_timer(0);
+	while (!__atomic_load_n(&priv->running, __ATOMIC_ACQUIRE)) {
+		if (get_timer(start) > ARM_MP_JOB_TIMEOUT_MS) {
+			debug("%s: CPU %d did not start\n", __func__, cpu);
+			cpu_disable(cpu);
+			/* The stack is not freed, in case the CPU is using it */
+			priv->failed = true;
+			return -ETIMEDOUT;
+		}
+	}
+	arm_mp_job_cpu_started(cpu);
+
+	return 0;
+}
+
+void arm_mp_job_secondary(int cpu)
+{
+	struct arm_mp_job_cpu *priv = &arm_mp_job_cpus[cpu];
+	struct mp_job *job;
+
+	__atomic_store_n(&priv->running, true, __ATOMIC_RELEASE);
+	dsb();
+	sev();
+
+	for (;;) {
+		job = __atomic_load_n(&priv->job, __ATOMIC_ACQUIRE);
+		if (!job) {
+			if (__atomic_load_n(&priv->stop, __ATOMIC_ACQUIRE))
+				break;
+			wfe();
+			continue;
+		}
+
+		/* Take the job first, since another may follow once it is done */
+		priv->job = NULL;
+		mp_job_run(job);
+		dsb();
+		sev();
+	}
+
+	arm_mp_job_exit(cpu);
+}
+
+int arch_mp_job_cpus(void)
+{
+	int cpus = 0;
+
+	while (cpus < MP_JOB_MAX_CPUS && is_core_valid(cpus + 1))
+		cpus++;
+
+	return cpus;
+}
+
+int arch_mp_job_start(int cpu, struct mp_job *job)
+{
+	struct arm_mp_job_cpu *priv = &arm_mp_job_cpus[cpu];
+	int ret;
+
+	if (priv->failed)
+		return -EIO;
+	if (!priv->running) {
+		ret = arm_mp_job_release(cpu);
+		if (ret)
+			return ret;
+	}
+
+	__atomic_store_n(&priv->job, job, __ATOMIC_RELEASE);
+	dsb();
+	sev();
+
+	return 0;
+}
+
+int arch_mp_job_cpu(void)
+{
+	u32 mpidr;
+
+	asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r" (mpidr));
+
+	return mpidr & 0xff;
+}
+
+/* Spin rather than WFE, so that the watchdog is kept alive meanwhile */
+void arch_mp_job_join(int cpu, struct mp_job *job)
+{
+	while (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+		WATCHDOG_RESET();
+}
+
+void arch_mp_job_stop(int cpu)
+{
+	struct arm_mp_job_cpu *priv = &arm_mp_job_cpus[cpu];
+
+	if (!priv->running)
+		return;
+
+	__atomic_store_n(&priv->stop, true, __ATOMIC_RELEASE);
+	dsb();
+	sev();
+	if (cpu_disable(cpu)) {
+		/* It may still be cleaning its cache, so do not reuse it */
+		printf("CPU %d did not stop\n", cpu);
+		priv->failed = true;
+		return;
+	}
+	free(priv->stack);
+	priv->stack = NULL;
+	priv->running = false;
+}
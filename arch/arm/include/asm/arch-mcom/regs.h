@@ -28,6 +28,23 @@
 #define PMCTR_BASE  0x38095000
 #define SMCTR_BASE  0x38096000
 
+#define BOOTROM_COLD_RESET_BRANCH 0x0000019c
+
+#define ARM_PERIPHBASE 0x39000000
+#define SCU_BASE ARM_PERIPHBASE
+#define SCU_CTRL (SCU_BASE + 0x0)
+#define SCU_CTRL_ENABLE	BIT(0)
+#define SCU_POWER_STATUS (SCU_BASE + 0x8)
+#define SCU_PM_NORMAL	0
+#define SCU_PM_DORMANT	2
+#define SCU_PM_POWEROFF	3
+
+/* SYS_PWR_UP is the first (unnamed) register of pmctr_t */
+#define PMCTR_SYS_PWR_UP (PMCTR_BASE + 0x00)
+#define PMCTR_SYS_PWR_DOWN (PMCTR_BASE + 0x04)
+#define PMCTR_SYS_PWR_STATUS (PMCTR_BASE + 0x0c)
+#define PMCTR_ALWAYS_MISC0 (PMCTR_BASE + 0x70)
+
 #define INIT_SYS_REGS(r) {\
 r.DDRMC0=(ddrmc_t*)DDRMC0_BASE;\
 r.DDRPHY0=(ddrphy_t*)DDRPHY0_BASE;\
@@ -151,6 +151,18 @@ extern char __secure_stack_end[];
 
 #endif /* CONFIG_ARMV7_NONSEC */
 
+#if CONFIG_IS_ENABLED(MP_JOB)
+
+/* defined in assembly file */
+void arm_mp_job_entry(void);
+void __noreturn arm_mp_job_exit(int cpu);
+
+void arm_mp_job_secondary(int cpu);
+void arm_mp_job_cpu_started(int cpu);
+void arm_mp_job_cpu_off(int cpu);
+
+#endif /* MP_JOB */
+
 void v7_arch_cp15_set_l2aux_ctrl(u32 l2auxctrl, u32 cpu_midr,
 				 u32 cpu_rev_comb, u32 cpu_variant,
 				 u32 cpu_rev);
@@ -20,6 +20,7 @@
 #include <asm/byteorder.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
+#include <mp_job.h>
 #include <fdt_support.h>
 #include <asm/bootm.h>
 #include <asm/secure.h>
@@ -111,6 +112,9 @@ static void announce_and_cleanup(int fake)
 	 */
 	dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
 
+	/* Hand any CPUs which ran jobs back, for the OS to start them */
+	mp_job_stop_cpus();
+
 	cleanup_before_linux();
 }
 
@@ -40,6 +40,15 @@ void set_section_dcache(int section, enum dcache_option option)
 	/* Add caching bits */
 	value |= option;
 
+#if !defined(CONFIG_ARMV7_LPAE) && CONFIG_IS_ENABLED(MP_JOB)
+	/*
+	 * The SCU only keeps Shareable memory coherent, and exclusive
+	 * accesses only work between CPUs on Shareable memory
+	 */
+	if (option != DCACHE_OFF)
+		value |= TTB_SECT_S_MASK;
+#endif
+
 	/* Set PTE */
 	page_table[section] = value;
 }
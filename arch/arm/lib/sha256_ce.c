@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA256 using the ARMv8 Crypto Extensions, where the CPU has them
+ */
+
+#include <common.h>
+#include <u-boot/sha256.h>
+
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 unsigned int blocks);
+
+/* ID_AA64ISAR0_EL1.SHA2 is non-zero if SHA256H and friends are implemented */
+static bool sha256_ce_present(void)
+{
+	u64 isar0;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return (isar0 >> 12) & 0xf;
+}
+
+int sha256_blocks_arch(uint32_t state[8], const uint8_t *data,
+		       unsigned int blocks)
+{
+	if (!sha256_ce_present())
+		return -ENOSYS;
+
+	sha256_ce_transform(state, data, blocks);
+
+	return 0;
+}
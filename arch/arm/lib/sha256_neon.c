@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA256 for ARMv7 CPUs with NEON, such as the Cortex-A9
+ *
+ * The message schedule is built with NEON by sha256_neon_schedule(), leaving
+ * only the rounds to be done here.
+ */
+
+#include <common.h>
+#include <asm/barriers.h>
+#include <u-boot/sha256.h>
+
+#define CPACR_CP10_CP11		(0xf << 20)	/* Full access to VFP/NEON */
+#define CPACR_ASEDIS		BIT(31)		/* Advanced SIMD disabled */
+#define FPEXC_EN		BIT(30)
+#define MVFR1_SIMD_LS		(0xf << 8)	/* Advanced SIMD load/store */
+#define MVFR1_SIMD_INT		(0xf << 12)	/* Advanced SIMD integer */
+
+void sha256_neon_schedule(uint32_t wk[64], const uint8_t *data);
+
+/*
+ * Check that the CPU has NEON and enable it, since U-Boot does not normally
+ * use the VFP/NEON unit. Access can also be denied from the secure side, in
+ * which case the CPACR bits cannot be set.
+ */
+static bool sha256_neon_enable(void)
+{
+	u32 cpacr, fpexc, mvfr1;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	if ((cpacr & (CPACR_CP10_CP11 | CPACR_ASEDIS)) != CPACR_CP10_CP11) {
+		cpacr = (cpacr & ~CPACR_ASEDIS) | CPACR_CP10_CP11;
+		asm volatile("mcr p15, 0, %0, c1, c0, 2" : : "r" (cpacr));
+		isb();
+		asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+		if ((cpacr & (CPACR_CP10_CP11 | CPACR_ASEDIS)) !=
+		    CPACR_CP10_CP11)
+			return false;
+	}
+
+	asm volatile(".fpu neon\n vmrs %0, mvfr1" : "=r" (mvfr1));
+	if (!(mvfr1 & MVFR1_SIMD_LS) || !(mvfr1 & MVFR1_SIMD_INT))
+		return false;
+
+	asm volatile(".fpu neon\n vmrs %0, fpexc" : "=r" (fpexc));
+	if (!(fpexc & FPEXC_EN))
+		asm volatile(".fpu neon\n vmsr fpexc, %0"
+			     : : "r" (fpexc | FPEXC_EN));
+
+	return true;
+}
+
+#define ROR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+#define ROUND(a, b, c, d, e, f, g, h, wk) do {				\
+	u32 t1, t2;							\
+									\
+	t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) +		\
+		(g ^ (e & (f ^ g))) + (wk);				\
+	t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) +			\
+		((a & b) | (c & (a | b)));				\
+	d += t1;							\
+	h = t1 + t2;							\
+} while (0)
+
+int sha256_blocks_arch(uint32_t state[8], const uint8_t *data,
+		       unsigned int blocks)
+{
+	u32 a, b, c, d, e, f, g, h;
+	u32 wk[64];
+	int t;
+
+	if (!sha256_neon_enable())
+		return -ENOSYS;
+
+	for (; blocks; blocks--, data += 64) {
+		sha256_neon_schedule(wk, data);
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (t = 0; t < 64; t += 8) {
+			ROUND(a, b, c, d, e, f, g, h, wk[t]);
+			ROUND(h, a, b, c, d, e, f, g, wk[t + 1]);
+			ROUND(g, h, a, b, c, d, e, f, wk[t + 2]);
+			ROUND(f, g, h, a, b, c, d, e, wk[t + 3]);
+			ROUND(e, f, g, h, a, b, c, d, wk[t + 4]);
+			ROUND(d, e, f, g, h, a, b, c, wk[t + 5]);
+			ROUND(c, d, e, f, g, h, a, b, wk[t + 6]);
+			ROUND(b, c, d, e, f, g, h, a, wk[t + 7]);
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running jobs on secondary CPUs, using host threads
+ */
+
+#include <common.h>
+#include <mp_job.h>
+#include <os.h>
+
+/* Pretend to have this many secondary CPUs */
+#define SANDBOX_MP_JOB_CPUS	3
+
+/* Host thread running each CPU's job */
+static void *sandbox_mp_job_thread[SANDBOX_MP_JOB_CPUS + 1];
+
+/* CPU which this host thread stands for, 0 for the main thread */
+static __thread int sandbox_mp_job_this_cpu;
+
+static void *sandbox_mp_job_run(void *arg)
+{
+	struct mp_job *job = arg;
+
+	sandbox_mp_job_this_cpu = job->cpu;
+	mp_job_run(job);
+
+	return NULL;
+}
+
+int arch_mp_job_cpu(void)
+{
+	return sandbox_mp_job_this_cpu;
+}
+
+int arch_mp_job_cpus(void)
+{
+	return SANDBOX_MP_JOB_CPUS;
+}
+
+int arch_mp_job_start(int cpu, struct mp_job *job)
+{
+	return os_thread_start(&sandbox_mp_job_thread[cpu], sandbox_mp_job_run,
+			       job);
+}
+
+void arch_mp_job_join(int cpu, struct mp_job *job)
+{
+	os_thread_join(sandbox_mp_job_thread[cpu]);
+	sandbox_mp_job_thread[cpu] = NULL;
+}
@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -98,6 +99,20 @@ void os_exit(int exit_code)
 	exit(exit_code);
 }
 
+int os_persistent_file(char *buf, int maxsize, const char *fname)
+{
+	const char *dirname = getenv("U_BOOT_PERSISTENT_DATA_DIR");
+
+	if (!dirname)
+		dirname = getenv("TMPDIR");
+	if (!dirname)
+		dirname = "/tmp";
+	if (snprintf(buf, maxsize, "%s/%s", dirname, fname) >= maxsize)
+		return -ENOSPC;
+
+	return 0;
+}
+
 int os_write_file(const char *fname, const void *buf, int size)
 {
 	int fd;
@@ -780,6 +795,28 @@ void os_abort(void)
 	abort();
 }
 
+int os_thread_start(void **threadp, void *(*func)(void *), void *arg)
+{
+	pthread_t *thread;
+
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	if (pthread_create(thread, NULL, func, arg)) {
+		os_free(thread);
+		return -EAGAIN;
+	}
+	*threadp = thread;
+
+	return 0;
+}
+
+void os_thread_join(void *thread)
+{
+	pthread_join(*(pthread_t *)thread, NULL);
+	os_free(thread);
+}
+
 int os_mprotect_allow(void *start, size_t len)
 {
 	int page_size = getpagesize();
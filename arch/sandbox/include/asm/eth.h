@@ -59,6 +59,32 @@ int sandbox_eth_recv_arp_req(struct udevice *dev);
  */
 int sandbox_eth_recv_ping_req(struct udevice *dev);
 
+/*
+ * sandbox_eth_recv_udp()
+ *
+ * Inject a UDP packet for this target
+ *
+ * @dev: device that received the packet
+ * @dport: destination port
+ * @sport: source port
+ * @len: number of bytes of data, at most PKTSIZE less the headers
+ * @return 0 if injected, -EOVERFLOW if not
+ */
+int sandbox_eth_recv_udp(struct udevice *dev, int dport, int sport, int len);
+
+/*
+ * sandbox_eth_tcp_req_to_reply()
+ *
+ * Act as an HTTP server for the file given to sandbox_eth_set_http(), if any
+ *
+ * @dev: device that received the packet
+ * @packet: pointer to the received packet buffer
+ * @len: length of received packet
+ * @return 0 if handled, -EAGAIN if not
+ */
+int sandbox_eth_tcp_req_to_reply(struct udevice *dev, void *packet,
+				 unsigned int len);
+
 /**
  * A packet handler
  *
@@ -75,11 +101,16 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * fake_host_hwaddr - MAC address of mocked machine
  * fake_host_ipaddr - IP address of mocked machine
  * disabled - Will not respond
- * recv_packet_buffer - buffers of the packet returned as received
- * recv_packet_length - lengths of the packet returned as received
- * recv_packets - number of packets returned
+ * recv_packet_buffer - ring of buffers of the packets returned as received
+ * recv_packet_length - lengths of the packets returned as received
+ * recv_head - index in the ring of the next packet to return
+ * recv_packets - number of packets waiting in the ring
  * tx_handler - function to generate responses to sent packets
  * priv - a pointer to some structure a test may want to keep track of
+ * http_body - file served by the fake HTTP server, NULL if none
+ * http_len - length of the file in bytes
+ * http_req - true once the HTTP server has received a request
+ * http_sent - number of bytes of the HTTP response sent so far
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
@@ -87,9 +118,14 @@ struct eth_sandbox_priv {
 	bool disabled;
 	uchar * recv_packet_buffer[PKTBUFSRX];
 	int recv_packet_length[PKTBUFSRX];
+	int recv_head;
 	int recv_packets;
 	sandbox_eth_tx_hand_f *tx_handler;
 	void *priv;
+	const uchar *http_body;
+	int http_len;
+	bool http_req;
+	int http_sent;
 };
 
 /*
@@ -106,4 +142,12 @@ void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
  */
 void sandbox_eth_set_priv(int index, void *priv);
 
+/*
+ * Serve a file over HTTP from the fake host
+ *
+ * body - contents of the file, or NULL to stop serving it
+ * len - length of the file in bytes
+ */
+void sandbox_eth_set_http(int index, const void *body, int len);
+
 #endif /* __ETH_H */
@@ -177,4 +177,13 @@ int sandbox_get_beep_frequency(struct udevice *dev);
  */
 int sandbox_get_pch_spi_protect(struct udevice *dev);
 
+/**
+ * sandbox_async_start_all() - Start probing all the sandbox delayed devices
+ *
+ * The probes return without waiting, so the devices become ready together.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int sandbox_async_start_all(void);
+
 #endif
@@ -53,7 +53,8 @@ int board_init(void)
 	if (IS_ENABLED(CONFIG_LED))
 		led_default_state();
 
-	return 0;
+	/* These finish probing while the rest of the board starts up */
+	return sandbox_async_start_all();
 }
 
 #ifdef CONFIG_BOARD_LATE_INIT
@@ -13,36 +13,87 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	struct blk_readahead_stats ra;
+#endif
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
 	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max blocks/read: %u\n"
+	       "max cache entries: %u\n"
+	       "size: %u KiB (%u sets x %u ways)\n",
+	       stats.hits, stats.misses, stats.evictions, stats.entries,
+	       stats.max_blocks_per_entry, stats.max_entries,
+	       stats.size_kb, stats.sets, stats.ways);
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	blk_readahead_stats(&ra);
+	printf("readahead: %u KiB\n"
+	       "  requests: %lu\n"
+	       "  device reads: %lu\n"
+	       "  hits: %lu\n"
+	       "  prefetched blocks: %lu\n",
+	       ra.size_kb, ra.requests, ra.dev_reads, ra.hits, ra.prefetched);
+#endif
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned max_blocks, max_entries;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
-	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
+	max_blocks = simple_strtoul(argv[1], 0, 0);
 	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
+	blkcache_configure(max_blocks, max_entries);
 	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	       max_entries, max_blocks);
+	return 0;
+}
+
+static int blkc_size(cmd_tbl_t *cmdtp, int flag,
+		     int argc, char * const argv[])
+{
+	struct block_cache_stats stats;
+	unsigned size_mb;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	blkcache_stats(&stats);
+	size_mb = simple_strtoul(argv[1], 0, 0);
+	blkcache_configure_size(stats.max_blocks_per_entry, size_mb);
+	printf("changed to %u MiB\n", size_mb);
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+static int blkc_readahead(cmd_tbl_t *cmdtp, int flag,
+			  int argc, char * const argv[])
+{
+	unsigned size_kb;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	size_kb = simple_strtoul(argv[1], 0, 0);
+	blk_readahead_configure(size_kb);
+	printf("changed read-ahead window to %u KiB\n", size_kb);
+	return 0;
+}
+#endif
+
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(size, 2, 0, blkc_size, "", ""),
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	U_BOOT_CMD_MKENT(readahead, 2, 0, blkc_readahead, "", ""),
+#endif
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -83,4 +134,8 @@ U_BOOT_CMD(
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
 	"blkcache configure blocks entries\n"
+	"blkcache size size_mb - set the size of the cache (0 to disable)\n"
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	"blkcache readahead size_kb - set the read-ahead window (0 to disable)\n"
+#endif
 );
@@ -40,6 +40,25 @@ U_BOOT_CMD(
 	"      If 'pos' is 0 or omitted, the file is read from the start."
 )
 
+#ifdef CONFIG_CMD_LOADZ
+static int do_loadz_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	return do_loadz(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	loadz,	6,	0,	do_loadz_wrapper,
+	"load and decompress a compressed file from a filesystem",
+	"<interface> [<dev[:part]> [<addr> [<filename> [maxsize]]]]\n"
+	"    - Load the gzip, lz4 or zstd compressed file 'filename' from\n"
+	"      partition 'part' on device type 'interface' instance 'dev',\n"
+	"      decompressing it to address 'addr' in memory while it is read.\n"
+	"      'maxsize' limits the decompressed size in bytes.\n"
+	"      The decompressed size is stored in 'filesize'."
+);
+#endif
+
 static int do_save_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
 				char * const argv[])
 {
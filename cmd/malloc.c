@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show statistics about malloc() use
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc_stats.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static void show_size(ulong size)
+{
+	if (size >= SZ_1M)
+		printf("%5luM", size / SZ_1M);
+	else if (size >= SZ_1K)
+		printf("%5luK", size / SZ_1K);
+	else
+		printf("%5lu ", size);
+}
+
+static int do_malloc_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	struct malloc_info info;
+	int i;
+
+	malloc_get_info(&info);
+	printf("Heap size:  %#lx\n", info.heap_size);
+	printf("In use:     %#lx bytes in %lu blocks\n", info.in_use,
+	       info.count);
+	printf("Peak:       %#lx bytes (%lu%% of heap)\n", info.peak,
+	       info.heap_size ? info.peak * 100 / info.heap_size : 0);
+	printf("Calls:      %lu allocations, %lu frees, %lu failed",
+	       info.allocs, info.frees, info.failures);
+	if (info.failures)
+		printf(" (largest %#lx bytes)", info.largest_failure);
+	printf("\n");
+	if (info.untracked)
+		printf("Untracked:  %lu allocations\n", info.untracked);
+
+	printf("\n  Size   In use    Total\n");
+	for (i = 0; i < MALLOC_STATS_BUCKETS; i++) {
+		if (!info.bucket_allocs[i])
+			continue;
+		if (malloc_stats_bucket_size(i)) {
+			printf("<=");
+			show_size(malloc_stats_bucket_size(i));
+		} else {
+			printf(" >");
+			show_size(malloc_stats_bucket_size(i - 1));
+		}
+		printf("  %7lu  %7lu\n", info.bucket_count[i],
+		       info.bucket_allocs[i]);
+	}
+
+	return 0;
+}
+
+static int do_malloc_reset(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	malloc_reset_peak();
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+/* Maximum number of callers to show for 'malloc leaks' */
+#define MALLOC_LEAKS_MAX	20
+
+/* Blocks allocated after this are reported by 'malloc leaks' */
+static ulong malloc_mark;
+
+static int do_malloc_mark(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	malloc_mark = malloc_leaks_mark();
+
+	return 0;
+}
+
+static int do_malloc_leaks(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	struct malloc_leak leaks[MALLOC_LEAKS_MAX];
+	ulong mark = malloc_mark;
+	ulong count;
+	int num, i;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "all"))
+			return CMD_RET_USAGE;
+		mark = 0;
+	}
+	num = malloc_get_leaks(mark, leaks, ARRAY_SIZE(leaks), &count);
+	printf("%lu blocks still allocated%s\n", count,
+	       mark ? " since mark" : "");
+	if (!num)
+		return 0;
+
+	printf("\n%-18s %-18s %7s %10s\n", "Caller", "Link address", "Blocks",
+	       "Bytes");
+	for (i = 0; i < num; i++) {
+		ulong caller = (ulong)leaks[i].caller;
+
+		printf("%-18lx %-18lx %7lu %10lu\n", caller,
+		       caller - gd->reloc_off, leaks[i].count, leaks[i].bytes);
+	}
+
+	return 0;
+}
+#endif
+
+static char malloc_help_text[] =
+	"stats - show heap usage, peak and block sizes\n"
+	"malloc reset - set the peak usage back to the current usage\n"
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+	"malloc mark - mark the current point for 'malloc leaks'\n"
+	"malloc leaks [all] - show blocks still allocated since the mark\n"
+	"    (or since boot), by caller\n"
+#endif
+	;
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc() statistics", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(stats, 1, 1, do_malloc_stats),
+	U_BOOT_SUBCMD_MKENT(reset, 1, 1, do_malloc_reset),
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+	U_BOOT_SUBCMD_MKENT(mark, 1, 1, do_malloc_mark),
+	U_BOOT_SUBCMD_MKENT(leaks, 2, 1, do_malloc_leaks),
+#endif
+	);
@@ -77,6 +77,35 @@ static int create_call_list(int argc, char * const argv[])
 	return 0;
 }
 
+static int create_bootstage_list(int argc, char * const argv[])
+{
+	size_t buff_size, avail, buff_ptr, used;
+	unsigned int needed;
+	char *buff;
+	int err;
+
+	if (get_args(argc, argv, &buff, &buff_ptr, &buff_size))
+		return -1;
+
+	avail = buff_size - buff_ptr;
+	err = bootstage_list_trace(buff + buff_ptr, avail, &needed);
+	if (err == -ENOSYS) {
+		printf("Bootstage is not enabled\n");
+		return 0;
+	}
+	if (err)
+		printf("Error: truncated (%#x bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Bootstage records dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
 int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -84,6 +113,10 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (!cmd)
 		return cmd_usage(cmdtp);
 	switch (*cmd) {
+	case 'b':
+		if (create_bootstage_list(argc, argv))
+			return cmd_usage(cmdtp);
+		break;
 	case 'p':
 		trace_set_enabled(0);
 		break;
@@ -116,5 +149,7 @@ U_BOOT_CMD(
 	"trace resume                       - resume tracing\n"
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
-		"- dump function call trace into buffer"
+		"- dump function call trace into buffer\n"
+	"trace bootstage [<addr> <size>]    "
+		"- dump bootstage marks and spans into buffer"
 );
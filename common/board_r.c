@@ -629,6 +629,14 @@ static int initr_bedbug(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+static int initr_dm_async(void)
+{
+	/* Let any devices still probing finish before the command line */
+	return device_async_wait_all();
+}
+#endif
+
 static int run_main_loop(void)
 {
 #ifdef CONFIG_SANDBOX
@@ -834,6 +842,9 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 #if defined(CONFIG_PRAM)
 	initr_mem,
+#endif
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+	initr_dm_async,
 #endif
 	run_main_loop,
 };
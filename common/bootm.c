@@ -13,6 +13,7 @@
 #include <lmb.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <mp_job.h>
 #include <asm/io.h>
 #include <linux/lzo.h>
 #include <lzma/LzmaTypes.h>
@@ -62,14 +63,22 @@ static void boot_start_lmb(bootm_headers_t *images)
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
 }
+
+/* Free any regions allocated by an earlier bootm */
+static void boot_free_lmb(bootm_headers_t *images)
+{
+	lmb_uninit(&images->lmb);
+}
 #else
 #define lmb_reserve(lmb, base, size)
 static inline void boot_start_lmb(bootm_headers_t *images) { }
+static inline void boot_free_lmb(bootm_headers_t *images) { }
 #endif
 
 static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
+	boot_free_lmb(&images);
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -352,32 +361,55 @@ static int handle_decomp_error(int comp_type, size_t uncomp_size,
 	return BOOTM_ERR_RESET;
 }
 
-int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
-		       void *load_buf, void *image_buf, ulong image_len,
-		       uint unc_len, ulong *load_end)
+/**
+ * struct bootm_decomp - an image to be decompressed by bootm_decomp_run()
+ *
+ * @comp:		Compression type (IH_COMP_...)
+ * @load:		Address to load the image to
+ * @image_start:	Address of the image data
+ * @load_buf:		Buffer to load the image to
+ * @image_buf:		Image data
+ * @image_len:		Length of the image data, updated to the number of
+ *			bytes loaded
+ * @unc_len:		Amount of space available for decompression
+ * @unimplemented:	Set if @comp is not supported
+ * @ret:		Error code from the decompressor, 0 if OK
+ */
+struct bootm_decomp {
+	int comp;
+	ulong load;
+	ulong image_start;
+	void *load_buf;
+	void *image_buf;
+	ulong image_len;
+	uint unc_len;
+	bool unimplemented;
+	int ret;
+};
+
+/*
+ * Load the image to the right place, decompressing if needed. This does not
+ * print anything itself, so that it can run on another CPU.
+ */
+static int bootm_decomp_run(struct bootm_decomp *dc)
 {
+	ulong image_len = dc->image_len;
+	uint unc_len = dc->unc_len;
 	int ret = 0;
 
-	*load_end = load;
-	print_decomp_msg(comp, type, load == image_start);
-
-	/*
-	 * Load the image to the right place, decompressing if needed. After
-	 * this, image_len will be set to the number of uncompressed bytes
-	 * loaded, ret will be non-zero on error.
-	 */
-	switch (comp) {
+	switch (dc->comp) {
 	case IH_COMP_NONE:
-		if (load == image_start)
+		if (dc->load == dc->image_start)
 			break;
 		if (image_len <= unc_len)
-			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
+			memmove_wd(dc->load_buf, dc->image_buf, image_len,
+				   CHUNKSZ);
 		else
 			ret = 1;
 		break;
 #ifdef CONFIG_GZIP
 	case IH_COMP_GZIP: {
-		ret = gunzip(load_buf, unc_len, image_buf, &image_len);
+		ret = gunzip(dc->load_buf, unc_len, dc->image_buf, &image_len);
 		break;
 	}
 #endif /* CONFIG_GZIP */
@@ -390,8 +422,8 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		 * use slower decompression algorithm which requires
 		 * at most 2300 KB of memory.
 		 */
-		ret = BZ2_bzBuffToBuffDecompress(load_buf, &size,
-			image_buf, image_len,
+		ret = BZ2_bzBuffToBuffDecompress(dc->load_buf, &size,
+			dc->image_buf, image_len,
 			CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
 		image_len = size;
 		break;
@@ -401,8 +433,8 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZMA: {
 		SizeT lzma_len = unc_len;
 
-		ret = lzmaBuffToBuffDecompress(load_buf, &lzma_len,
-					       image_buf, image_len);
+		ret = lzmaBuffToBuffDecompress(dc->load_buf, &lzma_len,
+					       dc->image_buf, image_len);
 		image_len = lzma_len;
 		break;
 	}
@@ -411,7 +443,8 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZO: {
 		size_t size = unc_len;
 
-		ret = lzop_decompress(image_buf, image_len, load_buf, &size);
+		ret = lzop_decompress(dc->image_buf, image_len, dc->load_buf,
+				      &size);
 		image_len = size;
 		break;
 	}
@@ -420,26 +453,199 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZ4: {
 		size_t size = unc_len;
 
-		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		ret = ulz4fn(dc->image_buf, image_len, dc->load_buf, &size);
 		image_len = size;
 		break;
 	}
 #endif /* CONFIG_LZ4 */
 	default:
-		printf("Unimplemented compression type %d\n", comp);
-		return BOOTM_ERR_UNIMPLEMENTED;
+		dc->unimplemented = true;
+		return 0;
 	}
 
-	if (ret)
-		return handle_decomp_error(comp, image_len, unc_len, ret);
-	*load_end = load + image_len;
+	dc->image_len = image_len;
+	dc->ret = ret;
+
+	return ret;
+}
+
+/* Report the result of bootm_decomp_run() as bootm_decomp_image() does */
+static int bootm_decomp_finish(struct bootm_decomp *dc, ulong *load_end)
+{
+	*load_end = dc->load;
+	if (dc->unimplemented) {
+		printf("Unimplemented compression type %d\n", dc->comp);
+		return BOOTM_ERR_UNIMPLEMENTED;
+	}
+	if (dc->ret)
+		return handle_decomp_error(dc->comp, dc->image_len,
+					   dc->unc_len, dc->ret);
+	*load_end = dc->load + dc->image_len;
 
 	puts("OK\n");
 
 	return 0;
 }
 
+int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
+		       void *load_buf, void *image_buf, ulong image_len,
+		       uint unc_len, ulong *load_end)
+{
+	struct bootm_decomp dc = {
+		.comp = comp,
+		.load = load,
+		.image_start = image_start,
+		.load_buf = load_buf,
+		.image_buf = image_buf,
+		.image_len = image_len,
+		.unc_len = unc_len,
+	};
+
+	print_decomp_msg(comp, type, load == image_start);
+	bootm_decomp_run(&dc);
+
+	return bootm_decomp_finish(&dc, load_end);
+}
+
 #ifndef USE_HOSTCC
+#if CONFIG_IS_ENABLED(MP_JOB) && IMAGE_ENABLE_FIT
+/*
+ * The OS image, decompressed on another CPU while the ramdisk and device
+ * tree are found
+ */
+static struct bootm_decomp_job {
+	struct mp_job job;
+	struct bootm_decomp dc;
+	bool started;
+} bootm_os_decomp;
+
+static int bootm_decomp_job(void *arg)
+{
+	return bootm_decomp_run(arg);
+}
+
+static bool bootm_overlaps(ulong start, ulong len, ulong other,
+			   ulong other_len)
+{
+	return len && other_len && start < other + other_len &&
+		other < start + len;
+}
+
+/**
+ * bootm_start_decomp() - Start decompressing the OS image on another CPU
+ *
+ * This is only done for a FIT, and only if nothing else which bootm loads
+ * can be copied into place while the job runs. A ramdisk or device tree
+ * which ends up where the job read or wrote is dealt with by
+ * bootm_decomp_os().
+ *
+ * @images: Images found by bootm_find_os()
+ */
+static void bootm_start_decomp(bootm_headers_t *images)
+{
+	struct bootm_decomp_job *dj = &bootm_os_decomp;
+	image_info_t *os = &images->os;
+	const void *fit = images->fit_hdr_os;
+	int cfg_noffset;
+
+	if (!fit || os->comp == IH_COMP_NONE || !mp_job_cpus())
+		return;
+
+	/* The rest of the FIT is still needed */
+	if (bootm_overlaps(os->load, CONFIG_SYS_BOOTM_LEN, os->start,
+			   os->end - os->start))
+		return;
+
+	cfg_noffset = fit_conf_get_node(fit, images->fit_uname_cfg);
+	if (cfg_noffset < 0 ||
+	    fdt_getprop(fit, cfg_noffset, FIT_LOADABLE_PROP, NULL) ||
+	    fdt_getprop(fit, cfg_noffset, FIT_FPGA_PROP, NULL))
+		return;
+
+	memset(&dj->dc, '\0', sizeof(dj->dc));
+	dj->dc.comp = os->comp;
+	dj->dc.load = os->load;
+	dj->dc.image_start = os->image_start;
+	dj->dc.load_buf = map_sysmem(os->load, 0);
+	dj->dc.image_buf = map_sysmem(os->image_start, os->image_len);
+	dj->dc.image_len = os->image_len;
+	dj->dc.unc_len = CONFIG_SYS_BOOTM_LEN;
+	mp_job_start(&dj->job, bootm_decomp_job, &dj->dc);
+	dj->started = true;
+}
+
+/* Wait for a decompression which is no longer needed */
+static void bootm_stop_decomp(void)
+{
+	struct bootm_decomp_job *dj = &bootm_os_decomp;
+
+	if (dj->started) {
+		mp_job_join(&dj->job);
+		dj->started = false;
+	}
+}
+
+/* Check whether the ramdisk or device tree was put where the job was busy */
+static bool bootm_decomp_clobbered(bootm_headers_t *images,
+				   struct bootm_decomp *dc)
+{
+	ulong written = dc->ret ? dc->unc_len : dc->image_len;
+	ulong rd_len = images->rd_end - images->rd_start;
+	ulong ft_start = map_to_sysmem(images->ft_addr);
+
+	return bootm_overlaps(dc->load, written, images->rd_start, rd_len) ||
+		bootm_overlaps(dc->load, written, ft_start, images->ft_len) ||
+		bootm_overlaps(dc->image_start, images->os.image_len,
+			       images->rd_start, rd_len) ||
+		bootm_overlaps(dc->image_start, images->os.image_len,
+			       ft_start, images->ft_len);
+}
+
+/*
+ * Decompress the OS image, or collect the result of bootm_start_decomp().
+ * The image is decompressed again here if the job may not have had the
+ * same result as doing it now.
+ */
+static int bootm_decomp_os(bootm_headers_t *images, void *load_buf,
+			   void *image_buf, ulong *load_end)
+{
+	struct bootm_decomp_job *dj = &bootm_os_decomp;
+	image_info_t *os = &images->os;
+
+	if (dj->started) {
+		bootm_stop_decomp();
+		if (!bootm_decomp_clobbered(images, &dj->dc)) {
+			print_decomp_msg(os->comp, os->type, false);
+			return bootm_decomp_finish(&dj->dc, load_end);
+		}
+		debug("%s: Ramdisk or FDT overlaps OS image, decompressing again\n",
+		      __func__);
+	}
+
+	return bootm_decomp_image(os->comp, os->load, os->image_start,
+				  os->type, load_buf, image_buf, os->image_len,
+				  CONFIG_SYS_BOOTM_LEN, load_end);
+}
+#else
+static inline void bootm_start_decomp(bootm_headers_t *images)
+{
+}
+
+static inline void bootm_stop_decomp(void)
+{
+}
+
+static int bootm_decomp_os(bootm_headers_t *images, void *load_buf,
+			   void *image_buf, ulong *load_end)
+{
+	image_info_t *os = &images->os;
+
+	return bootm_decomp_image(os->comp, os->load, os->image_start,
+				  os->type, load_buf, image_buf, os->image_len,
+				  CONFIG_SYS_BOOTM_LEN, load_end);
+}
+#endif
+
 static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 {
 	image_info_t os = images->os;
@@ -456,9 +662,7 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
-	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
-				 load_buf, image_buf, image_len,
-				 CONFIG_SYS_BOOTM_LEN, &load_end);
+	err = bootm_decomp_os(images, load_buf, image_buf, &load_end);
 	if (err) {
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
@@ -635,11 +839,17 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (states & BOOTM_STATE_START)
 		ret = bootm_start(cmdtp, flag, argc, argv);
 
-	if (!ret && (states & BOOTM_STATE_FINDOS))
+	if (!ret && (states & BOOTM_STATE_FINDOS)) {
 		ret = bootm_find_os(cmdtp, flag, argc, argv);
+		/* Decompress the OS image while looking for the others */
+		if (!ret && (states & BOOTM_STATE_LOADOS))
+			bootm_start_decomp(images);
+	}
 
 	if (!ret && (states & BOOTM_STATE_FINDOTHER))
 		ret = bootm_find_other(cmdtp, flag, argc, argv);
+	if (ret)
+		bootm_stop_decomp();
 
 	/* Load the OS */
 	if (!ret && (states & BOOTM_STATE_LOADOS)) {
@@ -12,25 +12,44 @@
 #include <common.h>
 #include <linux/libfdt.h>
 #include <malloc.h>
+#include <trace.h>
 #include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#ifdef CONFIG_BOOTSTAGE_SPAN_COUNT
+#define SPAN_COUNT	CONFIG_BOOTSTAGE_SPAN_COUNT
+#else
+#define SPAN_COUNT	0
+#endif
+
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
 };
 
+/*
+ * A span (BOOTSTAGEF_SPAN) uses start_us for its start time and time_us for
+ * its duration, as an accumulator does, and also records how deeply it is
+ * nested within other spans. Spans are kept apart from the other records,
+ * in a table which is only allocated after relocation, so that they neither
+ * use the pre-relocation malloc() area nor crowd out later boot stages.
+ */
 struct bootstage_record {
 	ulong time_us;
 	uint32_t start_us;
 	const char *name;
 	int flags;		/* see enum bootstage_flags */
 	enum bootstage_id id;
+	uint depth;		/* Nesting depth of a span, 0 if outermost */
 };
 
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
+	uint span_depth;	/* Number of spans currently open */
+	uint span_count;	/* Number of spans in @span */
+	uint span_dropped;	/* Number of spans not recorded as @span is full */
+	struct bootstage_record *span;	/* SPAN_COUNT spans, or NULL */
 	struct bootstage_record record[RECORD_COUNT];
 };
 
@@ -202,6 +221,74 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+int bootstage_span_begin(const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data)
+		return -ENODEV;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -EAGAIN;
+	if (!data->span) {
+		data->span = calloc(SPAN_COUNT, sizeof(*data->span));
+		if (!data->span)
+			return -ENOMEM;
+	}
+	if (data->span_count >= SPAN_COUNT) {
+		data->span_dropped++;
+		return -ENOSPC;
+	}
+
+	rec = &data->span[data->span_count++];
+	rec->id = data->next_id++;
+	rec->name = strdup(name);
+	if (!rec->name)
+		rec->name = name;
+	rec->flags = BOOTSTAGEF_SPAN;
+	rec->depth = data->span_depth++;
+	rec->time_us = 0;
+	rec->start_us = timer_get_boot_us();
+
+	return rec->id;
+}
+
+uint32_t bootstage_span_end(int span)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data || !data->span || span < 0)
+		return 0;
+
+	/* Look from the end, since the span is most likely a recent one */
+	for (rec = data->span + data->span_count - 1; rec >= data->span;
+	     rec--) {
+		if (rec->id == span)
+			break;
+	}
+	if (rec < data->span)
+		return 0;
+
+	/* Any spans begun inside this one and not ended are closed too */
+	data->span_depth = rec->depth;
+	rec->time_us = (uint32_t)timer_get_boot_us() - rec->start_us;
+
+	return rec->time_us;
+}
+
+uint32_t bootstage_add_span(const char *name, uint32_t start_us)
+{
+	int span;
+
+	span = bootstage_span_begin(name);
+	if (span < 0)
+		return 0;
+	gd->bootstage->span[gd->bootstage->span_count - 1].start_us = start_us;
+
+	return bootstage_span_end(span);
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -239,11 +326,17 @@ static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 	return rec->time_us;
 }
 
+/* Get the time a record was made, which for a span is its start time */
+static ulong record_time(const struct bootstage_record *rec)
+{
+	return rec->flags & BOOTSTAGEF_SPAN ? rec->start_us : rec->time_us;
+}
+
 static int h_compare_record(const void *r1, const void *r2)
 {
 	const struct bootstage_record *rec1 = r1, *rec2 = r2;
 
-	return rec1->time_us > rec2->time_us ? 1 : -1;
+	return record_time(rec1) > record_time(rec2) ? 1 : -1;
 }
 
 #ifdef CONFIG_OF_LIBFDT
@@ -292,7 +385,10 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				       get_record_name(buf, sizeof(buf), rec)))
 			return -EINVAL;
 
-		/* Check if this is a 'mark' or 'accum' record */
+		/*
+		 * Check if this is a 'mark' or 'accum' record. A span is
+		 * recorded with its duration, like an accumulator.
+		 */
 		if (fdt_setprop_cell(blob, node,
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
@@ -315,6 +411,7 @@ void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
 	struct bootstage_record *rec = data->record;
+	bool span_header = false;
 	uint32_t prev;
 	int i;
 
@@ -328,7 +425,7 @@ void bootstage_report(void)
 	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
 
 	for (i = 1, rec++; i < data->rec_count; i++, rec++) {
-		if (rec->id && !rec->start_us)
+		if (rec->id && !rec->start_us && !(rec->flags & BOOTSTAGEF_SPAN))
 			prev = print_time_record(rec, prev);
 	}
 	if (data->rec_count > RECORD_COUNT)
@@ -338,9 +435,87 @@ void bootstage_report(void)
 
 	puts("\nAccumulated time:\n");
 	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
-		if (rec->start_us)
+		if (rec->start_us && !(rec->flags & BOOTSTAGEF_SPAN))
 			prev = print_time_record(rec, -1);
 	}
+
+	if (!data->span_count)
+		return;
+
+	/* Sorted by start time, nested spans follow their parent */
+	qsort(data->span, data->span_count, sizeof(*rec), h_compare_record);
+	for (i = 0, rec = data->span; i < data->span_count; i++, rec++) {
+		if (!span_header) {
+			printf("\nSpans:\n%11s%11s  %s\n", "Start", "Duration",
+			       "Name");
+			span_header = true;
+		}
+		print_grouped_ull(rec->start_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
+		printf("  %*s%s\n", rec->depth * 2, "", rec->name);
+	}
+	if (data->span_dropped)
+		printf("Dropped %d spans\n"
+		       "Please increase CONFIG_BOOTSTAGE_SPAN_COUNT\n",
+		       data->span_dropped);
+}
+
+int bootstage_list_trace(void *buff, int buff_size, unsigned int *needed)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct trace_output_hdr *output_hdr = NULL;
+	const struct bootstage_record *rec;
+	void *end, *ptr = buff;
+	char buf[20];
+	int i, upto;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) <= end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	for (i = upto = 0; i < data->rec_count + data->span_count; i++) {
+		struct trace_output_span *out = ptr;
+
+		if (i < data->rec_count)
+			rec = &data->record[i];
+		else
+			rec = &data->span[i - data->rec_count];
+
+		/* An accumulator has no single place in the timeline */
+		if (rec->start_us && !(rec->flags & BOOTSTAGEF_SPAN))
+			continue;
+		if (ptr + sizeof(*out) <= end) {
+			memset(out, '\0', sizeof(*out));
+			if (rec->flags & BOOTSTAGEF_SPAN) {
+				out->start_us = rec->start_us;
+				out->duration_us = rec->time_us;
+				out->depth = rec->depth;
+			} else {
+				out->start_us = rec->time_us;
+				out->flags = TRACE_SPANF_MARK;
+			}
+			strlcpy(out->name,
+				get_record_name(buf, sizeof(buf), rec),
+				sizeof(out->name));
+			upto++;
+		}
+		ptr += sizeof(*out);
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_BOOTSTAGE;
+	}
+
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
 }
 
 /**
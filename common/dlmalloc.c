@@ -5,8 +5,45 @@
 #endif
 
 #include <malloc.h>
+#include <malloc_stats.h>
+#include <mp_job.h>
 #include <asm/io.h>
 
+#if CONFIG_IS_ENABLED(MALLOC_STATS) || CONFIG_IS_ENABLED(MP_JOB)
+#define MALLOC_WRAPPERS
+#endif
+
+#ifdef MALLOC_WRAPPERS
+/*
+ * malloc() and friends are wrappers at the end of this file, which keep
+ * statistics and take a lock, since jobs on secondary CPUs may allocate
+ * memory. Rename the allocator's own functions, which call each other, so
+ * that each request is only counted once.
+ */
+#undef mALLOc
+#undef fREe
+#undef rEALLOc
+#undef mEMALIGn
+#undef cALLOc
+#undef vALLOc
+#undef pvALLOc
+#define mALLOc		dlmalloc
+#define fREe		dlfree
+#define rEALLOc		dlrealloc
+#define mEMALIGn	dlmemalign
+#define cALLOc		dlcalloc
+#define vALLOc		dlvalloc
+#define pvALLOc		dlpvalloc
+
+Void_t *mALLOc(size_t);
+void fREe(Void_t *);
+Void_t *rEALLOc(Void_t *, size_t);
+Void_t *mEMALIGn(size_t, size_t);
+Void_t *cALLOc(size_t, size_t);
+Void_t *vALLOc(size_t);
+Void_t *pvALLOc(size_t);
+#endif
+
 #ifdef DEBUG
 #if __STD_C
 static void malloc_update_mallinfo (void);
@@ -2130,7 +2167,7 @@ void cfree(Void_t *mem)
 void cfree(mem) Void_t *mem;
 #endif
 {
-  fREe(mem);
+  free(mem);
 }
 #endif
 
@@ -2383,6 +2420,109 @@ int mALLOPt(param_number, value) int param_number; int value;
   }
 }
 
+#ifdef MALLOC_WRAPPERS
+/* Only taken once the full malloc() is running, when BSS is available */
+static struct mp_lock malloc_lock;
+
+static void malloc_take_lock(void)
+{
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT)
+		mp_lock(&malloc_lock);
+}
+
+static void malloc_release_lock(void)
+{
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT)
+		mp_unlock(&malloc_lock);
+}
+
+/* Record a block returned by the allocator, or a failure, and unlock */
+static Void_t *malloc_done(Void_t *mem, size_t bytes, void *caller)
+{
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		if (mem)
+			malloc_stats_alloc(mem, malloc_usable_size(mem),
+					   caller);
+		else
+			malloc_stats_fail(bytes);
+	}
+#endif
+	malloc_release_lock();
+
+	return mem;
+}
+
+Void_t *malloc(size_t bytes)
+{
+	malloc_take_lock();
+	return malloc_done(mALLOc(bytes), bytes, __builtin_return_address(0));
+}
+
+Void_t *calloc(size_t n, size_t elem_size)
+{
+	malloc_take_lock();
+	return malloc_done(cALLOc(n, elem_size), n * elem_size,
+			   __builtin_return_address(0));
+}
+
+Void_t *memalign(size_t alignment, size_t bytes)
+{
+	malloc_take_lock();
+	return malloc_done(mEMALIGn(alignment, bytes), bytes,
+			   __builtin_return_address(0));
+}
+
+Void_t *valloc(size_t bytes)
+{
+	malloc_take_lock();
+	return malloc_done(vALLOc(bytes), bytes, __builtin_return_address(0));
+}
+
+Void_t *pvalloc(size_t bytes)
+{
+	malloc_take_lock();
+	return malloc_done(pvALLOc(bytes), bytes, __builtin_return_address(0));
+}
+
+void free(Void_t *mem)
+{
+	malloc_take_lock();
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+	if (mem && (gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		malloc_stats_free(mem, malloc_usable_size(mem));
+#endif
+	fREe(mem);
+	malloc_release_lock();
+}
+
+Void_t *realloc(Void_t *oldmem, size_t bytes)
+{
+	Void_t *mem;
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+	size_t oldsize = 0;
+#endif
+
+	malloc_take_lock();
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+	if (oldmem && (gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		oldsize = malloc_usable_size(oldmem);
+#endif
+	mem = rEALLOc(oldmem, bytes);
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+	/* On failure the old block is still allocated */
+	if (mem && oldsize)
+		malloc_stats_free(oldmem, oldsize);
+#endif
+	if (!mem && !bytes) {
+		malloc_release_lock();
+		return NULL;
+	}
+
+	return malloc_done(mem, bytes, __builtin_return_address(0));
+}
+#endif
+
 int initf_malloc(void)
 {
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
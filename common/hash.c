@@ -15,6 +15,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <hw_sha.h>
+#include <watchdog.h>
 #include <asm/io.h>
 #include <linux/errno.h>
 #else
@@ -133,7 +134,8 @@ static int hash_finish_crc32(struct hash_algo *algo, void *ctx, void *dest_buf,
 	if (size < algo->digest_size)
 		return -1;
 
-	*((uint32_t *)dest_buf) = *((uint32_t *)ctx);
+	/* Big-endian, like crc32_wd_buf() */
+	*((uint32_t *)dest_buf) = cpu_to_be32(*((uint32_t *)ctx));
 	free(ctx);
 	return 0;
 }
@@ -247,6 +249,76 @@ int hash_progressive_lookup_algo(const char *algo_name,
 	return -EPROTONOSUPPORT;
 }
 
+int hash_block_multi(const char *const algo_names[], int count,
+		     const void *data, unsigned int len,
+		     uint8_t *const outputs[], int output_sizes[])
+{
+	struct hash_algo *algo[HASH_MULTI_MAX];
+	void *ctx[HASH_MULTI_MAX];
+	unsigned int done, size;
+	int ret, i;
+
+	if (count > HASH_MULTI_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		ret = hash_progressive_lookup_algo(algo_names[i], &algo[i]);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = algo[i]->hash_init(algo[i], &ctx[i]);
+		if (ret)
+			goto err;
+	}
+
+	/*
+	 * Pass each chunk to every algorithm while it is still in the cache,
+	 * rather than reading all of the data once per algorithm
+	 */
+	for (done = 0; done < len; done += size) {
+		size = len - done;
+		if (size > HASH_MULTI_CHUNK)
+			size = HASH_MULTI_CHUNK;
+		for (i = 0; i < count; i++) {
+			ret = algo[i]->hash_update(algo[i], ctx[i], data + done,
+						   size, done + size == len);
+			if (ret) {
+				/* hash_update() has freed this context */
+				ctx[i] = NULL;
+				i = count;
+				goto err;
+			}
+		}
+#ifndef USE_HOSTCC
+		WATCHDOG_RESET();
+#endif
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = algo[i]->hash_finish(algo[i], ctx[i], outputs[i],
+					   HASH_MAX_DIGEST_SIZE);
+		/* hash_finish() frees the context */
+		ctx[i] = NULL;
+		if (ret) {
+			i = count;
+			goto err;
+		}
+		if (output_sizes)
+			output_sizes[i] = algo[i]->digest_size;
+	}
+
+	return 0;
+
+err:
+	/* Free the contexts which were set up but not finished */
+	while (i--)
+		free(ctx[i]);
+
+	return ret;
+}
+
 #ifndef USE_HOSTCC
 int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 {
@@ -412,6 +484,62 @@ static void hash_show(struct hash_algo *algo, ulong addr, ulong len, uint8_t *ou
 		printf("%02x", output[i]);
 }
 
+/**
+ * hash_command_multi() - Hash a memory region with several algorithms
+ *
+ * The data is read only once, see hash_block_multi().
+ *
+ * @algo_list:	Comma-separated list of algorithms, e.g. "sha1,crc32"
+ * @addr:	Address of data to hash
+ * @len:	Length of data in bytes
+ * @return 0 if ok, CMD_RET_USAGE if the list is not valid, 1 on other error
+ */
+static int hash_command_multi(const char *algo_list, ulong addr, ulong len)
+{
+	char list[HASH_MULTI_MAX * 16];
+	const char *names[HASH_MULTI_MAX];
+	uint8_t sum[HASH_MULTI_MAX][HASH_MAX_DIGEST_SIZE];
+	uint8_t *outputs[HASH_MULTI_MAX];
+	struct hash_algo *algo;
+	char *s, *name;
+	int count = 0;
+	void *buf;
+	int i, ret;
+
+	if (strlen(algo_list) >= sizeof(list))
+		return CMD_RET_USAGE;
+	strcpy(list, algo_list);
+	for (s = list; (name = strsep(&s, ",")); ) {
+		if (count == HASH_MULTI_MAX) {
+			printf("At most %d hash algorithms are supported\n",
+			       HASH_MULTI_MAX);
+			return CMD_RET_USAGE;
+		}
+		if (hash_progressive_lookup_algo(name, &algo)) {
+			printf("Unknown hash algorithm '%s'\n", name);
+			return CMD_RET_USAGE;
+		}
+		outputs[count] = sum[count];
+		names[count++] = name;
+	}
+
+	buf = map_sysmem(addr, len);
+	ret = hash_block_multi(names, count, buf, len, outputs, NULL);
+	unmap_sysmem(buf);
+	if (ret) {
+		printf("Hashing failed (err=%d)\n", ret);
+		return 1;
+	}
+
+	for (i = 0; i < count; i++) {
+		hash_progressive_lookup_algo(names[i], &algo);
+		hash_show(algo, addr, len, sum[i]);
+		printf("\n");
+	}
+
+	return 0;
+}
+
 int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		 int argc, char * const argv[])
 {
@@ -423,7 +551,13 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 	addr = simple_strtoul(*argv++, NULL, 16);
 	len = simple_strtoul(*argv++, NULL, 16);
 
-	if (multi_hash()) {
+	if (multi_hash() && strchr(algo_name, ',')) {
+		/* Verifying or storing several digests is not supported */
+		if ((flags & HASH_FLAG_VERIFY) || argc > 2)
+			return CMD_RET_USAGE;
+
+		return hash_command_multi(algo_name, addr, len);
+	} else if (multi_hash()) {
 		struct hash_algo *algo;
 		u8 *output;
 		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
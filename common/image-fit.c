@@ -19,6 +19,7 @@
 #include <mapmem.h>
 #include <asm/io.h>
 #include <malloc.h>
+#include <mp_job.h>
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
@@ -1158,15 +1159,92 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+/* Hash values computed up front by fit_image_hash_all() */
+struct fit_hash_values {
+	int count;
+	int noffset[HASH_MULTI_MAX];
+	uint8_t value[HASH_MULTI_MAX][FIT_MAX_HASH_LEN];
+	int value_len[HASH_MULTI_MAX];
+};
+
+/* Check that calculate_hash() would accept an algorithm in this build */
+static bool fit_hash_algo_enabled(const char *algo)
+{
+	return (IMAGE_ENABLE_CRC32 && !strcmp(algo, "crc32")) ||
+		(IMAGE_ENABLE_SHA1 && !strcmp(algo, "sha1")) ||
+		(IMAGE_ENABLE_SHA256 && !strcmp(algo, "sha256"));
+}
+
+/**
+ * fit_image_hash_all - calculate the hashes of an image in one pass
+ * @fit: pointer to the FIT format image header
+ * @image_noffset: component image node offset
+ * @data: image data
+ * @size: image data size
+ * @hv: returns the calculated hash values
+ * @min_count: least number of hashes worth calculating here
+ *
+ * When an image has several hash nodes, e.g. a crc32 and a sha256, reading
+ * a large image once per hash node is slow. This calculates all of them with
+ * hash_block_multi() instead, which reads the data only once. Hash nodes
+ * which are ignored, or use an algorithm without progressive hashing support,
+ * are left for fit_image_check_hash() to calculate as before.
+ *
+ * Nothing is calculated unless there are at least @min_count hashes to
+ * calculate. This is normally 2, but a single hash is worth calculating
+ * here when it is done on another CPU.
+ */
+static void fit_image_hash_all(const void *fit, int image_noffset,
+			       const void *data, size_t size,
+			       struct fit_hash_values *hv, int min_count)
+{
+	const char *algos[HASH_MULTI_MAX];
+	uint8_t *outputs[HASH_MULTI_MAX];
+	struct hash_algo *hash;
+	int noffset, ignore;
+	char *algo;
+
+	hv->count = 0;
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    !fit_hash_algo_enabled(algo) ||
+		    hash_progressive_lookup_algo(algo, &hash))
+			continue;
+		if (IMAGE_ENABLE_IGNORE) {
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+			if (ignore)
+				continue;
+		}
+		if (hv->count == HASH_MULTI_MAX)
+			break;
+		algos[hv->count] = algo;
+		outputs[hv->count] = hv->value[hv->count];
+		hv->noffset[hv->count++] = noffset;
+	}
+
+	if (hv->count < min_count ||
+	    hash_block_multi(algos, hv->count, data, size, outputs,
+			     hv->value_len))
+		hv->count = 0;
+}
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, struct fit_hash_values *hv,
+				char **err_msgp)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
+	uint8_t *calc = value;
 	int value_len;
 	char *algo;
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int i;
 
 	*err_msgp = NULL;
 
@@ -1190,7 +1268,12 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	for (i = 0; i < hv->count && hv->noffset[i] != noffset; i++)
+		;
+	if (i < hv->count) {
+		calc = hv->value[i];
+		value_len = hv->value_len[i];
+	} else if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1198,7 +1281,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	if (value_len != fit_value_len) {
 		*err_msgp = "Bad hash value len";
 		return -1;
-	} else if (memcmp(value, fit_value, value_len) != 0) {
+	} else if (memcmp(calc, fit_value, value_len) != 0) {
 		*err_msgp = "Bad hash value";
 		return -1;
 	}
@@ -1206,11 +1289,17 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *data, size_t size)
+/*
+ * Verify an image as fit_image_verify_with_data() does. If @hv is not NULL,
+ * it holds hashes of the image which have already been calculated.
+ */
+static int fit_image_verify_hashed(const void *fit, int image_noffset,
+				   const void *data, size_t size,
+				   struct fit_hash_values *hv)
 {
 	int		noffset = 0;
 	char		*err_msg = "";
+	struct fit_hash_values local_hv;
 	int verify_all = 1;
 	int ret;
 
@@ -1222,6 +1311,14 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		goto error;
 	}
 
+	if (!hv) {
+		hv = &local_hv;
+		hv->count = 0;
+		if (IMAGE_ENABLE_ONE_PASS_HASH)
+			fit_image_hash_all(fit, image_noffset, data, size, hv,
+					   2);
+	}
+
 	/* Process all hash subnodes of the component image node */
 	fdt_for_each_subnode(noffset, fit, image_noffset) {
 		const char *name = fit_get_name(fit, noffset, NULL);
@@ -1234,7 +1331,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			if (fit_image_check_hash(fit, noffset, data, size,
-						 &err_msg))
+						 hv, &err_msg))
 				goto error;
 			puts("+ ");
 		} else if (IMAGE_ENABLE_VERIFY && verify_all &&
@@ -1270,6 +1367,12 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *data, size_t size)
+{
+	return fit_image_verify_hashed(fit, image_noffset, data, size, NULL);
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1302,12 +1405,127 @@ int fit_image_verify(const void *fit, int image_noffset)
 	return fit_image_verify_with_data(fit, image_noffset, data, size);
 }
 
+#if IMAGE_ENABLE_MP_VERIFY
+/* The hashes of one image, calculated by a job on another CPU */
+struct fit_hash_job {
+	struct mp_job job;
+	const void *fit;
+	int noffset;
+	const void *data;
+	size_t size;
+	bool started;
+	struct fit_hash_values hv;
+};
+
+static int fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *hj = arg;
+
+	fit_image_hash_all(hj->fit, hj->noffset, hj->data, hj->size, &hj->hv,
+			   1);
+
+	return 0;
+}
+
+/*
+ * Start a job to calculate the hashes of each image, so that they are
+ * ready by the time fit_all_image_verify() comes to check them. Returns
+ * NULL, and nothing is started, if there are no other CPUs to use.
+ */
+static struct fit_hash_job *fit_hash_jobs_start(const void *fit,
+						int images_noffset)
+{
+	struct fit_hash_job *jobs, *hj;
+	int noffset;
+	int count = 0;
+
+	if (!mp_job_cpus())
+		return NULL;
+
+	fdt_for_each_subnode(noffset, fit, images_noffset)
+		count++;
+	jobs = calloc(count + 1, sizeof(*jobs));
+	if (!jobs)
+		return NULL;
+
+	hj = jobs;
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		if (hj == jobs + count)
+			break;
+		hj->fit = fit;
+		hj->noffset = noffset;
+		if (!fit_image_get_data_and_size(fit, noffset, &hj->data,
+						 &hj->size)) {
+			mp_job_start(&hj->job, fit_hash_job_run, hj);
+			hj->started = true;
+		}
+		hj++;
+	}
+	/* The last entry is left empty to mark the end */
+	hj->noffset = -1;
+
+	return jobs;
+}
+
+static int fit_hash_job_verify(struct fit_hash_job *jobs, int count,
+			       const void *fit, int noffset)
+{
+	struct fit_hash_job *hj;
+
+	if (!jobs)
+		return fit_image_verify(fit, noffset);
+
+	/* Use the job only if the tree agrees with what it was given */
+	hj = &jobs[count];
+	if (hj->noffset != noffset || !hj->started)
+		return fit_image_verify(fit, noffset);
+	mp_job_join(&hj->job);
+
+	return fit_image_verify_hashed(fit, noffset, hj->data, hj->size,
+				       &hj->hv);
+}
+
+/* Wait for any jobs which have not been checked, and free them all */
+static void fit_hash_jobs_finish(struct fit_hash_job *jobs)
+{
+	struct fit_hash_job *hj;
+
+	if (!jobs)
+		return;
+	for (hj = jobs; hj->noffset >= 0; hj++) {
+		if (hj->started)
+			mp_job_join(&hj->job);
+	}
+	free(jobs);
+}
+#else
+struct fit_hash_job;
+
+static inline struct fit_hash_job *fit_hash_jobs_start(const void *fit,
+						       int images_noffset)
+{
+	return NULL;
+}
+
+static inline int fit_hash_job_verify(struct fit_hash_job *jobs, int count,
+				      const void *fit, int noffset)
+{
+	return fit_image_verify(fit, noffset);
+}
+
+static inline void fit_hash_jobs_finish(struct fit_hash_job *jobs)
+{
+}
+#endif
+
 /**
  * fit_all_image_verify - verify data integrity for all images
  * @fit: pointer to the FIT format image header
  *
  * fit_all_image_verify() goes over all images in the FIT and
- * for every images checks if all it's hashes are valid.
+ * for every images checks if all it's hashes are valid. With
+ * CONFIG_MP_JOB, the hashes of each image are calculated on other CPUs
+ * while earlier images are checked.
  *
  * returns:
  *     1, if all hashes of all images are valid
@@ -1315,10 +1533,12 @@ int fit_image_verify(const void *fit, int image_noffset)
  */
 int fit_all_image_verify(const void *fit)
 {
+	struct fit_hash_job *jobs;
 	int images_noffset;
 	int noffset;
 	int ndepth;
 	int count;
+	int ret = 1;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1328,6 +1548,8 @@ int fit_all_image_verify(const void *fit)
 		return 0;
 	}
 
+	jobs = fit_hash_jobs_start(fit, images_noffset);
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
@@ -1342,14 +1564,18 @@ int fit_all_image_verify(const void *fit)
 			 */
 			printf("   Hash(es) for Image %u (%s): ", count,
 			       fit_get_name(fit, noffset, NULL));
-			count++;
 
-			if (!fit_image_verify(fit, noffset))
-				return 0;
+			if (!fit_hash_job_verify(jobs, count, fit, noffset)) {
+				ret = 0;
+				break;
+			}
+			count++;
 			printf("\n");
 		}
 	}
-	return 1;
+	fit_hash_jobs_finish(jobs);
+
+	return ret;
 }
 
 /**
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Statistics about malloc() use
+ *
+ * malloc() and friends in dlmalloc.c call into here once the full malloc()
+ * is running. This keeps the current and peak usage and a histogram of
+ * block sizes. With CONFIG_MALLOC_TRACK_CALLERS it also records who
+ * allocated each block, in a hash table indexed by the block's address, so
+ * that blocks which are never freed can be found.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <malloc_stats.h>
+
+/* These are only used after relocation, so may be in BSS */
+static struct malloc_info malloc_info;
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+#define MALLOC_TRACK_ENTRIES	CONFIG_MALLOC_TRACK_ENTRIES
+
+/* Stop adding entries when the table is this full, to keep lookups fast */
+#define MALLOC_TRACK_MAX	(MALLOC_TRACK_ENTRIES * 7 / 8)
+
+/**
+ * struct malloc_track - Record of an allocated block
+ *
+ * @ptr:	Block, or NULL if this entry is empty
+ * @caller:	Address malloc() etc. was called from
+ * @size:	Usable size of the block
+ * @seq:	Value of malloc_info.allocs when the block was allocated
+ */
+struct malloc_track {
+	void *ptr;
+	void *caller;
+	ulong size;
+	ulong seq;
+};
+
+static struct malloc_track malloc_track[MALLOC_TRACK_ENTRIES];
+static int malloc_track_used;
+
+static uint malloc_track_hash(void *ptr)
+{
+	return ((ulong)ptr >> 3) * 2654435761U % MALLOC_TRACK_ENTRIES;
+}
+
+static void malloc_track_add(void *ptr, size_t size, void *caller)
+{
+	struct malloc_track *ent;
+	uint i;
+
+	if (malloc_track_used >= MALLOC_TRACK_MAX) {
+		malloc_info.untracked++;
+		return;
+	}
+	for (i = malloc_track_hash(ptr); malloc_track[i].ptr;
+	     i = (i + 1) % MALLOC_TRACK_ENTRIES)
+		;
+	ent = &malloc_track[i];
+	ent->ptr = ptr;
+	ent->caller = caller;
+	ent->size = size;
+	ent->seq = malloc_info.allocs;
+	malloc_track_used++;
+}
+
+static void malloc_track_remove(void *ptr)
+{
+	uint i, j, home;
+
+	for (i = malloc_track_hash(ptr); malloc_track[i].ptr != ptr;
+	     i = (i + 1) % MALLOC_TRACK_ENTRIES) {
+		/* Not found, perhaps because the table was full */
+		if (!malloc_track[i].ptr)
+			return;
+	}
+
+	/*
+	 * Move later entries back into the gap, unless that would put them
+	 * before their home slot, so that no lookup stops too early
+	 */
+	for (j = (i + 1) % MALLOC_TRACK_ENTRIES; malloc_track[j].ptr;
+	     j = (j + 1) % MALLOC_TRACK_ENTRIES) {
+		home = malloc_track_hash(malloc_track[j].ptr);
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			malloc_track[i] = malloc_track[j];
+			i = j;
+		}
+	}
+	malloc_track[i].ptr = NULL;
+	malloc_track_used--;
+}
+
+ulong malloc_leaks_mark(void)
+{
+	return malloc_info.allocs;
+}
+
+int malloc_get_leaks(ulong mark, struct malloc_leak *leaks, int max,
+		     ulong *countp)
+{
+	struct malloc_track *ent;
+	struct malloc_leak tmp;
+	int num = 0;
+	int i, j;
+
+	*countp = 0;
+	for (ent = malloc_track; ent < malloc_track + MALLOC_TRACK_ENTRIES;
+	     ent++) {
+		if (!ent->ptr || ent->seq <= mark)
+			continue;
+		(*countp)++;
+		for (j = 0; j < num && leaks[j].caller != ent->caller; j++)
+			;
+		if (j == num) {
+			if (num == max)
+				continue;
+			leaks[num].caller = ent->caller;
+			leaks[num].count = 0;
+			leaks[num].bytes = 0;
+			num++;
+		}
+		leaks[j].count++;
+		leaks[j].bytes += ent->size;
+	}
+
+	/* Put the callers with the most bytes first */
+	for (i = 1; i < num; i++) {
+		tmp = leaks[i];
+		for (j = i; j > 0 && leaks[j - 1].bytes < tmp.bytes; j--)
+			leaks[j] = leaks[j - 1];
+		leaks[j] = tmp;
+	}
+
+	return num;
+}
+#else
+static inline void malloc_track_add(void *ptr, size_t size, void *caller)
+{
+}
+
+static inline void malloc_track_remove(void *ptr)
+{
+}
+#endif
+
+static int malloc_stats_bucket(size_t size)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_STATS_BUCKETS - 1; i++) {
+		if (size <= malloc_stats_bucket_size(i))
+			break;
+	}
+
+	return i;
+}
+
+ulong malloc_stats_bucket_size(int bucket)
+{
+	if (bucket >= MALLOC_STATS_BUCKETS - 1)
+		return 0;
+
+	return 16UL << bucket;
+}
+
+void malloc_stats_alloc(void *ptr, size_t size, void *caller)
+{
+	int bucket = malloc_stats_bucket(size);
+
+	malloc_info.allocs++;
+	malloc_info.count++;
+	malloc_info.in_use += size;
+	if (malloc_info.in_use > malloc_info.peak)
+		malloc_info.peak = malloc_info.in_use;
+	malloc_info.bucket_count[bucket]++;
+	malloc_info.bucket_allocs[bucket]++;
+	malloc_track_add(ptr, size, caller);
+}
+
+void malloc_stats_free(void *ptr, size_t size)
+{
+	malloc_info.frees++;
+	malloc_info.count--;
+	malloc_info.in_use -= size;
+	malloc_info.bucket_count[malloc_stats_bucket(size)]--;
+	malloc_track_remove(ptr);
+}
+
+void malloc_stats_fail(size_t size)
+{
+	malloc_info.failures++;
+	if (size > malloc_info.largest_failure)
+		malloc_info.largest_failure = size;
+}
+
+void malloc_get_info(struct malloc_info *info)
+{
+	*info = malloc_info;
+	info->heap_size = mem_malloc_end - mem_malloc_start;
+}
+
+void malloc_reset_peak(void)
+{
+	malloc_info.peak = malloc_info.in_use;
+}
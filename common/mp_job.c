@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running jobs on secondary CPUs
+ *
+ * Jobs are given to free secondary CPUs in turn. A CPU stays busy until its
+ * job has been joined, so each CPU runs at most one job at a time and the
+ * architecture code need not queue them.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <mp_job.h>
+#include <watchdog.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* These are only used after relocation, so may be in BSS */
+static struct mp_job *mp_job_cpu[MP_JOB_MAX_CPUS + 1];
+static int mp_job_max_cpus = -1;
+static bool mp_job_stopped;
+
+__weak int arch_mp_job_cpus(void)
+{
+	return 0;
+}
+
+__weak int arch_mp_job_cpu(void)
+{
+	return 0;
+}
+
+__weak int arch_mp_job_start(int cpu, struct mp_job *job)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_mp_job_join(int cpu, struct mp_job *job)
+{
+	while (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+		WATCHDOG_RESET();
+}
+
+__weak void arch_mp_job_stop(int cpu)
+{
+}
+
+int mp_job_cpus(void)
+{
+	int cpus;
+
+	if (!(gd->flags & GD_FLG_RELOC) || mp_job_stopped)
+		return 0;
+	cpus = min(arch_mp_job_cpus(), MP_JOB_MAX_CPUS);
+	if (mp_job_max_cpus >= 0)
+		cpus = min(cpus, mp_job_max_cpus);
+
+	return cpus;
+}
+
+bool mp_job_secondary(void)
+{
+	return arch_mp_job_cpu() != 0;
+}
+
+int mp_job_set_max_cpus(int max)
+{
+	int old = mp_job_max_cpus;
+
+	mp_job_max_cpus = max;
+
+	return old;
+}
+
+void mp_job_start(struct mp_job *job, int (*func)(void *arg), void *arg)
+{
+	int cpus = mp_job_cpus();
+	int cpu;
+
+	job->func = func;
+	job->arg = arg;
+	job->ret = 0;
+	job->cpu = 0;
+	job->done = false;
+
+	for (cpu = 1; cpu <= cpus; cpu++) {
+		if (mp_job_cpu[cpu])
+			continue;
+		mp_job_cpu[cpu] = job;
+		job->cpu = cpu;
+		if (!arch_mp_job_start(cpu, job))
+			return;
+		debug("%s: CPU %d failed to start job\n", __func__, cpu);
+		mp_job_cpu[cpu] = NULL;
+		job->cpu = 0;
+	}
+
+	/* No CPU is free, so run it here */
+	mp_job_run(job);
+}
+
+int mp_job_join(struct mp_job *job)
+{
+	if (job->cpu && mp_job_cpu[job->cpu] == job) {
+		arch_mp_job_join(job->cpu, job);
+		mp_job_cpu[job->cpu] = NULL;
+	}
+
+	return job->ret;
+}
+
+void mp_job_stop_cpus(void)
+{
+	int cpu;
+
+	for (cpu = 1; cpu <= MP_JOB_MAX_CPUS; cpu++) {
+		if (mp_job_cpu[cpu])
+			mp_job_join(mp_job_cpu[cpu]);
+		arch_mp_job_stop(cpu);
+	}
+	mp_job_stopped = true;
+}
@@ -7,9 +7,11 @@
 #include <common.h>
 #include <blk.h>
 #include <dm.h>
+#include <malloc.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <linux/err.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -426,25 +428,183 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+/**
+ * struct blk_readahead - read-ahead state of a block device
+ *
+ * This is the uclass-private data of each block device.
+ *
+ * @next:	Block which is read next if access is sequential
+ * @start:	First block held in @buf
+ * @count:	Number of blocks held in @buf
+ * @size:	Size of @buf in bytes
+ * @buf:	Read-ahead buffer, or NULL if not allocated yet
+ */
+struct blk_readahead {
+	lbaint_t next;
+	lbaint_t start;
+	lbaint_t count;
+	ulong size;
+	void *buf;
+};
+
+static struct blk_readahead_stats ra_stats = {
+	.size_kb = CONFIG_BLK_READAHEAD_SIZE,
+};
+
+static ulong blk_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	struct blk_readahead *ra = dev_get_uclass_priv(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blksz = block_dev->blksz;
+	bool seq = start == ra->next;
+	lbaint_t window, done = 0;
+	ulong n;
+
+	ra_stats.requests++;
+	ra->next = start + blkcnt;
+
+	/* Copy out whatever the buffer holds of the request */
+	if (start >= ra->start && start < ra->start + ra->count) {
+		done = min(blkcnt, ra->start + ra->count - start);
+		memcpy(buffer, ra->buf + (start - ra->start) * blksz,
+		       done * blksz);
+		ra_stats.hits++;
+		if (done == blkcnt)
+			return blkcnt;
+		start += done;
+		blkcnt -= done;
+		buffer += done * blksz;
+		seq = true;
+	}
+
+	/*
+	 * Only fetch a whole window for sequential reads that are smaller
+	 * than the window. Anything else goes straight to the caller's buffer.
+	 */
+	window = (ra_stats.size_kb << 10) / blksz;
+	if (seq && blkcnt < window && start + blkcnt <= block_dev->lba) {
+		if (ra->size != window * blksz) {
+			free(ra->buf);
+			ra->count = 0;
+			ra->size = 0;
+			ra->buf = malloc(window * blksz);
+			if (ra->buf)
+				ra->size = window * blksz;
+		}
+	} else {
+		window = 0;
+	}
+
+	ra_stats.dev_reads++;
+	if (!window || !ra->buf) {
+		n = ops->read(dev, start, blkcnt, buffer);
+	} else {
+		window = min(window, block_dev->lba - start);
+		n = ops->read(dev, start, window, ra->buf);
+		if (IS_ERR_VALUE(n)) {
+			ra->count = 0;
+		} else {
+			ra->start = start;
+			ra->count = n;
+			n = min((lbaint_t)n, blkcnt);
+			memcpy(buffer, ra->buf, n * blksz);
+			ra_stats.prefetched += ra->count - n;
+		}
+	}
+
+	return IS_ERR_VALUE(n) ? n : done + n;
+}
+
+void blk_readahead_invalidate(struct blk_desc *block_dev)
+{
+	struct blk_readahead *ra;
+
+	if (!block_dev->bdev)
+		return;
+	ra = dev_get_uclass_priv(block_dev->bdev);
+	if (ra)
+		ra->count = 0;
+}
+
+/* Drop the read-ahead buffer of a device, e.g. when its size changes */
+static void blk_readahead_free(struct blk_readahead *ra)
+{
+	free(ra->buf);
+	ra->buf = NULL;
+	ra->size = 0;
+	ra->count = 0;
+	ra->next = -1;
+}
+
+void blk_readahead_configure(unsigned size_kb)
+{
+	struct blk_readahead *ra;
+	struct udevice *dev;
+	struct uclass *uc;
+
+	/* Blocks read ahead with the old setting must not be used */
+	if (!uclass_get(UCLASS_BLK, &uc)) {
+		uclass_foreach_dev(dev, uc) {
+			ra = dev_get_uclass_priv(dev);
+			if (ra)
+				blk_readahead_free(ra);
+		}
+	}
+	ra_stats.size_kb = size_kb;
+	ra_stats.requests = 0;
+	ra_stats.dev_reads = 0;
+	ra_stats.hits = 0;
+	ra_stats.prefetched = 0;
+}
+
+void blk_readahead_stats(struct blk_readahead_stats *stats)
+{
+	memcpy(stats, &ra_stats, sizeof(*stats));
+	ra_stats.requests = 0;
+	ra_stats.dev_reads = 0;
+	ra_stats.hits = 0;
+	ra_stats.prefetched = 0;
+}
+
+static int blk_pre_remove(struct udevice *dev)
+{
+	struct blk_readahead *ra = dev_get_uclass_priv(dev);
+
+	/* There is nothing to free if the device was never probed */
+	if (ra)
+		blk_readahead_free(ra);
+
+	return 0;
+}
+#endif
+
+static ulong blk_read_dev(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	if (ra_stats.size_kb)
+		return blk_read_ahead(block_dev, start, blkcnt, buffer);
+#endif
+
+	return blk_get_ops(dev)->read(dev, start, blkcnt, buffer);
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
 
 	if (!ops->read)
 		return -ENOSYS;
 
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
-
-	return blks_read;
+	return blkcache_read_through(block_dev, start, blkcnt, buffer,
+				     blk_read_dev);
 }
 
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
@@ -457,6 +617,7 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
 	return ops->write(dev, start, blkcnt, buffer);
 }
 
@@ -470,6 +631,7 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
 	return ops->erase(dev, start, blkcnt);
 }
 
@@ -639,6 +801,12 @@ int blk_unbind_all(int if_type)
 
 static int blk_post_probe(struct udevice *dev)
 {
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	struct blk_readahead *ra = dev_get_uclass_priv(dev);
+
+	/* Don't treat a first read of block 0 as sequential */
+	ra->next = -1;
+#endif
 #if defined(CONFIG_PARTITIONS) && defined(CONFIG_HAVE_BLOCK_DEVICE)
 	struct blk_desc *desc = dev_get_uclass_platdata(dev);
 
@@ -652,5 +820,9 @@ UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	.pre_remove	= blk_pre_remove,
+	.per_device_auto_alloc_size = sizeof(struct blk_readahead),
+#endif
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
@@ -9,159 +9,315 @@
 #include <malloc.h>
 #include <part.h>
 #include <linux/ctype.h>
-#include <linux/list.h>
+#include <linux/err.h>
+#include <linux/log2.h>
 
-struct block_cache_node {
-	struct list_head lh;
+/*
+ * The cache is set-associative with one block per line. A block is hashed
+ * (with its interface type and device number) to a set and may live in any
+ * of the BLKCACHE_WAYS lines of that set. Lines are replaced in LRU order
+ * within a set.
+ */
+#define BLKCACHE_WAYS		8
+#define BLKCACHE_MAX_BLOCKS	8
+
+struct block_cache_line {
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
-	unsigned long blksz;
-	char *cache;
+	lbaint_t blknr;
+	unsigned long blksz;	/* 0 if the line is empty */
+	unsigned int stamp;	/* value of 'tick' when last used */
 };
 
-static LIST_HEAD(block_cache);
+static struct block_cache_line *lines;
+static char *cache_data;
+static unsigned long line_size;
+static unsigned int tick;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = BLKCACHE_MAX_BLOCKS,
+	.size_mb = CONFIG_BLOCK_CACHE_SIZE,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+/* Number of reads to make room for, set by blkcache_configure() */
+static unsigned int config_entries;
+
+static void cache_free(void)
+{
+	free(lines);
+	free(cache_data);
+	lines = NULL;
+	cache_data = NULL;
+	line_size = 0;
+	_stats.entries = 0;
+	_stats.max_entries = 0;
+	_stats.size_kb = 0;
+	_stats.sets = 0;
+	_stats.ways = 0;
+}
+
+/* Get the size of the cache in bytes, for blocks of size @blksz */
+static unsigned long cache_size(unsigned long blksz)
+{
+	if (config_entries)
+		return (unsigned long)config_entries *
+			_stats.max_blocks_per_entry * blksz;
+
+	return (unsigned long)_stats.size_mb << 20;
+}
+
+/*
+ * cache_setup() - make sure the cache can hold blocks of size @blksz
+ *
+ * The cache is allocated on first use. Its lines are sized for the largest
+ * block size seen so far, so the cache is rebuilt if a device with larger
+ * blocks turns up. If the configured size cannot be allocated, smaller
+ * sizes are tried.
+ *
+ * @return true if the cache can be used, false if not
+ */
+static bool cache_setup(unsigned long blksz)
+{
+	unsigned long size, nsets;
+
+	if (!cache_size(blksz) || !_stats.max_blocks_per_entry)
+		return false;
+	if (lines && blksz <= line_size)
+		return true;
+
+	cache_free();
+	for (size = cache_size(blksz); size; size >>= 1) {
+		/* A small cache still gets one full set */
+		nsets = DIV_ROUND_UP(size / blksz, BLKCACHE_WAYS);
+		if (!nsets)
+			break;
+		nsets = rounddown_pow_of_two(nsets);
+		lines = calloc(nsets * BLKCACHE_WAYS, sizeof(*lines));
+		cache_data = malloc(nsets * BLKCACHE_WAYS * blksz);
+		if (lines && cache_data) {
+			line_size = blksz;
+			_stats.sets = nsets;
+			_stats.ways = BLKCACHE_WAYS;
+			_stats.max_entries = nsets * BLKCACHE_WAYS;
+			_stats.size_kb = nsets * BLKCACHE_WAYS * blksz >> 10;
+			debug("blkcache: %lu sets of %u lines, %lu bytes each\n",
+			      nsets, BLKCACHE_WAYS, blksz);
+			return true;
+		}
+		cache_free();
+	}
+
+	return false;
+}
+
+static struct block_cache_line *cache_set(int iftype, int devnum,
+					  lbaint_t blknr)
+{
+	u64 key = (u64)blknr ^ ((u64)iftype << 56) ^ ((u64)devnum << 48);
+	unsigned int set;
+
+	set = (key * 0x9e3779b97f4a7c15ULL) >> 32 & (_stats.sets - 1);
+
+	return &lines[set * BLKCACHE_WAYS];
+}
+
+static struct block_cache_line *cache_find(int iftype, int devnum,
+					   lbaint_t blknr, unsigned long blksz)
+{
+	struct block_cache_line *line = cache_set(iftype, devnum, blknr);
+	int i;
+
+	for (i = 0; i < BLKCACHE_WAYS; i++, line++) {
+		if (line->blksz == blksz && line->blknr == blknr &&
+		    line->devnum == devnum && line->iftype == iftype) {
+			line->stamp = ++tick;
+			return line;
+		}
+	}
+
+	return NULL;
+}
+
+static void *cache_line_data(struct block_cache_line *line)
+{
+	return cache_data + (line - lines) * line_size;
+}
+
+static void cache_insert(int iftype, int devnum, lbaint_t blknr,
+			 unsigned long blksz, const void *buffer)
 {
-	struct block_cache_node *node;
-
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
+	struct block_cache_line *line, *victim;
+	int i;
+
+	line = cache_find(iftype, devnum, blknr, blksz);
+	if (!line) {
+		line = cache_set(iftype, devnum, blknr);
+		victim = line;
+		for (i = 0; i < BLKCACHE_WAYS; i++, line++) {
+			if (!line->blksz) {
+				victim = line;
+				break;
 			}
-			return node;
+			if (tick - line->stamp > tick - victim->stamp)
+				victim = line;
+		}
+		line = victim;
+		if (line->blksz) {
+			debug("drop: block " LBAF "\n", line->blknr);
+			_stats.evictions++;
+		} else {
+			_stats.entries++;
 		}
-	return 0;
+		line->iftype = iftype;
+		line->devnum = devnum;
+		line->blknr = blknr;
+		line->blksz = blksz;
+		line->stamp = ++tick;
+	}
+	memcpy(cache_line_data(line), buffer, blksz);
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_line *line;
+	lbaint_t i;
+
+	if (!lines || blksz > line_size)
+		return 0;
+
+	for (i = 0; i < blkcnt; i++) {
+		if (!cache_find(iftype, devnum, start + i, blksz)) {
+			debug("miss: start " LBAF ", count " LBAFU "\n",
+			      start, blkcnt);
+			_stats.misses += blkcnt;
+			return 0;
+		}
 	}
 
-	debug("miss: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-	++_stats.misses;
-	return 0;
+	for (i = 0; i < blkcnt; i++) {
+		line = cache_find(iftype, devnum, start + i, blksz);
+		memcpy(buffer + i * blksz, cache_line_data(line), blksz);
+	}
+	debug("hit: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	_stats.hits += blkcnt;
+
+	return 1;
 }
 
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	lbaint_t i;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (!cache_setup(blksz))
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
+	debug("fill: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	for (i = 0; i < blkcnt; i++)
+		cache_insert(iftype, devnum, start + i, blksz,
+			     buffer + i * blksz);
+}
+
+ulong blkcache_read_through(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer,
+			    blkcache_read_t read)
+{
+	int iftype = block_dev->if_type;
+	int devnum = block_dev->devnum;
+	unsigned long blksz = block_dev->blksz;
+	struct block_cache_line *line;
+	lbaint_t done, run;
+	ulong blks_read;
+
+	if (!lines || blksz > line_size) {
+		_stats.misses += blkcnt;
+		blks_read = read(block_dev, start, blkcnt, buffer);
+		if (blks_read == blkcnt)
+			blkcache_fill(iftype, devnum, start, blkcnt, blksz,
+				      buffer);
+		return blks_read;
 	}
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+	done = 0;
+	while (done < blkcnt) {
+		/* Copy out the cached blocks at the start of what is left */
+		for (; done < blkcnt; done++) {
+			line = cache_find(iftype, devnum, start + done, blksz);
+			if (!line)
+				break;
+			memcpy(buffer + done * blksz, cache_line_data(line),
+			       blksz);
+			_stats.hits++;
+		}
+		if (done == blkcnt)
+			break;
+
+		/* Read the run of missing blocks that follows in one go */
+		for (run = 1; done + run < blkcnt; run++) {
+			if (cache_find(iftype, devnum, start + done + run,
+				       blksz))
+				break;
 		}
+		debug("miss: start " LBAF ", count " LBAFU "\n", start + done,
+		      run);
+		_stats.misses += run;
+		blks_read = read(block_dev, start + done, run,
+				 buffer + done * blksz);
+		if (blks_read != run)
+			return IS_ERR_VALUE(blks_read) ? blks_read :
+				done + blks_read;
+		blkcache_fill(iftype, devnum, start + done, run, blksz,
+			      buffer + done * blksz);
+		done += run;
 	}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	return blkcnt;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
-
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
+	struct block_cache_line *line;
+	unsigned int i;
+
+	for (i = 0, line = lines; i < _stats.max_entries; i++, line++) {
+		if (line->blksz && line->iftype == iftype &&
+		    line->devnum == devnum) {
+			line->blksz = 0;
+			_stats.entries--;
 		}
 	}
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+static void cache_reconfigure(unsigned blocks, unsigned entries,
+			      unsigned size_mb)
 {
-	struct block_cache_node *node;
-	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
-		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
-	}
+	/* invalidate cache; it is reallocated on the next fill */
+	cache_free();
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	config_entries = entries;
+	_stats.size_mb = size_mb;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+void blkcache_configure(unsigned blocks, unsigned entries)
+{
+	cache_reconfigure(blocks, entries, 0);
+}
+
+void blkcache_configure_size(unsigned blocks, unsigned size_mb)
+{
+	cache_reconfigure(blocks, 0, size_mb);
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -169,4 +325,5 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
 }
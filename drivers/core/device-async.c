@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Finishing device probes in the background
+ *
+ * A driver whose probe() has to wait for the hardware, for example for a card
+ * to power up or a link to come up, can hand the wait over to driver model
+ * with device_async_start(). The waits of all such devices are then polled in
+ * turn, so they overlap instead of adding up. There are no threads: polling
+ * happens whenever something waits for one of these devices, which
+ * device_probe() does for any device still finishing its probe.
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <errno.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <dm/device.h>
+#include <dm/device-internal.h>
+#include <dm/util.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct device_async - A device whose probe is finishing in the background
+ *
+ * @node: Entry in device_async_list
+ * @dev: Device being probed
+ * @poll: Function to check progress, see device_async_start()
+ * @start_us: Time the wait started, for bootstage
+ * @busy: true while @poll is running, so that it is not called again from
+ *	inside itself
+ */
+struct device_async {
+	struct list_head node;
+	struct udevice *dev;
+	int (*poll)(struct udevice *dev);
+	ulong start_us;
+	bool busy;
+};
+
+/* This is only used after relocation, so may be in BSS */
+static LIST_HEAD(device_async_list);
+
+/* Changed whenever an entry leaves the list, so iterators can restart */
+static uint device_async_gen;
+
+static struct device_async *device_async_find(struct udevice *dev)
+{
+	struct device_async *as;
+
+	list_for_each_entry(as, &device_async_list, node) {
+		if (as->dev == dev)
+			return as;
+	}
+
+	return NULL;
+}
+
+static void device_async_free(struct device_async *as)
+{
+	as->dev->flags &= ~DM_FLAG_PROBE_ASYNC;
+	list_del(&as->node);
+	free(as);
+	device_async_gen++;
+}
+
+/* Wait for a device synchronously, when it cannot be left to finish later */
+static int device_async_sync(struct udevice *dev,
+			     int (*poll)(struct udevice *dev))
+{
+	int ret;
+
+	do {
+		ret = poll(dev);
+		WATCHDOG_RESET();
+	} while (ret == -EAGAIN);
+
+	return ret;
+}
+
+int device_async_start(struct udevice *dev, int (*poll)(struct udevice *dev))
+{
+	struct device_async *as;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return device_async_sync(dev, poll);
+
+	as = calloc(1, sizeof(*as));
+	if (!as)
+		return device_async_sync(dev, poll);
+	as->dev = dev;
+	as->poll = poll;
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_PROBE))
+		as->start_us = timer_get_boot_us();
+	list_add_tail(&as->node, &device_async_list);
+	dev->flags |= DM_FLAG_PROBE_ASYNC;
+
+	return 0;
+}
+
+/**
+ * device_async_step() - Poll one device and deal with the result
+ *
+ * @as: Device to poll
+ * Once the device is ready, its probe is finished with device_probe_finish().
+ *
+ * @return -EAGAIN if the device is still not ready, else the result of its
+ *	probe. If this is an error, the device has been removed
+ */
+static int device_async_step(struct device_async *as)
+{
+	struct udevice *dev = as->dev;
+	int ret;
+
+	as->busy = true;
+	ret = as->poll(dev);
+	as->busy = false;
+	if (ret == -EAGAIN)
+		return ret;
+
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_PROBE)) {
+		char name[40];
+
+		snprintf(name, sizeof(name), "%s (async)", dev->name);
+		bootstage_add_span(name, as->start_us);
+	}
+	device_async_free(as);
+	if (ret) {
+		dm_warn("Device '%s' failed to finish probing (err=%d)\n",
+			dev->name, ret);
+		device_remove(dev, DM_REMOVE_NORMAL);
+
+		return ret;
+	}
+
+	/* Now the uclass and the parent can see the device */
+	return device_probe_finish(dev);
+}
+
+/**
+ * device_async_run() - Poll each waiting device once
+ *
+ * @dev: Device being waited for, or NULL if none
+ * @return -EAGAIN if @dev is still not ready, else the result of its probe
+ */
+static int device_async_run(struct udevice *dev)
+{
+	struct device_async *as;
+	uint gen;
+	int ret;
+
+restart:
+	list_for_each_entry(as, &device_async_list, node) {
+		bool wanted = as->dev == dev;
+
+		if (as->busy)
+			continue;
+		gen = device_async_gen;
+		ret = device_async_step(as);
+		if (wanted && ret != -EAGAIN)
+			return ret;
+		/* The list changed under us, perhaps from inside the poll */
+		if (gen != device_async_gen)
+			goto restart;
+	}
+
+	return dev && (dev->flags & DM_FLAG_PROBE_ASYNC) ? -EAGAIN : 0;
+}
+
+int device_async_wait(struct udevice *dev)
+{
+	struct device_async *as;
+	int ret;
+
+	if (!(dev->flags & DM_FLAG_PROBE_ASYNC))
+		return 0;
+
+	/* Waiting for a device from inside its own poll cannot work */
+	as = device_async_find(dev);
+	if (!as || as->busy)
+		return 0;
+
+	do {
+		ret = device_async_run(dev);
+		WATCHDOG_RESET();
+	} while (ret == -EAGAIN);
+
+	return ret;
+}
+
+int device_async_poll(void)
+{
+	struct device_async *as;
+	int count = 0;
+
+	device_async_run(NULL);
+	list_for_each_entry(as, &device_async_list, node)
+		count++;
+
+	return count;
+}
+
+int device_async_wait_all(void)
+{
+	while (device_async_poll())
+		WATCHDOG_RESET();
+
+	return 0;
+}
+
+void device_async_cancel(struct udevice *dev)
+{
+	struct device_async *as;
+
+	if (!(dev->flags & DM_FLAG_PROBE_ASYNC))
+		return;
+	as = device_async_find(dev);
+	if (as && !as->busy)
+		device_async_free(as);
+}
@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <dm/slab.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -59,7 +60,7 @@ int device_chld_remove(struct udevice *dev, struct driver *drv,
 int device_unbind(struct udevice *dev)
 {
 	const struct driver *drv;
-	int ret;
+	int size, ret;
 
 	if (!dev)
 		return -EINVAL;
@@ -84,15 +85,21 @@ int device_unbind(struct udevice *dev)
 		return ret;
 
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		dm_slab_free(dev->platdata, drv->platdata_auto_alloc_size);
 		dev->platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		dm_slab_free(dev->uclass_platdata, dev->uclass->uc_drv->
+			     per_device_platdata_auto_alloc_size);
 		dev->uclass_platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev->parent_platdata);
+		size = dev->parent->driver->per_child_platdata_auto_alloc_size;
+		if (!size) {
+			size = dev->parent->uclass->uc_drv->
+					per_child_platdata_auto_alloc_size;
+		}
+		dm_slab_free(dev->parent_platdata, size);
 		dev->parent_platdata = NULL;
 	}
 	ret = uclass_unbind_device(dev);
@@ -106,11 +113,20 @@ int device_unbind(struct udevice *dev)
 
 	if (dev->flags & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
-	free(dev);
+	dm_slab_free(dev, sizeof(struct udevice));
 
 	return 0;
 }
 
+/* Free private data allocated by alloc_priv() in device.c */
+static void free_priv(void *priv, int size, uint flags)
+{
+	if (flags & DM_FLAG_ALLOC_PRIV_DMA)
+		free(priv);
+	else
+		dm_slab_free(priv, size);
+}
+
 /**
  * device_free() - Free memory buffers allocated by a device
  * @dev:	Device that is to be started
@@ -119,13 +135,14 @@ void device_free(struct udevice *dev)
 {
 	int size;
 
-	if (dev->driver->priv_auto_alloc_size) {
-		free(dev->priv);
+	size = dev->driver->priv_auto_alloc_size;
+	if (size) {
+		free_priv(dev->priv, size, dev->driver->flags);
 		dev->priv = NULL;
 	}
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size) {
-		free(dev->uclass_priv);
+		free_priv(dev->uclass_priv, size, dev->uclass->uc_drv->flags);
 		dev->uclass_priv = NULL;
 	}
 	if (dev->parent) {
@@ -135,7 +152,7 @@ void device_free(struct udevice *dev)
 					per_child_auto_alloc_size;
 		}
 		if (size) {
-			free(dev->parent_priv);
+			free_priv(dev->parent_priv, size, dev->driver->flags);
 			dev->parent_priv = NULL;
 		}
 	}
@@ -195,7 +212,8 @@ int device_remove(struct udevice *dev, uint flags)
 	if (flags_remove(flags, drv->flags)) {
 		device_free(dev);
 
-		dev->seq = -1;
+		uclass_set_seq(dev, -1);
+		device_async_cancel(dev);
 		dev->flags &= ~DM_FLAG_ACTIVATED;
 	}
 
@@ -21,6 +21,7 @@
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
 #include <dm/read.h>
+#include <dm/slab.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -50,13 +51,17 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	dev = dm_slab_alloc(sizeof(struct udevice));
 	if (!dev)
 		return -ENOMEM;
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
 	INIT_LIST_HEAD(&dev->uclass_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	INIT_LIST_HEAD(&dev->seq_hash_node);
+	INIT_LIST_HEAD(&dev->node_hash_node);
+#endif
 #ifdef CONFIG_DEVRES
 	INIT_LIST_HEAD(&dev->devres_head);
 #endif
@@ -100,8 +105,8 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (alloc) {
 			dev->flags |= DM_FLAG_ALLOC_PDATA;
-			dev->platdata = calloc(1,
-					       drv->platdata_auto_alloc_size);
+			dev->platdata = dm_slab_alloc(
+					drv->platdata_auto_alloc_size);
 			if (!dev->platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
@@ -116,7 +121,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
 	if (size) {
 		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
+		dev->uclass_platdata = dm_slab_alloc(size);
 		if (!dev->uclass_platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -131,7 +136,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (size) {
 			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
+			dev->parent_platdata = dm_slab_alloc(size);
 			if (!dev->parent_platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -194,24 +199,25 @@ fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
 		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev->parent_platdata);
+			dm_slab_free(dev->parent_platdata, size);
 			dev->parent_platdata = NULL;
 		}
 	}
 fail_alloc3:
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		dm_slab_free(dev->uclass_platdata,
+			     uc->uc_drv->per_device_platdata_auto_alloc_size);
 		dev->uclass_platdata = NULL;
 	}
 fail_alloc2:
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		dm_slab_free(dev->platdata, drv->platdata_auto_alloc_size);
 		dev->platdata = NULL;
 	}
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	dm_slab_free(dev, sizeof(struct udevice));
 
 	return ret;
 }
@@ -299,13 +305,44 @@ static void *alloc_priv(int size, uint flags)
 #endif
 		}
 	} else {
-		priv = calloc(1, size);
+		priv = dm_slab_alloc(size);
 	}
 
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Undo the work of a probe which failed */
+static void device_probe_undo(struct udevice *dev)
+{
+	device_async_cancel(dev);
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+
+	uclass_set_seq(dev, -1);
+	device_free(dev);
+}
+
+int device_probe_finish(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret) {
+		if (device_remove(dev, DM_REMOVE_NORMAL)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		device_probe_undo(dev);
+
+		return ret;
+	}
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+}
+
+static int device_probe_dev(struct udevice *dev)
 {
 	struct power_domain pd;
 	const struct driver *drv;
@@ -316,8 +353,9 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+	/* If it is still finishing its probe, wait for that */
 	if (dev->flags & DM_FLAG_ACTIVATED)
-		return 0;
+		return device_async_wait(dev);
 
 	drv = dev->driver;
 	assert(drv);
@@ -367,7 +405,7 @@ int device_probe(struct udevice *dev)
 		 * so that we don't mess up the device.
 		 */
 		if (dev->flags & DM_FLAG_ACTIVATED)
-			return 0;
+			return device_async_wait(dev);
 	}
 
 	seq = uclass_resolve_seq(dev);
@@ -375,7 +413,7 @@ int device_probe(struct udevice *dev)
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -422,24 +460,28 @@ int device_probe(struct udevice *dev)
 		}
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
+	/* If the device is finishing its probe later, the rest waits too */
+	if (dev->flags & DM_FLAG_PROBE_ASYNC)
+		return 0;
 
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
+	return device_probe_finish(dev);
 fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+	device_probe_undo(dev);
 
-	dev->seq = -1;
-	device_free(dev);
+	return ret;
+}
+
+int device_probe(struct udevice *dev)
+{
+	int span, ret;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_PROBE) || !dev ||
+	    (dev->flags & DM_FLAG_ACTIVATED))
+		return device_probe_dev(dev);
+
+	span = bootstage_span_begin(dev->name);
+	ret = device_probe_dev(dev);
+	bootstage_span_end(span);
 
 	return ret;
 }
@@ -810,6 +852,12 @@ int device_set_name(struct udevice *dev, const char *name)
 	return 0;
 }
 
+void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev->node = node;
+	uclass_update_ofnode(dev);
+}
+
 bool device_is_compatible(struct udevice *dev, const char *compat)
 {
 	return ofnode_device_is_compatible(dev_ofnode(dev), compat);
@@ -6,7 +6,9 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <of_live.h>
 #include <dm/root.h>
+#include <dm/slab.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
 
@@ -53,6 +55,18 @@ void dm_dump_all(void)
 		printf("-----------------------------------------------------------\n");
 		show_devices(root, -1, 0);
 	}
+#ifdef CONFIG_OF_LIVE
+	if (of_live_active()) {
+		const struct of_live_stats *stats = of_live_get_stats();
+
+		printf("\nLive tree: %d nodes, %d properties, %lu bytes, built in %lu us\n",
+		       stats->nodes, stats->props, stats->size,
+		       stats->build_us);
+		if (IS_ENABLED(CONFIG_OF_LIVE_LAZY))
+			printf("Lazy decoding: %d nodes not decoded yet, %lu bytes used\n",
+			       stats->lazy_nodes, stats->lazy_size);
+	}
+#endif
 }
 
 /**
@@ -96,3 +110,38 @@ void dm_dump_uclass(void)
 		puts("\n");
 	}
 }
+
+#if CONFIG_IS_ENABLED(DM_SLAB)
+/* Work out how much of @total is not in @used, as a percentage */
+static int dm_mem_waste(ulong used, ulong total)
+{
+	return total ? (total - used) * 100 / total : 0;
+}
+
+void dm_dump_mem(void)
+{
+	struct dm_slab_stats stats;
+	int i;
+
+	dm_slab_get_stats(&stats);
+	printf(" Size  Slabs   Used   Free\n");
+	for (i = 0; i < DM_SLAB_CLASSES; i++) {
+		struct dm_slab_class_stats *cs = &stats.class[i];
+
+		if (cs->slabs)
+			printf("%5d  %5d  %5d  %5d\n", cs->size, cs->slabs,
+			       cs->used, cs->free);
+	}
+	printf("\nObjects: %d in slabs, %d too large (%lu bytes) from malloc(), %lu allocated in total\n",
+	       stats.allocs, stats.large_allocs, stats.large_bytes,
+	       stats.total_allocs);
+	printf("Slabs:    %lu bytes for %lu requested, %d%% fragmentation\n",
+	       stats.slab_bytes, stats.req_bytes,
+	       dm_mem_waste(stats.req_bytes, stats.slab_bytes));
+	printf("Classes:  %lu bytes, %d%% rounding\n", stats.used_bytes,
+	       dm_mem_waste(stats.req_bytes, stats.used_bytes));
+	printf("malloc(): %lu bytes would be used, %d%% overhead\n",
+	       stats.malloc_bytes,
+	       dm_mem_waste(stats.req_bytes, stats.malloc_bytes));
+}
+#endif
@@ -10,12 +10,17 @@
 #include <errno.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <dm/devtab.h>
 #include <dm/lists.h>
 #include <dm/platdata.h>
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -122,17 +127,266 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/**
+ * struct compat_entry - Entry in the index of driver compatible strings
+ *
+ * @compat:	Compatible string, or NULL if this entry is empty
+ * @drv:	First driver in the linker list with this string
+ * @id:		Matching entry in the driver's of_match table
+ */
+struct compat_entry {
+	const char *compat;
+	struct driver *drv;
+	const struct udevice_id *id;
+};
+
+/* Hash table of compatible strings, built on first use after relocation */
+static struct compat_entry *compat_index;
+static uint compat_index_mask;
+static bool compat_index_disabled;
+
+/* FNV-1a hash of a string */
+static uint compat_hash(const char *str)
+{
+	uint hash = 2166136261U;
+
+	while (*str)
+		hash = (hash ^ (uchar)*str++) * 16777619U;
+
+	return hash;
+}
+
+static struct compat_entry *compat_index_find(const char *compat)
+{
+	struct compat_entry *entry;
+	uint i;
+
+	/* The table is never full, so this stops at an empty entry */
+	for (i = compat_hash(compat); ; i++) {
+		entry = &compat_index[i & compat_index_mask];
+		if (!entry->compat || !strcmp(entry->compat, compat))
+			return entry;
+	}
+}
+
+static int compat_index_build(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct compat_entry *entry;
+	struct driver *drv;
+	uint count = 0, size;
+
+	for (drv = driver; drv != driver + n_ents; drv++) {
+		for (id = drv->of_match; id && id->compatible; id++)
+			count++;
+	}
+
+	/* Keep the table at most half full so that lookups stay short */
+	size = __roundup_pow_of_two(max(count * 2, 16U));
+	compat_index = calloc(size, sizeof(*compat_index));
+	if (!compat_index)
+		return -ENOMEM;
+	compat_index_mask = size - 1;
+
+	/* The first driver with a string wins, as with a linear search */
+	for (drv = driver; drv != driver + n_ents; drv++) {
+		for (id = drv->of_match; id && id->compatible; id++) {
+			entry = compat_index_find(id->compatible);
+			if (entry->compat)
+				continue;
+			entry->compat = id->compatible;
+			entry->drv = drv;
+			entry->id = id;
+		}
+	}
+
+	return 0;
+}
+
+void lists_compat_index_set_enabled(bool enable)
+{
+	compat_index_disabled = !enable;
+	free(compat_index);
+	compat_index = NULL;
+}
+
+/* Look up a compatible string in the index, building it if needed */
+static int compat_index_lookup(const char *compat, struct driver **drvp,
+			       const struct udevice_id **of_idp)
+{
+	struct compat_entry *entry;
+
+	/* The index is in BSS so cannot be written before relocation */
+	if (compat_index_disabled || !(gd->flags & GD_FLG_RELOC))
+		return -ENOSYS;
+	if (!compat_index && compat_index_build())
+		return -ENOSYS;
+
+	entry = compat_index_find(compat);
+	if (!entry->compat)
+		return -ENOENT;
+	*drvp = entry->drv;
+	*of_idp = entry->id;
+
+	return 0;
+}
+#else
+static int compat_index_lookup(const char *compat, struct driver **drvp,
+			       const struct udevice_id **of_idp)
+{
+	return -ENOSYS;
+}
+#endif
+
+/**
+ * lists_match_compat() - Find the driver for a compatible string
+ *
+ * @compat:	The compatible string to search for
+ * @drvp:	Returns the driver found
+ * @of_idp:	Returns the match that was found
+ * @return 0 if there is a match, -ENOENT if no match
+ */
+static int lists_match_compat(const char *compat, struct driver **drvp,
+			      const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+	int ret;
+
+	ret = compat_index_lookup(compat, drvp, of_idp);
+	if (ret != -ENOSYS)
+		return ret;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat)) {
+			*drvp = entry;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+#if CONFIG_IS_ENABLED(OF_DEVTAB)
+static bool devtab_disabled;
+
+void lists_devtab_set_enabled(bool enable)
+{
+	struct dm_devtab *start = ll_entry_start(struct dm_devtab, devtab);
+	const int n_ents = ll_entry_count(struct dm_devtab, devtab);
+	struct dm_devtab *tab;
+
+	devtab_disabled = !enable;
+	for (tab = start; tab != start + n_ents; tab++)
+		memset(tab->match, '\0', tab->match_count * sizeof(*tab->match));
+}
+
+/**
+ * lists_devtab_find() - Find a node in the tables generated by dtoc
+ *
+ * @node:	Node to look up
+ * @compat_list: Value of the node's compatible property
+ * @compat_length: Length of @compat_list in bytes
+ * @tabp:	Returns the table containing the node
+ * @return slot in (*@tabp)->match for each string in @compat_list, or NULL
+ *	if the node is not in any table, or does not match it
+ */
+static const u16 *lists_devtab_find(ofnode node, const char *compat_list,
+				    int compat_length, struct dm_devtab **tabp)
+{
+	struct dm_devtab *start = ll_entry_start(struct dm_devtab, devtab);
+	const int n_ents = ll_entry_count(struct dm_devtab, devtab);
+	const struct dm_devtab_node *tnode;
+	int offset, low, high, mid;
+	struct dm_devtab *tab;
+
+	if (devtab_disabled || ofnode_is_np(node))
+		return NULL;
+	offset = ofnode_to_offset(node);
+	for (tab = start; tab != start + n_ents; tab++) {
+		low = 0;
+		high = tab->node_count;
+		while (low < high) {
+			mid = (low + high) / 2;
+			tnode = &tab->nodes[mid];
+			if (tnode->offset == offset)
+				break;
+			if (tnode->offset < offset)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		if (low >= high)
+			continue;
+
+		/* The tree may not be the one the table was built from */
+		if (tnode->compat_len == compat_length &&
+		    !memcmp(tnode->compat, compat_list, compat_length)) {
+			*tabp = tab;
+			return tnode->slots;
+		}
+	}
+
+	return NULL;
+}
+
+/* Find the driver for a compatible string, using the table's slot for it */
+static int lists_devtab_match(struct dm_devtab *tab, uint slot,
+			      const char *compat, struct driver **drvp,
+			      const struct udevice_id **of_idp)
+{
+	struct dm_devtab_match *match = &tab->match[slot];
+	int ret;
+
+	if (match->done) {
+		if (!match->drv)
+			return -ENOENT;
+		*drvp = match->drv;
+		*of_idp = match->id;
+		return 0;
+	}
+
+	ret = lists_match_compat(compat, drvp, of_idp);
+
+	/* The table is in BSS so cannot be written before relocation */
+	if (gd->flags & GD_FLG_RELOC) {
+		match->drv = ret ? NULL : *drvp;
+		match->id = ret ? NULL : *of_idp;
+		match->done = true;
+	}
+
+	return ret;
+}
+#else
+static const u16 *lists_devtab_find(ofnode node, const char *compat_list,
+				    int compat_length, struct dm_devtab **tabp)
+{
+	return NULL;
+}
+
+static int lists_devtab_match(struct dm_devtab *tab, uint slot,
+			      const char *compat, struct driver **drvp,
+			      const struct udevice_id **of_idp)
+{
+	return -ENOENT;
+}
+#endif
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
 	bool found = false;
 	const char *name, *compat_list, *compat;
-	int compat_length, i;
+	struct dm_devtab *tab = NULL;
+	const u16 *slots;
+	int compat_length, i, j;
 	int result = 0;
 	int ret = 0;
 
@@ -158,18 +412,18 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 	 * compatible string in order such that we match in order of priority
 	 * from the first string to the last.
 	 */
-	for (i = 0; i < compat_length; i += strlen(compat) + 1) {
+	slots = lists_devtab_find(node, compat_list, compat_length, &tab);
+	for (i = 0, j = 0; i < compat_length; i += strlen(compat) + 1, j++) {
 		compat = compat_list + i;
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		if (slots)
+			ret = lists_devtab_match(tab, slots[j], compat, &entry,
+						 &id);
+		else
+			ret = lists_match_compat(compat, &entry, &id);
+		if (ret)
 			continue;
 
 		if (pre_reloc_only) {
@@ -127,7 +127,7 @@ struct property *of_find_property(const struct device_node *np,
 	if (!np)
 		return NULL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
+	for (pp = of_node_props(np); pp; pp = pp->next) {
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
 				*lenp = pp->length;
@@ -305,7 +305,7 @@ static struct device_node *__of_find_node_by_path(struct device_node *parent,
 }
 
 #define for_each_property_of_node(dn, pp) \
-	for (pp = dn->properties; pp != NULL; pp = pp->next)
+	for (pp = of_node_props(dn); pp != NULL; pp = pp->next)
 
 struct device_node *of_find_node_opts_by_path(const char *path,
 					      const char **opts)
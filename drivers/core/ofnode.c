@@ -226,8 +226,8 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
-							    phandle);
+		node.of_offset = fdtdec_node_offset_by_phandle(gd->fdt_blob,
+							       phandle);
 
 	return node;
 }
@@ -409,7 +409,8 @@ ofnode ofnode_path(const char *path)
 	if (of_live_active())
 		return np_to_ofnode(of_find_node_by_path(path));
 	else
-		return offset_to_ofnode(fdt_path_offset(gd->fdt_blob, path));
+		return offset_to_ofnode(fdtdec_path_offset(gd->fdt_blob,
+							   path));
 }
 
 const char *ofnode_get_chosen_prop(const char *name)
@@ -821,7 +822,7 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 	if (!np)
 		return -EINVAL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
+	for (pp = of_node_props(np); pp; pp = pp->next) {
 		if (strcmp(pp->name, propname) == 0) {
 			/* Property exists -> change value */
 			pp->value = (void *)value;
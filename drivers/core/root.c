@@ -138,6 +138,15 @@ int dm_init(bool of_live)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/*
+	 * Without this, uclass_find() falls back to searching the list. The
+	 * pre-relocation malloc() area is too small to spare for it.
+	 */
+	if (gd->flags & GD_FLG_RELOC)
+		gd->uclass_index = calloc(UCLASS_COUNT,
+					  sizeof(struct uclass *));
+#endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -151,10 +160,10 @@ int dm_init(bool of_live)
 #if CONFIG_IS_ENABLED(OF_CONTROL)
 # if CONFIG_IS_ENABLED(OF_LIVE)
 	if (of_live)
-		DM_ROOT_NON_CONST->node = np_to_ofnode(gd->of_root);
+		dev_set_ofnode(DM_ROOT_NON_CONST, np_to_ofnode(gd->of_root));
 	else
 #endif
-		DM_ROOT_NON_CONST->node = offset_to_ofnode(0);
+		dev_set_ofnode(DM_ROOT_NON_CONST, offset_to_ofnode(0));
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -168,6 +177,10 @@ int dm_uninit(void)
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 	gd->dm_root = NULL;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	free(gd->uclass_index);
+	gd->uclass_index = NULL;
+#endif
 
 	return 0;
 }
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Size-class allocator for driver-model objects
+ *
+ * Driver model makes many small allocations: a struct udevice for each
+ * device, and its platdata and private data. With malloc() each of these
+ * carries a header and is rounded up, and they are spread around the heap
+ * among other allocations. Here objects are instead carved out of slabs,
+ * each of which holds objects of a single size class. A slab is aligned to
+ * its size, so the slab holding an object is found from its address.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <dm/slab.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Size and alignment of each slab in bytes */
+#define DM_SLAB_SIZE	4096
+
+/**
+ * struct dm_slab - Header at the start of each slab
+ *
+ * The objects follow the header. Free objects are linked through their
+ * first word.
+ *
+ * @node:	Entry in the class's list of slabs with free objects, or empty
+ *		if the slab is full
+ * @free:	First free object, or NULL if none
+ * @used:	Number of objects in use
+ */
+struct dm_slab {
+	struct list_head node;
+	void *free;
+	int used;
+};
+
+#define DM_SLAB_HDR_SIZE	ALIGN(sizeof(struct dm_slab), 16)
+
+/**
+ * struct dm_slab_class - A size class
+ *
+ * @partial:	Slabs with at least one free object
+ * @slabs:	Number of slabs
+ * @used:	Number of objects in use
+ */
+struct dm_slab_class {
+	struct list_head partial;
+	int slabs;
+	int used;
+};
+
+static const u16 dm_slab_sizes[DM_SLAB_CLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, DM_SLAB_MAX_SIZE
+};
+
+/* These are only used after relocation, so may be in BSS */
+static struct dm_slab_class dm_slab_class[DM_SLAB_CLASSES];
+static struct dm_slab_stats dm_slab_stats;
+static bool dm_slab_ready;
+
+static int dm_slab_class_of(int size)
+{
+	int i;
+
+	for (i = 0; i < DM_SLAB_CLASSES; i++) {
+		if (size <= dm_slab_sizes[i])
+			return i;
+	}
+
+	return -1;
+}
+
+static int dm_slab_capacity(int idx)
+{
+	return (DM_SLAB_SIZE - DM_SLAB_HDR_SIZE) / dm_slab_sizes[idx];
+}
+
+/* Work out the size of the chunk dlmalloc uses for an allocation */
+static ulong dm_slab_malloc_size(int size)
+{
+	ulong chunk = ALIGN(size + sizeof(size_t), 2 * sizeof(size_t));
+
+	return max_t(ulong, chunk, 4 * sizeof(size_t));
+}
+
+static void dm_slab_init(void)
+{
+	int i;
+
+	for (i = 0; i < DM_SLAB_CLASSES; i++)
+		INIT_LIST_HEAD(&dm_slab_class[i].partial);
+	dm_slab_ready = true;
+}
+
+static struct dm_slab *dm_slab_new(int idx)
+{
+	struct dm_slab_class *cls = &dm_slab_class[idx];
+	int size = dm_slab_sizes[idx];
+	struct dm_slab *slab;
+	void **obj, **next;
+	int i;
+
+	slab = memalign(DM_SLAB_SIZE, DM_SLAB_SIZE);
+	if (!slab)
+		return NULL;
+	slab->used = 0;
+	slab->free = (void *)slab + DM_SLAB_HDR_SIZE;
+	obj = slab->free;
+	for (i = 1; i < dm_slab_capacity(idx); i++) {
+		next = (void *)obj + size;
+		*obj = next;
+		obj = next;
+	}
+	*obj = NULL;
+	list_add(&slab->node, &cls->partial);
+	cls->slabs++;
+	dm_slab_stats.slab_bytes += DM_SLAB_SIZE;
+
+	return slab;
+}
+
+void *dm_slab_alloc(int size)
+{
+	struct dm_slab_class *cls;
+	struct dm_slab *slab;
+	void **obj;
+	int idx;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return calloc(1, size);
+
+	dm_slab_stats.total_allocs++;
+	idx = dm_slab_class_of(size);
+	if (idx < 0) {
+		obj = calloc(1, size);
+		if (obj) {
+			dm_slab_stats.large_allocs++;
+			dm_slab_stats.large_bytes += size;
+		}
+		return obj;
+	}
+	if (!dm_slab_ready)
+		dm_slab_init();
+
+	cls = &dm_slab_class[idx];
+	if (list_empty(&cls->partial)) {
+		slab = dm_slab_new(idx);
+		if (!slab)
+			return NULL;
+	} else {
+		slab = list_first_entry(&cls->partial, struct dm_slab, node);
+	}
+	obj = slab->free;
+	slab->free = *obj;
+	if (!slab->free)
+		list_del_init(&slab->node);
+	slab->used++;
+	cls->used++;
+	memset(obj, '\0', dm_slab_sizes[idx]);
+
+	dm_slab_stats.allocs++;
+	dm_slab_stats.req_bytes += size;
+	dm_slab_stats.used_bytes += dm_slab_sizes[idx];
+	dm_slab_stats.malloc_bytes += dm_slab_malloc_size(size);
+
+	return obj;
+}
+
+void dm_slab_free(void *ptr, int size)
+{
+	struct dm_slab_class *cls;
+	struct dm_slab *slab;
+	int idx;
+
+	if (!ptr)
+		return;
+	idx = dm_slab_class_of(size);
+	if (!(gd->flags & GD_FLG_RELOC) || idx < 0) {
+		if (gd->flags & GD_FLG_RELOC) {
+			dm_slab_stats.large_allocs--;
+			dm_slab_stats.large_bytes -= size;
+		}
+		free(ptr);
+		return;
+	}
+
+	cls = &dm_slab_class[idx];
+	slab = (struct dm_slab *)((ulong)ptr & ~(DM_SLAB_SIZE - 1));
+	if (!slab->free)
+		list_add(&slab->node, &cls->partial);
+	*(void **)ptr = slab->free;
+	slab->free = ptr;
+	slab->used--;
+	cls->used--;
+
+	dm_slab_stats.allocs--;
+	dm_slab_stats.req_bytes -= size;
+	dm_slab_stats.used_bytes -= dm_slab_sizes[idx];
+	dm_slab_stats.malloc_bytes -= dm_slab_malloc_size(size);
+
+	/*
+	 * Give an empty slab back, unless it is the last one in the class.
+	 * Full slabs are not on the partial list, so count them all.
+	 */
+	if (!slab->used && cls->slabs > 1) {
+		list_del(&slab->node);
+		free(slab);
+		cls->slabs--;
+		dm_slab_stats.slab_bytes -= DM_SLAB_SIZE;
+	}
+}
+
+void dm_slab_get_stats(struct dm_slab_stats *stats)
+{
+	struct dm_slab_class_stats *cs;
+	int i;
+
+	*stats = dm_slab_stats;
+	for (i = 0; i < DM_SLAB_CLASSES; i++) {
+		cs = &stats->class[i];
+		cs->size = dm_slab_sizes[i];
+		cs->slabs = dm_slab_class[i].slabs;
+		cs->used = dm_slab_class[i].used;
+		cs->free = cs->slabs * dm_slab_capacity(i) - cs->used;
+	}
+}
@@ -13,23 +13,81 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/slab.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+static struct list_head *uclass_seq_bucket(struct uclass *uc, int seq)
+{
+	return &uc->hash->seq[seq & (DM_UCLASS_HASH_SIZE - 1)];
+}
+
+static struct list_head *uclass_node_bucket(struct uclass *uc, ofnode node)
+{
+	/* Mix in the higher bits, since node pointers are aligned */
+	ulong key = (ulong)node.of_offset;
+
+	key ^= (key >> 4) ^ (key >> 9) ^ (key >> 16);
+
+	return &uc->hash->node[key & (DM_UCLASS_HASH_SIZE - 1)];
+}
+#endif
+
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+static uint uclass_steps;
+
+uint uclass_lookup_steps(bool reset)
+{
+	uint steps = uclass_steps;
+
+	if (reset)
+		uclass_steps = 0;
+
+	return steps;
+}
+
+#define uclass_lookup_step()	uclass_steps++
+#else
+#define uclass_lookup_step()
+#endif
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	list_del_init(&dev->seq_hash_node);
+	if (seq != -1 && dev->uclass->hash)
+		list_add_tail(&dev->seq_hash_node,
+			      uclass_seq_bucket(dev->uclass, seq));
+#endif
+	dev->seq = seq;
+}
+
+void uclass_update_ofnode(struct udevice *dev)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/* Nothing to do if the device is not in its uclass's table yet */
+	if (list_empty(&dev->node_hash_node))
+		return;
+	list_move_tail(&dev->node_hash_node,
+		       uclass_node_bucket(dev->uclass, dev->node));
+#endif
+}
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_index)
+		return key >= 0 && key < UCLASS_COUNT ?
+			gd->uclass_index[key] : NULL;
+#endif
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -51,6 +109,7 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 {
 	struct uclass_driver *uc_drv;
 	struct uclass *uc;
+	int __maybe_unused i;
 	int ret;
 
 	*ucp = NULL;
@@ -65,11 +124,11 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 		 */
 		return -EPFNOSUPPORT;
 	}
-	uc = calloc(1, sizeof(*uc));
+	uc = dm_slab_alloc(sizeof(*uc));
 	if (!uc)
 		return -ENOMEM;
 	if (uc_drv->priv_auto_alloc_size) {
-		uc->priv = calloc(1, uc_drv->priv_auto_alloc_size);
+		uc->priv = dm_slab_alloc(uc_drv->priv_auto_alloc_size);
 		if (!uc->priv) {
 			ret = -ENOMEM;
 			goto fail_mem;
@@ -78,6 +137,20 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	uc->uc_drv = uc_drv;
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/*
+	 * The pre-relocation malloc() area is too small for the tables. If
+	 * they cannot be allocated, lookups walk the list instead.
+	 */
+	if (gd->flags & GD_FLG_RELOC)
+		uc->hash = dm_slab_alloc(sizeof(*uc->hash));
+	for (i = 0; uc->hash && i < DM_UCLASS_HASH_SIZE; i++) {
+		INIT_LIST_HEAD(&uc->hash->seq[i]);
+		INIT_LIST_HEAD(&uc->hash->node[i]);
+	}
+	if (gd->uclass_index)
+		gd->uclass_index[id] = uc;
+#endif
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
 
 	if (uc_drv->init) {
@@ -91,12 +164,17 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	return 0;
 fail:
 	if (uc_drv->priv_auto_alloc_size) {
-		free(uc->priv);
+		dm_slab_free(uc->priv, uc_drv->priv_auto_alloc_size);
 		uc->priv = NULL;
 	}
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_index)
+		gd->uclass_index[id] = NULL;
+	dm_slab_free(uc->hash, sizeof(*uc->hash));
+#endif
 	list_del(&uc->sibling_node);
 fail_mem:
-	free(uc);
+	dm_slab_free(uc, sizeof(*uc));
 
 	return ret;
 }
@@ -127,10 +205,15 @@ int uclass_destroy(struct uclass *uc)
 	uc_drv = uc->uc_drv;
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_index)
+		gd->uclass_index[uc_drv->id] = NULL;
+	dm_slab_free(uc->hash, sizeof(*uc->hash));
+#endif
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
-		free(uc->priv);
-	free(uc);
+		dm_slab_free(uc->priv, uc_drv->priv_auto_alloc_size);
+	dm_slab_free(uc, sizeof(*uc));
 
 	return 0;
 }
@@ -308,7 +391,24 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (!find_req_seq && uc->hash) {
+		list_for_each_entry(dev, uclass_seq_bucket(uc, seq_or_req_seq),
+				    seq_hash_node) {
+			uclass_lookup_step();
+			if (dev->seq == seq_or_req_seq) {
+				*devp = dev;
+				debug("   - found '%s'\n", dev->name);
+				return 0;
+			}
+		}
+		debug("   - not found\n");
+
+		return -ENODEV;
+	}
+#endif
 	uclass_foreach_dev(dev, uc) {
+		uclass_lookup_step();
 		debug("   - %d %d '%s'\n", dev->req_seq, dev->seq, dev->name);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
 				seq_or_req_seq) {
@@ -361,7 +461,22 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->hash) {
+		list_for_each_entry(dev, uclass_node_bucket(uc, node),
+				    node_hash_node) {
+			uclass_lookup_step();
+			if (ofnode_equal(dev_ofnode(dev), node)) {
+				*devp = dev;
+				goto done;
+			}
+		}
+		ret = -ENODEV;
+		goto done;
+	}
+#endif
 	uclass_foreach_dev(dev, uc) {
+		uclass_lookup_step();
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
 		if (ofnode_equal(dev_ofnode(dev), node)) {
@@ -390,6 +505,10 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
 	find_phandle = dev_read_u32_default(parent, name, -1);
 	if (find_phandle <= 0)
 		return -ENOENT;
+	/* Phandles are unique, so the device must be the one for this node */
+	if (CONFIG_IS_ENABLED(DM_UCLASS_INDEX))
+		return uclass_find_device_by_ofnode(id,
+				ofnode_get_by_phandle(find_phandle), devp);
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
@@ -631,6 +750,11 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->hash)
+		list_add_tail(&dev->node_hash_node,
+			      uclass_node_bucket(uc, dev->node));
+#endif
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -646,6 +770,9 @@ int uclass_bind_device(struct udevice *dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	list_del_init(&dev->node_hash_node);
+#endif
 
 	return ret;
 }
@@ -664,6 +791,10 @@ int uclass_unbind_device(struct udevice *dev)
 	}
 
 	list_del(&dev->uclass_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	list_del_init(&dev->seq_hash_node);
+	list_del_init(&dev->node_hash_node);
+#endif
 	return 0;
 }
 #endif
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox device which takes a while to become ready
+ *
+ * This stands in for hardware which must be waited for after it is started,
+ * such as a card powering up, so that devices finishing their probe in the
+ * background can be tried out on sandbox. Each device waits for the time in
+ * its "delay-ms" property.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+
+struct sandbox_async_priv {
+	ulong start;
+	uint delay_ms;
+};
+
+static int sandbox_async_poll(struct udevice *dev)
+{
+	struct sandbox_async_priv *priv = dev_get_priv(dev);
+
+	if (get_timer(priv->start) < priv->delay_ms)
+		return -EAGAIN;
+
+	return 0;
+}
+
+static int sandbox_async_probe(struct udevice *dev)
+{
+	struct sandbox_async_priv *priv = dev_get_priv(dev);
+
+	priv->delay_ms = dev_read_u32_default(dev, "delay-ms", 0);
+	priv->start = get_timer(0);
+
+	return device_async_start(dev, sandbox_async_poll);
+}
+
+int sandbox_async_start_all(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_MISC, &uc);
+	if (ret)
+		return ret;
+	uclass_foreach_dev(dev, uc) {
+		if (dev->driver != DM_GET_DRIVER(sandbox_async))
+			continue;
+		ret = device_probe(dev);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct udevice_id sandbox_async_ids[] = {
+	{ .compatible = "sandbox,async-delay" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_async) = {
+	.name		= "sandbox_async",
+	.id		= UCLASS_MISC,
+	.of_match	= sandbox_async_ids,
+	.probe		= sandbox_async_probe,
+	.priv_auto_alloc_size	= sizeof(struct sandbox_async_priv),
+};
@@ -19,8 +19,9 @@ struct sandbox_mmc_plat {
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate an SD card version 2. Block 0 starts with a test string and
+ * all other data is zero. Each block reads the same whether it is read on
+ * its own or with others, since the block cache may hold either.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
@@ -54,10 +55,10 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
-		memset(data->dest, '\0', data->blocksize);
-		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+		memset(data->dest, '\0', data->blocksize * data->blocks);
+		if (!cmd->cmdarg)
+			strcpy(data->dest, "this is a test");
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
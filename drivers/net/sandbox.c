@@ -10,6 +10,7 @@
 #include <dm.h>
 #include <malloc.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <asm/eth.h>
 #include <asm/test.h>
 
@@ -47,6 +48,34 @@ void sandbox_eth_skip_timeout(void)
 	skip_timeout = true;
 }
 
+/*
+ * sb_eth_recv_slot()
+ *
+ * Get the buffer at the tail of the receive ring, to fill with a packet
+ *
+ * returns the buffer, or NULL if the ring is full
+ */
+static void *sb_eth_recv_slot(struct eth_sandbox_priv *priv)
+{
+	if (priv->recv_packets >= PKTBUFSRX)
+		return NULL;
+
+	return priv->recv_packet_buffer[(priv->recv_head + priv->recv_packets) %
+					PKTBUFSRX];
+}
+
+/*
+ * sb_eth_recv_queue()
+ *
+ * Add the packet just written to sb_eth_recv_slot() to the receive ring
+ */
+static void sb_eth_recv_queue(struct eth_sandbox_priv *priv, int len)
+{
+	priv->recv_packet_length[(priv->recv_head + priv->recv_packets) %
+				 PKTBUFSRX] = len;
+	++priv->recv_packets;
+}
+
 /*
  * sandbox_eth_arp_req_to_reply()
  *
@@ -72,14 +101,14 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
 		return 0;
 
 	/* store this as the assumed IP of the fake host */
 	priv->fake_host_ipaddr = net_read_ip(&arp->ar_tpa);
 
 	/* Formulate a fake response */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
 	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
 	eth_recv->et_protlen = htons(PROT_ARP);
@@ -95,9 +124,7 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 	memcpy(&arp_recv->ar_tha, &arp->ar_sha, ARP_HLEN);
 	net_copy_ip(&arp_recv->ar_tpa, &arp->ar_spa);
 
-	priv->recv_packet_length[priv->recv_packets] =
-		ETHER_HDR_SIZE + ARP_HDR_SIZE;
-	++priv->recv_packets;
+	sb_eth_recv_queue(priv, ETHER_HDR_SIZE + ARP_HDR_SIZE);
 
 	return 0;
 }
@@ -134,11 +161,11 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
 		return 0;
 
 	/* reply to the ping */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
 	memcpy(eth_recv, packet, len);
 	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
 	icmpr = (struct icmp_hdr *)&ipr->udp_src;
@@ -154,8 +181,7 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 	icmpr->checksum = 0;
 	icmpr->checksum = compute_ip_checksum(icmpr, ICMP_HDR_SIZE);
 
-	priv->recv_packet_length[priv->recv_packets] = len;
-	++priv->recv_packets;
+	sb_eth_recv_queue(priv, len);
 
 	return 0;
 }
@@ -174,11 +200,11 @@ int sandbox_eth_recv_arp_req(struct udevice *dev)
 	struct arp_hdr *arp_recv;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
 		return -EOVERFLOW;
 
 	/* Formulate a fake request */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
 	memcpy(eth_recv->et_dest, net_bcast_ethaddr, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
 	eth_recv->et_protlen = htons(PROT_ARP);
@@ -194,9 +220,7 @@ int sandbox_eth_recv_arp_req(struct udevice *dev)
 	memcpy(&arp_recv->ar_tha, net_null_ethaddr, ARP_HLEN);
 	net_write_ip(&arp_recv->ar_tpa, net_ip);
 
-	priv->recv_packet_length[priv->recv_packets] =
-		ETHER_HDR_SIZE + ARP_HDR_SIZE;
-	++priv->recv_packets;
+	sb_eth_recv_queue(priv, ETHER_HDR_SIZE + ARP_HDR_SIZE);
 
 	return 0;
 }
@@ -216,12 +240,11 @@ int sandbox_eth_recv_ping_req(struct udevice *dev)
 	struct icmp_hdr *icmpr;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
 		return -EOVERFLOW;
 
 	/* Formulate a fake ping */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
-
 	memcpy(eth_recv->et_dest, net_ethaddr, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
 	eth_recv->et_protlen = htons(PROT_IP);
@@ -245,9 +268,244 @@ int sandbox_eth_recv_ping_req(struct udevice *dev)
 	icmpr->un.echo.sequence = htons(1);
 	icmpr->checksum = compute_ip_checksum(icmpr, ICMP_HDR_SIZE);
 
-	priv->recv_packet_length[priv->recv_packets] =
-		ETHER_HDR_SIZE + IP_ICMP_HDR_SIZE;
-	++priv->recv_packets;
+	sb_eth_recv_queue(priv, ETHER_HDR_SIZE + IP_ICMP_HDR_SIZE);
+
+	return 0;
+}
+
+/*
+ * sandbox_eth_recv_udp()
+ *
+ * Inject a UDP packet for this target, with len bytes of data. The data is
+ * whatever was left in the buffer.
+ *
+ * returns 0 if injected, -EOVERFLOW if not
+ */
+int sandbox_eth_recv_udp(struct udevice *dev, int dport, int sport, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Don't allow the buffer to overrun */
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
+		return -EOVERFLOW;
+
+	memcpy(eth_recv->et_dest, net_ethaddr, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	ipr->ip_hl_v = 0x45;
+	ipr->ip_tos = 0;
+	ipr->ip_len = htons(IP_UDP_HDR_SIZE + len);
+	ipr->ip_id = 0;
+	ipr->ip_off = htons(IP_FLAGS_DFRAG);
+	ipr->ip_ttl = 255;
+	ipr->ip_p = IPPROTO_UDP;
+	ipr->ip_sum = 0;
+	net_write_ip(&ipr->ip_src, priv->fake_host_ipaddr);
+	net_write_ip(&ipr->ip_dst, net_ip);
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+
+	ipr->udp_src = htons(sport);
+	ipr->udp_dst = htons(dport);
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+
+	sb_eth_recv_queue(priv, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len);
+
+	return 0;
+}
+
+/* Initial sequence number of the fake host, close to wrapping around */
+#define SB_TCP_ISN		0xfffff000
+#define SB_HTTP_HDR_MAX		80
+
+/*
+ * sb_http_header()
+ *
+ * Write the status line and headers of the fake HTTP server's response
+ *
+ * returns the number of bytes written
+ */
+static int sb_http_header(struct eth_sandbox_priv *priv, char *buf, int size)
+{
+	return snprintf(buf, size,
+			"HTTP/1.0 200 OK\r\nContent-Length: %d\r\n\r\n",
+			priv->http_len);
+}
+
+/*
+ * sb_tcp_send()
+ *
+ * Inject a TCP segment from the fake host, in answer to one sent by the target
+ *
+ * priv - device private data
+ * eth - Ethernet header of the segment from the target
+ * flags - TCP flags to send
+ * seq, ack - sequence and acknowledgement numbers to send
+ * offset, size - part of the HTTP response to send as data
+ *
+ * returns 0 if injected, -EOVERFLOW if not
+ */
+static int sb_tcp_send(struct eth_sandbox_priv *priv, struct ethernet_hdr *eth,
+		       u8 flags, u32 seq, u32 ack, int offset, int size)
+{
+	struct ip_tcp_hdr *ip = (void *)eth + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_tcp_hdr *ipr;
+	int hlen = IP_TCP_HDR_SIZE;
+	char hdr[SB_HTTP_HDR_MAX];
+	uchar *data;
+	__be32 pseudo[3];
+	int hdr_len;
+
+	/* Don't allow the buffer to overrun */
+	eth_recv = sb_eth_recv_slot(priv);
+	if (!eth_recv)
+		return -EOVERFLOW;
+
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	data = (uchar *)ipr + IP_TCP_HDR_SIZE;
+	if (flags & TCP_SYN) {
+		/* Offer the largest MSS and a window scale of 0 */
+		data[0] = TCP_O_MSS;
+		data[1] = 4;
+		data[2] = TCP_MSS >> 8;
+		data[3] = TCP_MSS & 0xff;
+		data[4] = TCP_O_NOP;
+		data[5] = TCP_O_WS;
+		data[6] = 3;
+		data[7] = 0;
+		hlen += TCP_SYN_OPT_SIZE;
+	}
+
+	/* The response is the headers followed by the body */
+	hdr_len = sb_http_header(priv, hdr, sizeof(hdr));
+	data = (uchar *)ipr + hlen;
+	if (offset < hdr_len) {
+		int count = min(size, hdr_len - offset);
+
+		memcpy(data, hdr + offset, count);
+		memcpy(data + count, priv->http_body, size - count);
+	} else {
+		memcpy(data, priv->http_body + offset - hdr_len, size);
+	}
+
+	ipr->ip_hl_v = 0x45;
+	ipr->ip_tos = 0;
+	ipr->ip_len = htons(hlen + size);
+	ipr->ip_id = 0;
+	ipr->ip_off = htons(IP_FLAGS_DFRAG);
+	ipr->ip_ttl = 255;
+	ipr->ip_p = IPPROTO_TCP;
+	ipr->ip_sum = 0;
+	net_write_ip(&ipr->ip_src, priv->fake_host_ipaddr);
+	net_copy_ip(&ipr->ip_dst, &ip->ip_src);
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+
+	ipr->tcp_src = ip->tcp_dst;
+	ipr->tcp_dst = ip->tcp_src;
+	ipr->tcp_seq = htonl(seq);
+	ipr->tcp_ack = htonl(ack);
+	ipr->tcp_hlen = (hlen - IP_HDR_SIZE) << 2;
+	ipr->tcp_flags = flags;
+	ipr->tcp_win = htons(0xffff);
+	ipr->tcp_xsum = 0;
+	ipr->tcp_ugr = 0;
+
+	/* Checksum over the pseudo header and the segment */
+	pseudo[0] = ipr->ip_src.s_addr;
+	pseudo[1] = ipr->ip_dst.s_addr;
+	pseudo[2] = htonl(IPPROTO_TCP << 16 | (hlen - IP_HDR_SIZE + size));
+	ipr->tcp_xsum = add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&ipr->tcp_src,
+						    hlen - IP_HDR_SIZE + size));
+
+	sb_eth_recv_queue(priv, ETHER_HDR_SIZE + hlen + size);
+
+	return 0;
+}
+
+/*
+ * sandbox_eth_tcp_req_to_reply()
+ *
+ * Act as an HTTP server, if one was set up with sandbox_eth_set_http(). Any
+ * GET request is answered with the body given there, followed by a FIN.
+ *
+ * returns 0 if handled, -EAGAIN if not
+ */
+int sandbox_eth_tcp_req_to_reply(struct udevice *dev, void *packet,
+				 unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *ip;
+	int hlen, data_len, resp_len;
+	char hdr[SB_HTTP_HDR_MAX];
+	u32 seq, ack, acked;
+	u8 flags;
+
+	if (!priv->http_body || ntohs(eth->et_protlen) != PROT_IP)
+		return -EAGAIN;
+
+	ip = packet + ETHER_HDR_SIZE;
+
+	if (ip->ip_p != IPPROTO_TCP)
+		return -EAGAIN;
+
+	flags = ip->tcp_flags;
+	hlen = (ip->tcp_hlen >> 4) * 4;
+	data_len = ntohs(ip->ip_len) - IP_HDR_SIZE - hlen;
+	seq = ntohl(ip->tcp_seq);
+	ack = ntohl(ip->tcp_ack);
+
+	if (flags & TCP_RST)
+		return 0;
+	if (flags & TCP_SYN) {
+		priv->http_req = false;
+		priv->http_sent = 0;
+		sb_tcp_send(priv, eth, TCP_SYN | TCP_ACK, SB_TCP_ISN, seq + 1,
+			    0, 0);
+		return 0;
+	}
+	if (!(flags & TCP_ACK))
+		return 0;
+
+	if (data_len > 0 && !priv->http_req) {
+		if (strncmp((char *)ip + IP_HDR_SIZE + hlen, "GET ", 4))
+			return 0;
+		priv->http_req = true;
+	}
+	if (!priv->http_req)
+		return 0;
+
+	/* Keep two segments in flight, as far as the ring allows */
+	resp_len = priv->http_len + sb_http_header(priv, hdr, sizeof(hdr));
+	acked = ack - SB_TCP_ISN - 1;
+	seq += data_len;
+	while (priv->http_sent < resp_len &&
+	       priv->http_sent - acked < 2 * TCP_MSS) {
+		int size = min(resp_len - priv->http_sent, (int)TCP_MSS);
+
+		if (sb_tcp_send(priv, eth, TCP_ACK | TCP_PUSH,
+				SB_TCP_ISN + 1 + priv->http_sent, seq,
+				priv->http_sent, size))
+			break;
+		priv->http_sent += size;
+	}
+
+	/* Close once everything has arrived */
+	if (acked == resp_len)
+		sb_tcp_send(priv, eth, TCP_FIN | TCP_ACK,
+			    SB_TCP_ISN + 1 + resp_len, seq, 0, 0);
 
 	return 0;
 }
@@ -268,6 +526,8 @@ static int sb_default_handler(struct udevice *dev, void *packet,
 		return 0;
 	if (!sandbox_eth_ping_req_to_reply(dev, packet, len))
 		return 0;
+	if (!sandbox_eth_tcp_req_to_reply(dev, packet, len))
+		return 0;
 
 	return 0;
 }
@@ -318,12 +578,39 @@ void sandbox_eth_set_priv(int index, void *priv)
 	dev_priv->priv = priv;
 }
 
+/*
+ * sandbox_eth_set_http()
+ *
+ * Serve a file over HTTP from the fake host
+ *
+ * index - interface to serve the file on
+ * body - contents of the file, or NULL to stop serving it
+ * len - length of the file in bytes
+ */
+void sandbox_eth_set_http(int index, const void *body, int len)
+{
+	struct udevice *dev;
+	struct eth_sandbox_priv *priv;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_ETH, index, &dev);
+	if (ret)
+		return;
+
+	priv = dev_get_priv(dev);
+	priv->http_body = body;
+	priv->http_len = len;
+	priv->http_req = false;
+	priv->http_sent = 0;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
 
 	debug("eth_sandbox: Start\n");
 
+	priv->recv_head = 0;
 	priv->recv_packets = 0;
 	for (int i = 0; i < PKTBUFSRX; i++) {
 		priv->recv_packet_buffer[i] = net_rx_packets[i];
@@ -355,11 +642,12 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	}
 
 	if (priv->recv_packets) {
-		int lcl_recv_packet_length = priv->recv_packet_length[0];
+		int lcl_recv_packet_length =
+			priv->recv_packet_length[priv->recv_head];
 
 		debug("eth_sandbox: received packet[%d], %d waiting\n",
 		      lcl_recv_packet_length, priv->recv_packets - 1);
-		*packetp = priv->recv_packet_buffer[0];
+		*packetp = priv->recv_packet_buffer[priv->recv_head];
 		return lcl_recv_packet_length;
 	}
 	return 0;
@@ -368,19 +656,14 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
-	int i;
 
 	if (!priv->recv_packets)
 		return 0;
 
+	/* The buffer goes back to the ring, so nothing is copied */
+	priv->recv_packet_length[priv->recv_head] = 0;
+	priv->recv_head = (priv->recv_head + 1) % PKTBUFSRX;
 	--priv->recv_packets;
-	for (i = 0; i < priv->recv_packets; i++) {
-		priv->recv_packet_length[i] = priv->recv_packet_length[i + 1];
-		memcpy(priv->recv_packet_buffer[i],
-		       priv->recv_packet_buffer[i + 1],
-		       priv->recv_packet_length[i + 1]);
-	}
-	priv->recv_packet_length[priv->recv_packets] = 0;
 
 	return 0;
 }
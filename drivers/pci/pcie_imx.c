@@ -40,6 +40,9 @@
 #define MX6_MEM_SIZE	0xe00000
 #define MX6_ROOT_SIZE	0xfc000
 
+/* Time allowed for the link to come up */
+#define IMX_PCIE_LINK_TIMEOUT_MS	40
+
 /* PCIe Port Logic registers (memory-mapped) */
 #define PL_OFFSET 0x700
 #define PCIE_PL_PFLR (PL_OFFSET + 0x08)
@@ -96,6 +99,7 @@
 struct imx_pcie_priv {
 	void __iomem		*dbi_base;
 	void __iomem		*cfg_base;
+	ulong			link_start;	/* get_timer() value */
 };
 
 /*
@@ -613,11 +617,11 @@ static int imx6_pcie_deassert_core_reset(void)
 	return 0;
 }
 
-static int imx_pcie_link_up(struct imx_pcie_priv *priv)
+/* Start the controller and begin training the link */
+static void imx_pcie_link_start(struct imx_pcie_priv *priv)
 {
 	struct iomuxc *iomuxc_regs = (struct iomuxc *)IOMUXC_BASE_ADDR;
 	uint32_t tmp;
-	int count = 0;
 
 	imx6_pcie_assert_core_reset(priv, false);
 	imx6_pcie_init_phy();
@@ -649,25 +653,37 @@ static int imx_pcie_link_up(struct imx_pcie_priv *priv)
 
 	/* LTSSM enable, starting link. */
 	setbits_le32(&iomuxc_regs->gpr[12], IOMUXC_GPR12_APPS_LTSSM_ENABLE);
+	priv->link_start = get_timer(0);
+}
+
+static int imx_pcie_link_failed(struct imx_pcie_priv *priv)
+{
+#ifdef CONFIG_PCI_SCAN_SHOW
+	puts("PCI:   pcie phy link never came up\n");
+#endif
+	debug("DEBUG_R0: 0x%08x, DEBUG_R1: 0x%08x\n",
+	      readl(priv->dbi_base + PCIE_PHY_DEBUG_R0),
+	      readl(priv->dbi_base + PCIE_PHY_DEBUG_R1));
+
+	return -EINVAL;
+}
+
+#if !CONFIG_IS_ENABLED(DM_PCI)
+static int imx_pcie_link_up(struct imx_pcie_priv *priv)
+{
+	int count = 0;
 
+	imx_pcie_link_start(priv);
 	while (!imx6_pcie_link_up(priv)) {
 		udelay(10);
 		count++;
-		if (count >= 4000) {
-#ifdef CONFIG_PCI_SCAN_SHOW
-			puts("PCI:   pcie phy link never came up\n");
-#endif
-			debug("DEBUG_R0: 0x%08x, DEBUG_R1: 0x%08x\n",
-			      readl(priv->dbi_base + PCIE_PHY_DEBUG_R0),
-			      readl(priv->dbi_base + PCIE_PHY_DEBUG_R1));
-			return -EINVAL;
-		}
+		if (count >= 4000)
+			return imx_pcie_link_failed(priv);
 	}
 
 	return 0;
 }
 
-#if !CONFIG_IS_ENABLED(DM_PCI)
 static struct imx_pcie_priv imx_pcie_priv = {
 	.dbi_base	= (void __iomem *)MX6_DBI_ADDR,
 	.cfg_base	= (void __iomem *)MX6_ROOT_ADDR,
@@ -779,11 +795,29 @@ static int imx_pcie_dm_write_config(struct udevice *dev, pci_dev_t bdf,
 	return imx_pcie_write_cfg(priv, bdf, offset, newval);
 }
 
+/*
+ * Check whether the link is up. Until it is, the rest of the boot carries on
+ * and the bus is not scanned.
+ */
+static int imx_pcie_dm_poll(struct udevice *dev)
+{
+	struct imx_pcie_priv *priv = dev_get_priv(dev);
+
+	if (imx6_pcie_link_up(priv))
+		return 0;
+	if (get_timer(priv->link_start) < IMX_PCIE_LINK_TIMEOUT_MS)
+		return -EAGAIN;
+
+	return imx_pcie_link_failed(priv);
+}
+
 static int imx_pcie_dm_probe(struct udevice *dev)
 {
 	struct imx_pcie_priv *priv = dev_get_priv(dev);
 
-	return imx_pcie_link_up(priv);
+	imx_pcie_link_start(priv);
+
+	return device_async_start(dev, imx_pcie_dm_poll);
 }
 
 static int imx_pcie_dm_remove(struct udevice *dev)
@@ -1627,6 +1627,101 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * ext4fs_map_extent() - look up a file block in the extent tree of an inode
+ *
+ * @inode: inode of the file, which must use extents
+ * @fileblock: logical block within the file
+ * @cache: extent block cache to use, or NULL
+ * @runp: returns the number of blocks from @fileblock onwards which are
+ *	physically contiguous, or which are all part of the same hole
+ * @return physical block number, 0 for a hole, or -ve on error
+ */
+static long int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+				  struct ext_block_cache *cache,
+				  long int *runp)
+{
+	long int startblock, endblock;
+	struct ext_block_cache *c, cd;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	if (cache) {
+		c = cache;
+	} else {
+		c = &cd;
+		ext_cache_init(c);
+	}
+	ext_block =
+		ext4fs_get_extent_block(ext4fs_root, c,
+					(struct ext4_extent_header *)
+					inode->b.blocks.dir_blocks,
+					fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		if (!cache)
+			ext_cache_fini(c);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	/* A hole after the last extent in this leaf ends who knows where */
+	*runp = 1;
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			*runp = startblock - fileblock;
+			if (!cache)
+				ext_cache_fini(c);
+			return 0;
+
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*runp = endblock - fileblock;
+			if (!cache)
+				ext_cache_fini(c);
+			return (fileblock - startblock) + start;
+		}
+	}
+
+	if (!cache)
+		ext_cache_fini(c);
+	return 0;
+}
+
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    struct ext_block_cache *cache, long int *blknrp)
+{
+	long int run;
+
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
+		*blknrp = ext4fs_map_extent(inode, fileblock, cache, &run);
+		if (*blknrp < 0)
+			return *blknrp;
+
+		return run;
+	}
+
+	/* Contiguous indirect blocks are merged by the caller */
+	*blknrp = read_allocated_block(inode, fileblock, cache);
+	if (*blknrp < 0)
+		return *blknrp;
+
+	return 1;
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1637,62 +1732,15 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
-				return 0;
-
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
-				return (fileblock - startblock) + start;
-			}
-		}
+		long int run;
 
-		if (!cache)
-			ext_cache_fini(c);
-		return 0;
+		return ext4fs_map_extent(inode, fileblock, cache, &run);
 	}
 
 	/* Direct blocks. */
@@ -44,27 +44,27 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Each extent is looked up once and the file is read one physically
+ * contiguous run at a time, straight into the caller's buffer.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
-	lbaint_t blockcnt;
+	lbaint_t i, blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
 	unsigned int filesize = le32_to_cpu(node->inode.size);
-	lbaint_t previous_block_number = -1;
 	lbaint_t delayed_start = 0;
-	lbaint_t delayed_extent = 0;
-	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
+	int delayed_extent = 0;
+	int delayed_skipfirst = 0;
 	char *delayed_buf = NULL;
-	short status;
+	long int blknr, run;
 	struct ext_block_cache cache;
-
-	ext_cache_init(&cache);
+	int ret = -1;
 
 	if (blocksize <= 0)
 		return -1;
@@ -73,105 +73,68 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	if (len + pos > filesize)
 		len = (filesize - pos);
 
+	ext_cache_init(&cache);
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
-		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+	for (i = lldiv(pos, blocksize); i < blockcnt; i += run) {
+		loff_t off = (loff_t)i * blocksize;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
-		if (blknr < 0) {
-			ext_cache_fini(&cache);
-			return -1;
-		}
-
-		blknr = blknr << log2_fs_blocksize;
-
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		loff_t n;
+
+		run = read_allocated_run(&node->inode, i, &cache, &blknr);
+		if (run <= 0)
+			goto out;
+		if (run > blockcnt - i)
+			run = blockcnt - i;
+		/* ext4fs_devread() takes an int length */
+		if (run > INT_MAX / blocksize)
+			run = INT_MAX / blocksize;
+
+		/* Bytes of the run that fall within the request */
+		if (off < pos)
+			skipfirst = pos - off;
+		n = min((loff_t)run * blocksize, pos + len - off) - skipfirst;
 
-		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
-		}
 		if (blknr) {
-			int status;
-
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-					if (status == 0) {
-						ext_cache_fini(&cache);
-						return -1;
-					}
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
-				}
+			blknr <<= log2_fs_blocksize;
+			if (delayed_extent && delayed_next == blknr &&
+			    delayed_extent + n <= INT_MAX) {
+				delayed_extent += n;
 			} else {
-				previous_block_number = blknr;
+				/* spill */
+				if (delayed_extent &&
+				    !ext4fs_devread(delayed_start,
+						    delayed_skipfirst,
+						    delayed_extent,
+						    delayed_buf))
+					goto out;
 				delayed_start = blknr;
-				delayed_extent = blockend;
+				delayed_extent = n;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
 			}
+			delayed_next = blknr + (run << log2_fs_blocksize);
 		} else {
-			int n;
-			if (previous_block_number != -1) {
-				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-				if (status == 0) {
-					ext_cache_fini(&cache);
-					return -1;
-				}
-				previous_block_number = -1;
-			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			if (n > len)
-				n = len;
+			/* spill, since the buffer is not contiguous now */
+			if (delayed_extent &&
+			    !ext4fs_devread(delayed_start, delayed_skipfirst,
+					    delayed_extent, delayed_buf))
+				goto out;
+			delayed_extent = 0;
 			memset(buf, 0, n);
 		}
-		buf += blocksize - skipfirst;
-	}
-	if (previous_block_number != -1) {
-		/* spill */
-		status = ext4fs_devread(delayed_start,
-					delayed_skipfirst, delayed_extent,
-					delayed_buf);
-		if (status == 0) {
-			ext_cache_fini(&cache);
-			return -1;
-		}
-		previous_block_number = -1;
+		buf += n;
 	}
+	if (delayed_extent &&
+	    !ext4fs_devread(delayed_start, delayed_skipfirst, delayed_extent,
+			    delayed_buf))
+		goto out;
 
 	*actread  = len;
+	ret = 0;
+out:
 	ext_cache_fini(&cache);
-	return 0;
+	return ret;
 }
 
 int ext4fs_ls(const char *dirname)
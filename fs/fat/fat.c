@@ -155,15 +155,91 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 }
 #endif
 
+/*
+ * Read FAT buffer 'bufnum' into 'bufptr'.
+ * Return 0 on success, -1 on error.
+ */
+static int read_fatbuf(fsdata *mydata, __u32 bufnum, __u8 *bufptr)
+{
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 fatlength = mydata->fatlength;
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+
+	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	if (startblock + getsize > fatlength)
+		getsize = fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	if (disk_read(startblock, getsize, bufptr) < 0) {
+		debug("Error reading FAT blocks\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Return FAT buffer 'bufnum' from the cache of read-only FAT buffers,
+ * reading it into the least recently used one if it is not there.
+ * Return NULL on error.
+ */
+static __u8 *get_fatcache(fsdata *mydata, __u32 bufnum)
+{
+	__u32 tick = ++mydata->fatcache_tick;
+	int i, victim = 0;
+
+	for (i = 0; i < FATCACHEBUFS; i++) {
+		if (mydata->fatcache_num[i] == bufnum) {
+			mydata->fatcache_used[i] = tick;
+			return mydata->fatcache + i * FATBUFSIZE;
+		}
+		if (tick - mydata->fatcache_used[i] >
+		    tick - mydata->fatcache_used[victim])
+			victim = i;
+	}
+
+	mydata->fatcache_num[victim] = -1;
+	if (read_fatbuf(mydata, bufnum, mydata->fatcache + victim * FATBUFSIZE))
+		return NULL;
+	mydata->fatcache_num[victim] = bufnum;
+	mydata->fatcache_used[victim] = tick;
+
+	return mydata->fatcache + victim * FATBUFSIZE;
+}
+
+/*
+ * Drop FAT buffer 'bufnum' from the cache of read-only FAT buffers, since it
+ * is about to be modified.
+ */
+static void __maybe_unused drop_fatcache(fsdata *mydata, __u32 bufnum)
+{
+	int i;
+
+	if (!mydata->fatcache)
+		return;
+
+	for (i = 0; i < FATCACHEBUFS; i++) {
+		if (mydata->fatcache_num[i] == bufnum)
+			mydata->fatcache_num[i] = -1;
+	}
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
+ *
+ * The FAT buffer being modified by the write code, if any, is used first.
+ * Other parts of the FAT are looked up in the cache of read-only FAT buffers
+ * if there is one, so that following a fragmented cluster chain does not
+ * re-read the same FAT sectors over and over.
  */
 static __u32 get_fatent(fsdata *mydata, __u32 entry)
 {
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
+	__u8 *fatbuf;
 
 	if (CHECK_CLUST(entry, mydata->fatsize)) {
 		printf("Error: Invalid FAT entry: 0x%08x\n", entry);
@@ -192,42 +268,37 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
+	if (bufnum == mydata->fatbufnum) {
+		fatbuf = mydata->fatbuf;
+	} else if (mydata->fatcache) {
+		fatbuf = get_fatcache(mydata, bufnum);
+		if (!fatbuf)
+			return ret;
+	} else {
+		/* Read a new block of FAT entries into the cache. */
+		fatbuf = mydata->fatbuf;
 
 		/* Write back the fatbuf to the disk */
 		if (flush_dirty_fat_buffer(mydata) < 0)
 			return -1;
 
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
+		if (read_fatbuf(mydata, bufnum, fatbuf))
 			return ret;
-		}
 		mydata->fatbufnum = bufnum;
 	}
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
 		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		ret = fatbuf[off8] + (fatbuf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -239,6 +310,9 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	return ret;
 }
 
+/* Largest bounce buffer used by get_cluster() for misaligned reads */
+#define FAT_BOUNCE_SIZE	(64 * 1024)
+
 /*
  * Read at most 'size' bytes from the specified cluster into 'buffer'.
  * Return 0 on success, -1 otherwise.
@@ -248,6 +322,8 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 {
 	__u32 idx = 0;
 	__u32 startsect;
+	__u32 nsects;
+	__u8 *bounce;
 	int ret;
 
 	if (clustnum > 0) {
@@ -263,17 +339,39 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/*
+		 * Read through a bounce buffer as many sectors at a time as
+		 * will fit, or one sector at a time if there is no memory.
+		 */
+		nsects = min_t(unsigned long, size, FAT_BOUNCE_SIZE) /
+			 mydata->sect_size;
+		bounce = nsects > 1 ? malloc_cache_aligned(nsects *
+							   mydata->sect_size) :
+			 NULL;
+		if (!bounce) {
+			bounce = tmpbuf;
+			nsects = 1;
+		}
+
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min_t(unsigned long, nsects,
+				    size / mydata->sect_size);
+			ret = disk_read(startsect, idx, bounce);
+			if (ret != idx) {
 				debug("Error reading data (got %d)\n", ret);
+				if (bounce != tmpbuf)
+					free(bounce);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			memcpy(buffer, bounce, idx);
+			buffer += idx;
+			size -= idx;
 		}
+		if (bounce != tmpbuf)
+			free(bounce);
 	} else {
 		idx = size / mydata->sect_size;
 		ret = disk_read(startsect, idx, buffer);
@@ -414,7 +512,8 @@ getit:
 		filesize -= actsize;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
+		/* newclust already holds the FAT entry following endclust */
+		curclust = newclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
@@ -546,7 +645,7 @@ static int get_fs_info(fsdata *mydata)
 {
 	boot_sector bs;
 	volume_info volinfo;
-	int ret;
+	int ret, i;
 
 	ret = read_bootsectandvi(&bs, &volinfo, &mydata->fatsize);
 	if (ret) {
@@ -613,11 +712,26 @@ static int get_fs_info(fsdata *mydata)
 
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
-	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+	/*
+	 * The read-only FAT buffers share one allocation with fatbuf, so that
+	 * freeing fatbuf frees them too.
+	 */
+	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE * (1 + FATCACHEBUFS));
+	if (mydata->fatbuf) {
+		mydata->fatcache = mydata->fatbuf + FATBUFSIZE;
+	} else {
+		mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+		mydata->fatcache = NULL;
+	}
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
+	for (i = 0; i < FATCACHEBUFS; i++) {
+		mydata->fatcache_num[i] = -1;
+		mydata->fatcache_used[i] = 0;
+	}
+	mydata->fatcache_tick = 0;
 
 	debug("FAT%d, fat_sect: %d, fatlength: %d\n",
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
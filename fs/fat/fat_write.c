@@ -298,6 +298,9 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		if (flush_dirty_fat_buffer(mydata) < 0)
 			return -1;
 
+		/* This buffer is about to change, drop any read-only copy */
+		drop_fatcache(mydata, bufnum);
+
 		startblock += mydata->fat_sect;
 
 		if (disk_read(startblock, getsize, bufptr) < 0) {
@@ -1232,7 +1235,8 @@ static int fat_dir_entries(fat_itr *itr)
 	fat_itr_child(dirs, itr);
 	fsdata = *dirs->fsdata;
 
-	/* allocate local fat buffer */
+	/* allocate local fat buffer, without read-only FAT buffers */
+	fsdata.fatcache = NULL;
 	fsdata.fatbuf = malloc_cache_aligned(FATBUFSIZE);
 	if (!fsdata.fatbuf) {
 		debug("Error: allocating memory\n");
@@ -18,6 +18,9 @@
 #include <div64.h>
 #include <linux/math64.h>
 #include <efi_loader.h>
+#include <malloc.h>
+#include <u-boot/zlib.h>
+#include <linux/zstd.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -471,11 +474,12 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
-		return 0;
+	ret = lmb_alloc_addr(&lmb, addr, read_len) == addr ? 0 : -ENOSPC;
+	lmb_uninit(&lmb);
+	if (ret)
+		printf("** Reading file would overwrite reserved memory **\n");
 
-	printf("** Reading file would overwrite reserved memory **\n");
-	return -ENOSPC;
+	return ret;
 }
 #endif
 
@@ -725,6 +729,425 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_CMD_LOADZ
+/*
+ * loadz reads the compressed file through a buffer of LOADZ_CHUNK_SIZE bytes,
+ * decompressing each chunk to the load address before reading the next one.
+ * The buffer grows up to LOADZ_CHUNK_MAX if a single LZ4 block does not fit.
+ */
+#define LOADZ_CHUNK_SIZE	(1 << 20)
+#define LOADZ_CHUNK_MAX		(8 << 20)
+
+struct loadz_state {
+	void *dst;		/* where to decompress to */
+	ulong dst_len;		/* room at dst */
+	ulong out;		/* number of bytes decompressed so far */
+#ifdef CONFIG_GZIP
+	z_stream zs;
+#endif
+#ifdef CONFIG_LZ4
+	struct ulz4_stream lz4;
+#endif
+#ifdef CONFIG_ZSTD
+	ZSTD_DStream *zds;
+	void *workspace;
+#endif
+};
+
+/**
+ * struct loadz_codec - a decompressor that can be fed a chunk at a time
+ *
+ * @init and @step return 1 at the end of the compressed data, 0 if they need
+ * more input and -ve on error. Both set *used to the number of input bytes
+ * they consumed; the rest is passed again, followed by more data, next time.
+ */
+struct loadz_codec {
+	const char *name;
+	u8 magic[4];
+	int magic_len;
+	int (*init)(struct loadz_state *st, const u8 *in, size_t len,
+		    size_t *used);
+	int (*step)(struct loadz_state *st, const u8 *in, size_t len,
+		    size_t *used);
+	void (*finish)(struct loadz_state *st);
+};
+
+#ifdef CONFIG_GZIP
+static int loadz_gzip_init(struct loadz_state *st, const u8 *in, size_t len,
+			   size_t *used)
+{
+	int offset = gzip_parse_header(in, len);
+
+	if (offset < 0)
+		return -EINVAL;
+
+	st->zs.zalloc = gzalloc;
+	st->zs.zfree = gzfree;
+	if (inflateInit2(&st->zs, -MAX_WBITS) != Z_OK)
+		return -ENOMEM;
+	*used = offset;
+
+	return 0;
+}
+
+static int loadz_gzip_step(struct loadz_state *st, const u8 *in, size_t len,
+			   size_t *used)
+{
+	z_stream *s = &st->zs;
+	int r;
+
+	s->next_in = (u8 *)in;
+	s->avail_in = len;
+	s->next_out = st->dst + st->out;
+	s->avail_out = min_t(ulong, st->dst_len - st->out, UINT_MAX);
+	r = inflate(s, Z_NO_FLUSH);
+	*used = len - s->avail_in;
+	st->out = s->next_out - (u8 *)st->dst;
+
+	switch (r) {
+	case Z_STREAM_END:
+		return 1;
+	case Z_OK:
+		return 0;
+	case Z_BUF_ERROR:
+		/* No progress: either out of input or out of room */
+		return s->avail_out ? 0 : -ENOBUFS;
+	default:
+		printf("Error: inflate() returned %d\n", r);
+		return -EIO;
+	}
+}
+
+static void loadz_gzip_finish(struct loadz_state *st)
+{
+	inflateEnd(&st->zs);
+}
+#endif
+
+#ifdef CONFIG_LZ4
+static int loadz_lz4_step(struct loadz_state *st, const u8 *in, size_t len,
+			  size_t *used)
+{
+	size_t out_len = st->dst_len - st->out;
+	int ret;
+
+	*used = len;
+	ret = ulz4fn_stream(&st->lz4, in, used, st->dst + st->out, &out_len);
+	st->out += out_len;
+
+	if (ret == -EAGAIN)
+		return 0;
+
+	return ret ? ret : 1;
+}
+#endif
+
+#ifdef CONFIG_ZSTD
+static int loadz_zstd_init(struct loadz_state *st, const u8 *in, size_t len,
+			   size_t *used)
+{
+	ZSTD_frameParams params;
+	size_t wsize;
+
+	if (ZSTD_getFrameParams(&params, in, len))
+		return -EINVAL;
+
+	wsize = ZSTD_DStreamWorkspaceBound(params.windowSize);
+	st->workspace = malloc(wsize);
+	if (!st->workspace)
+		return -ENOMEM;
+	st->zds = ZSTD_initDStream(params.windowSize, st->workspace, wsize);
+	if (!st->zds) {
+		free(st->workspace);
+		st->workspace = NULL;
+		return -EINVAL;
+	}
+	*used = 0;
+
+	return 0;
+}
+
+static int loadz_zstd_step(struct loadz_state *st, const u8 *in, size_t len,
+			   size_t *used)
+{
+	ZSTD_inBuffer in_buf = { .src = in, .size = len, .pos = 0 };
+	ZSTD_outBuffer out_buf = {
+		.dst = st->dst, .size = st->dst_len, .pos = st->out
+	};
+	size_t ret;
+
+	ret = ZSTD_decompressStream(st->zds, &out_buf, &in_buf);
+	*used = in_buf.pos;
+	st->out = out_buf.pos;
+	if (ZSTD_isError(ret)) {
+		printf("Error: ZSTD_decompressStream() returned %d\n",
+		       ZSTD_getErrorCode(ret));
+		return -EIO;
+	}
+	if (!ret)
+		return 1;
+
+	return out_buf.pos == out_buf.size ? -ENOBUFS : 0;
+}
+
+static void loadz_zstd_finish(struct loadz_state *st)
+{
+	free(st->workspace);
+}
+#endif
+
+static const struct loadz_codec loadz_codecs[] = {
+#ifdef CONFIG_GZIP
+	{
+		.name = "gzip",
+		.magic = { 0x1f, 0x8b },
+		.magic_len = 2,
+		.init = loadz_gzip_init,
+		.step = loadz_gzip_step,
+		.finish = loadz_gzip_finish,
+	},
+#endif
+#ifdef CONFIG_LZ4
+	{
+		.name = "lz4",
+		.magic = { 0x04, 0x22, 0x4d, 0x18 },
+		.magic_len = 4,
+		.step = loadz_lz4_step,
+	},
+#endif
+#ifdef CONFIG_ZSTD
+	{
+		.name = "zstd",
+		.magic = { 0x28, 0xb5, 0x2f, 0xfd },
+		.magic_len = 4,
+		.init = loadz_zstd_init,
+		.step = loadz_zstd_step,
+		.finish = loadz_zstd_finish,
+	},
+#endif
+};
+
+/*
+ * Read part of a file from the file system of type 'type' on the device
+ * last set by fs_set_blk_dev(). Each read ends with fs_close(), so the file
+ * system is probed again first.
+ */
+static int loadz_read(int type, const char *filename, void *buf, loff_t pos,
+		      loff_t len, loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(type);
+	int ret;
+
+	if (info->probe(fs_dev_desc, &fs_partition))
+		return -EIO;
+	fs_type = type;
+	ret = info->read(filename, buf, pos, len, actread);
+	fs_close();
+
+	return ret;
+}
+
+/*
+ * Read the compressed file 'filename' of 'size' bytes from a file system of
+ * type 'type' a chunk at a time, and decompress it into st->dst.
+ */
+static int loadz_file(int type, const char *filename, loff_t size,
+		      struct loadz_state *st, loff_t *len_read)
+{
+	const struct loadz_codec *codec = NULL;
+	ulong buf_size = LOADZ_CHUNK_SIZE;
+	size_t have = 0;
+	size_t used;
+	loff_t pos = 0;
+	loff_t got;
+	u8 *buf;
+	int ret;
+	int i;
+
+	buf = malloc(buf_size);
+	if (!buf)
+		return -ENOMEM;
+
+	while (1) {
+		/* Top up the buffer with the next part of the file */
+		if (pos < size && have < buf_size) {
+			ret = loadz_read(type, filename, buf + have, pos,
+					 min_t(loff_t, buf_size - have,
+					       size - pos), &got);
+			if (ret < 0)
+				break;
+			if (!got) {
+				ret = -EIO;
+				break;
+			}
+			pos += got;
+			have += got;
+		}
+
+		if (!codec) {
+			for (i = 0; i < ARRAY_SIZE(loadz_codecs); i++) {
+				if (have >= loadz_codecs[i].magic_len &&
+				    !memcmp(buf, loadz_codecs[i].magic,
+					    loadz_codecs[i].magic_len)) {
+					codec = &loadz_codecs[i];
+					break;
+				}
+			}
+			if (!codec) {
+				puts("** Unknown compression format **\n");
+				ret = -EPROTONOSUPPORT;
+				break;
+			}
+			debug("loadz: %s compressed\n", codec->name);
+			if (codec->init) {
+				ret = codec->init(st, buf, have, &used);
+				if (ret < 0) {
+					codec = NULL;
+					break;
+				}
+				have -= used;
+				memmove(buf, buf + used, have);
+			}
+		}
+
+		ret = codec->step(st, buf, have, &used);
+		if (ret)
+			break;
+		have -= used;
+		memmove(buf, buf + used, have);
+		if (used)
+			continue;
+
+		/* No progress: the buffer must be too small or data missing */
+		if (pos == size) {
+			puts("** Compressed data is truncated **\n");
+			ret = -EINVAL;
+			break;
+		}
+		if (have == buf_size) {
+			u8 *new_buf = NULL;
+
+			if (buf_size < LOADZ_CHUNK_MAX)
+				new_buf = realloc(buf, buf_size * 2);
+			if (!new_buf) {
+				ret = -EFBIG;
+				break;
+			}
+			buf = new_buf;
+			buf_size *= 2;
+		}
+	}
+
+	if (codec && codec->finish)
+		codec->finish(st);
+	free(buf);
+	*len_read = pos;
+
+	return ret < 0 ? ret : 0;
+}
+
+int do_loadz(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+	     int fstype)
+{
+	struct loadz_state st = { 0 };
+	unsigned long addr;
+	const char *addr_str;
+	const char *filename;
+	ulong max_len;
+	loff_t size;
+	loff_t len_read;
+	int type;
+	int ret;
+	unsigned long time;
+	char *ep;
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	phys_size_t free_len;
+#endif
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (argc > 6)
+		return CMD_RET_USAGE;
+
+	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
+		return 1;
+
+	if (argc >= 4) {
+		addr = simple_strtoul(argv[3], &ep, 16);
+		if (ep == argv[3] || *ep != '\0')
+			return CMD_RET_USAGE;
+	} else {
+		addr_str = env_get("loadaddr");
+		if (addr_str != NULL)
+			addr = simple_strtoul(addr_str, NULL, 16);
+		else
+			addr = CONFIG_SYS_LOAD_ADDR;
+	}
+	if (argc >= 5) {
+		filename = argv[4];
+	} else {
+		filename = env_get("bootfile");
+		if (!filename) {
+			puts("** No boot file defined **\n");
+			return 1;
+		}
+	}
+	if (argc >= 6)
+		max_len = simple_strtoul(argv[5], NULL, 16);
+	else
+		max_len = ULONG_MAX - addr;
+
+#ifdef CONFIG_LMB
+	/* The decompressed size is not known, so stop at reserved memory */
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	free_len = lmb_get_free_size(&lmb, addr);
+	lmb_uninit(&lmb);
+	if (!free_len) {
+		printf("** Reading file would overwrite reserved memory **\n");
+		return 1;
+	}
+	max_len = min_t(phys_size_t, max_len, free_len);
+#endif
+
+#ifdef CONFIG_CMD_BOOTEFI
+	efi_set_bootdev(argv[1], (argc > 2) ? argv[2] : "",
+			(argc > 4) ? argv[4] : "");
+#endif
+	time = get_timer(0);
+	/* fs_size() closes the file system, loadz_file() probes it again */
+	type = fs_type;
+	if (fs_size(filename, &size) < 0)
+		return 1;
+
+	st.dst = map_sysmem(addr, max_len);
+	st.dst_len = max_len;
+	ret = loadz_file(type, filename, size, &st, &len_read);
+	unmap_sysmem(st.dst);
+	time = get_timer(time);
+	if (ret) {
+		if (ret == -ENOBUFS)
+			puts("** Decompressed file does not fit **\n");
+		printf("** Unable to load %s: %d **\n", filename, ret);
+		return 1;
+	}
+
+	printf("%llu bytes read, %lu bytes decompressed in %lu ms", len_read,
+	       st.out, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(st.out, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", st.out);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_LOADZ */
+
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	int fstype)
 {
@@ -67,6 +67,9 @@ typedef struct global_data {
 	struct udevice	*dm_root;	/* Root instance for Driver Model */
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass	**uclass_index;	/* Uclasses indexed by ID */
+#endif
 #endif
 #ifdef CONFIG_TIMER
 	struct udevice	*timer;		/* Timer instance for Driver Model */
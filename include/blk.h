@@ -112,6 +112,10 @@ struct blk_desc {
 #define PAD_TO_BLOCKSIZE(size, blk_desc) \
 	(PAD_SIZE(size, blk_desc->blksz))
 
+/* Function used by the block cache to read blocks from a device */
+typedef ulong (*blkcache_read_t)(struct blk_desc *block_dev, lbaint_t start,
+				 lbaint_t blkcnt, void *buffer);
+
 #if CONFIG_IS_ENABLED(BLOCK_CACHE)
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
@@ -154,23 +158,62 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_read_through() - read blocks, using the cache where possible
+ *
+ * Blocks which are in the cache are copied from it. Each run of blocks
+ * which is not cached is read from the device with a single call to @read
+ * and then added to the cache.
+ *
+ * @param block_dev - block device to read from
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to read
+ * @param buffer - buffer to contain the data
+ * @param read - function to read blocks from the device
+ *
+ * @return - number of blocks read, or -ve error value from @read
+ */
+ulong blkcache_read_through(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer,
+			    blkcache_read_t read);
+
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * The cache is sized to hold @entries reads of @blocks blocks each. This
+ * discards the contents of the cache. It is reallocated with the new size
+ * the next time it is filled.
+ *
+ * @param blocks - maximum number of blocks in a read that is cached
+ * @param entries - number of such reads to make room for, 0 to disable
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
+/**
+ * blkcache_configure_size() - configure block cache by size
+ *
+ * This is like blkcache_configure() but sets the size of the cache in MiB,
+ * as CONFIG_BLOCK_CACHE_SIZE does.
+ *
+ * @param blocks - maximum number of blocks in a read that is cached
+ * @param size_mb - size of the cache in MiB, 0 to disable the cache
+ */
+void blkcache_configure_size(unsigned blocks, unsigned size_mb);
+
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
-	unsigned hits;
-	unsigned misses;
-	unsigned entries; /* current entry count */
+	unsigned hits;		/* blocks read from the cache */
+	unsigned misses;	/* blocks read from the device */
+	unsigned evictions;	/* blocks dropped to make room for others */
+	unsigned entries;	/* current count of cached blocks */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned max_entries;	/* capacity in blocks, 0 if not allocated */
+	unsigned size_mb;	/* size set in MiB, 0 if set by entries */
+	unsigned size_kb;	/* size allocated, 0 if not allocated */
+	unsigned sets;
+	unsigned ways;
 };
 
 /**
@@ -193,10 +236,66 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline ulong blkcache_read_through(struct blk_desc *block_dev,
+					  lbaint_t start, lbaint_t blkcnt,
+					  void *buffer, blkcache_read_t read)
+{
+	return read(block_dev, start, blkcnt, buffer);
+}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+/*
+ * statistics of block device read-ahead, summed over all devices
+ */
+struct blk_readahead_stats {
+	ulong requests;		/* reads requested of block devices */
+	ulong dev_reads;	/* reads issued to block device drivers */
+	ulong hits;		/* requests served from read-ahead buffers */
+	ulong prefetched;	/* blocks read ahead of requests */
+	unsigned size_kb;	/* read-ahead window */
+};
+
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+/**
+ * blk_readahead_invalidate() - discard read-ahead data of a device
+ *
+ * @block_dev:	Block device descriptor
+ */
+void blk_readahead_invalidate(struct blk_desc *block_dev);
+
+/**
+ * blk_readahead_configure() - set the read-ahead window
+ *
+ * This discards the data read ahead on every device and resets the
+ * statistics.
+ *
+ * @size_kb:	Size of the window in KiB, 0 to disable read-ahead
+ */
+void blk_readahead_configure(unsigned size_kb);
+
+/**
+ * blk_readahead_stats() - return read-ahead statistics and reset them
+ *
+ * @stats:	Statistics are copied here
+ */
+void blk_readahead_stats(struct blk_readahead_stats *stats);
+
+#else
+
+static inline void blk_readahead_invalidate(struct blk_desc *block_dev) {}
+
+static inline void blk_readahead_configure(unsigned size_kb) {}
+
+static inline void blk_readahead_stats(struct blk_readahead_stats *stats)
+{
+	memset(stats, '\0', sizeof(*stats));
+}
+
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -428,22 +527,13 @@ struct blk_desc *blk_get_by_device(struct udevice *dev);
 static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer)
 {
-	ulong blks_read;
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
 	 * bloats the code slightly (cause some board to fail to build), and
 	 * it would be an error to try an operation that does not exist.
 	 */
-	blks_read = block_dev->block_read(block_dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
-
-	return blks_read;
+	return blkcache_read_through(block_dev, start, blkcnt, buffer,
+				     block_dev->block_read);
 }
 
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
@@ -15,6 +15,7 @@
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
+	BOOTSTAGEF_SPAN		= 1 << 2,	/* Nested begin/end span */
 };
 
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
@@ -305,6 +306,46 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_span_begin() - Mark the start of a span of time
+ *
+ * Unlike bootstage_start(), each call records a new span with its own start
+ * time and duration. Spans nest: one begun while another is open is recorded
+ * as its child, so the report and trace output show where the time inside a
+ * span went. The name is copied. Spans are only recorded after relocation.
+ *
+ * @name: Name of the span
+ * @return span number to pass to bootstage_span_end(), or -ve on error (e.g.
+ *	-ENOSPC if CONFIG_BOOTSTAGE_SPAN_COUNT spans have been recorded, or
+ *	-EAGAIN before relocation)
+ */
+int bootstage_span_begin(const char *name);
+
+/**
+ * bootstage_span_end() - Mark the end of a span of time
+ *
+ * Any spans begun since and not yet ended are treated as ended too, so far as
+ * the nesting depth of later spans is concerned.
+ *
+ * @span: Span number returned by bootstage_span_begin(). Negative values are
+ *	ignored, so errors from bootstage_span_begin() need not be checked.
+ * @return duration of the span in microseconds
+ */
+uint32_t bootstage_span_end(int span);
+
+/**
+ * bootstage_add_span() - Record a span which started earlier and ends now
+ *
+ * This is for work which overlaps other spans rather than nesting inside
+ * them, such as a device finishing its probe in the background. The span is
+ * recorded at the current nesting depth.
+ *
+ * @name: Name of the span
+ * @start_us: Start time, from timer_get_boot_us()
+ * @return duration of the span in microseconds
+ */
+uint32_t bootstage_add_span(const char *name, uint32_t start_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -315,6 +356,19 @@ void bootstage_report(void);
  */
 int bootstage_fdt_add_report(void);
 
+/**
+ * bootstage_list_trace() - Write bootstage marks and spans for proftool
+ *
+ * The records are written as a trace chunk of type TRACE_CHUNK_BOOTSTAGE,
+ * which can be appended to a function trace. Accumulated times are omitted.
+ *
+ * @buff: Buffer to write to, or NULL to count the size
+ * @buff_size: Size of buffer
+ * @needed: Returns number of bytes used / needed
+ * @return 0 if ok, -ENOSPC if the buffer is too small
+ */
+int bootstage_list_trace(void *buff, int buff_size, unsigned int *needed);
+
 /**
  * Stash bootstage data into memory
  *
@@ -404,6 +458,27 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline int bootstage_span_begin(const char *name)
+{
+	return -ENOSYS;
+}
+
+static inline uint32_t bootstage_span_end(int span)
+{
+	return 0;
+}
+
+static inline uint32_t bootstage_add_span(const char *name, uint32_t start_us)
+{
+	return 0;
+}
+
+static inline int bootstage_list_trace(void *buff, int buff_size,
+				       unsigned int *needed)
+{
+	return -ENOSYS;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -476,6 +476,31 @@ int gzwrite(unsigned char *src, int len,
 /* lib/lz4_wrapper.c */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/* State of an LZ4 frame being decompressed by ulz4fn_stream() */
+struct ulz4_stream {
+	int started;		/* frame header has been read */
+	int has_block_checksum;
+};
+
+/**
+ * ulz4fn_stream() - Decompress the next part of an LZ4 frame
+ *
+ * The frame header is read on the first call, after which each call
+ * decompresses as many whole blocks as @src holds. Blocks are independent,
+ * so the caller may drop the input used and pass the rest, followed by more
+ * data, to the next call.
+ *
+ * @s:		stream state, zeroed before the first call
+ * @src:	compressed data
+ * @srcn:	on entry the number of bytes at @src, on exit the number used
+ * @dst:	where to write the decompressed data
+ * @dstn:	on entry the room at @dst, on exit the number of bytes written
+ * @return 0 at the end of the frame, -EAGAIN if more input is needed, other
+ *	-ve error code on failure
+ */
+int ulz4fn_stream(struct ulz4_stream *s, const void *src, size_t *srcn,
+		  void *dst, size_t *dstn);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
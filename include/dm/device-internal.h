@@ -110,6 +110,32 @@ int device_remove(struct udevice *dev, uint flags);
 static inline int device_remove(struct udevice *dev, uint flags) { return 0; }
 #endif
 
+/**
+ * device_probe_finish() - Finish probing a device after its probe() method
+ *
+ * This calls the uclass post_probe() method and the parent uclass'
+ * child_post_probe() method. For a device which finishes its probe in the
+ * background, this happens once it is ready. If this fails, the device is
+ * removed.
+ *
+ * @dev: Pointer to device
+ * @return 0 if OK, -ve on error
+ */
+int device_probe_finish(struct udevice *dev);
+
+/**
+ * device_async_cancel() - Stop waiting for a device to finish probing
+ *
+ * This is used when a device is removed before its probe has finished.
+ *
+ * @dev: Pointer to device
+ */
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+void device_async_cancel(struct udevice *dev);
+#else
+static inline void device_async_cancel(struct udevice *dev) {}
+#endif
+
 /**
  * device_unbind() - Unbind a device, destroying it
  *
@@ -61,6 +61,9 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/* Device is probed but still waiting for its hardware, see device_async_start() */
+#define DM_FLAG_PROBE_ASYNC		(1 << 11)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -119,6 +122,8 @@ enum {
  * @req_seq: Requested sequence number for this device (-1 = any)
  * @seq: Allocated sequence number for this device (-1 = none). This is set up
  * when the device is probed and will be unique within the device's uclass.
+ * @seq_hash_node: Used by uclass to find the device by @seq
+ * @node_hash_node: Used by uclass to find the device by @node
  * @devres_head: List of memory allocations associated with this device.
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
@@ -143,6 +148,10 @@ struct udevice {
 	uint32_t flags;
 	int req_seq;
 	int seq;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct list_head seq_hash_node;
+	struct list_head node_hash_node;
+#endif
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
@@ -162,9 +171,20 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return ofnode_to_offset(dev->node);
 }
 
+/**
+ * dev_set_ofnode() - Set the device tree node of a device
+ *
+ * This must be used rather than writing dev->node once the device is bound,
+ * so that the uclass can still find the device by its node.
+ *
+ * @dev: Device to update
+ * @node: New node for the device
+ */
+void dev_set_ofnode(struct udevice *dev, ofnode node);
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
-	dev->node = offset_to_ofnode(of_offset);
+	dev_set_ofnode(dev, offset_to_ofnode(of_offset));
 }
 
 static inline bool dev_has_of_node(struct udevice *dev)
@@ -679,6 +699,91 @@ static inline bool device_is_on_pci_bus(struct udevice *dev)
 #define device_foreach_child_safe(pos, next, parent)	\
 	list_for_each_entry_safe(pos, next, &parent->child_head, sibling_node)
 
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * device_async_start() - Finish probing a device in the background
+ *
+ * This is called from a driver's probe() method once the hardware has been
+ * started, when all that is left is to wait for it to become ready. The probe
+ * method should then return 0. The device counts as probed, but @poll is
+ * called from time to time until it reports that the hardware is ready.
+ * Meanwhile other devices can be probed, so that their waits overlap. The
+ * uclass post_probe() and parent uclass child_post_probe() methods are only
+ * called once the device is ready.
+ *
+ * Anything which probes the device again, e.g. uclass_get_device(), waits
+ * until @poll has finished, so users of the device need not know about this.
+ * If @poll fails, the device is removed and the error is returned to whoever
+ * is waiting.
+ *
+ * Before relocation, or if memory runs out, this simply waits for @poll.
+ *
+ * @dev:	Device being probed
+ * @poll:	Function to check whether the device is ready. This returns 0
+ *		if ready, -EAGAIN if not ready yet, other -ve value on error
+ * @return 0 if OK, or the error from @poll if it was called here
+ */
+int device_async_start(struct udevice *dev, int (*poll)(struct udevice *dev));
+
+/**
+ * device_async_wait() - Wait for a device to finish probing
+ *
+ * Other devices waiting to finish probing are polled at the same time.
+ *
+ * @dev:	Device to wait for
+ * @return 0 if the device is ready (or was never waiting), -ve on error,
+ *	in which case the device has been removed
+ */
+int device_async_wait(struct udevice *dev);
+
+/**
+ * device_async_poll() - Poll each device which is finishing its probe
+ *
+ * This can be called from a loop which waits for something else, so that
+ * devices make progress meanwhile.
+ *
+ * @return number of devices still waiting
+ */
+int device_async_poll(void);
+
+/**
+ * device_async_wait_all() - Wait for all devices to finish probing
+ *
+ * Errors are not returned since they have already been reported, and failed
+ * devices removed.
+ *
+ * @return 0
+ */
+int device_async_wait_all(void);
+#else
+static inline int device_async_start(struct udevice *dev,
+				     int (*poll)(struct udevice *dev))
+{
+	int ret;
+
+	do {
+		ret = poll(dev);
+	} while (ret == -EAGAIN);
+
+	return ret;
+}
+
+static inline int device_async_wait(struct udevice *dev)
+{
+	return 0;
+}
+
+static inline int device_async_poll(void)
+{
+	return 0;
+}
+
+static inline int device_async_wait_all(void)
+{
+	return 0;
+}
+#endif
+
 /**
  * dm_scan_fdt_dev() - Bind child device in a the device tree
  *
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Tables of device tree nodes generated by dtoc, used to speed up binding
+ */
+
+#ifndef _DM_DEVTAB_H
+#define _DM_DEVTAB_H
+
+#include <linker_lists.h>
+
+struct driver;
+struct udevice_id;
+
+/**
+ * struct dm_devtab_match - Driver found for a compatible string
+ *
+ * This is filled in the first time the compatible string is looked up after
+ * relocation, so later nodes with the same string need not search the
+ * drivers again.
+ *
+ * @drv:	Driver which matches, or NULL if none
+ * @id:		Entry in the driver's of_match table which matches
+ * @done:	true once @drv and @id are valid
+ */
+struct dm_devtab_match {
+	struct driver *drv;
+	const struct udevice_id *id;
+	bool done;
+};
+
+/**
+ * struct dm_devtab_node - Information about a node with a compatible string
+ *
+ * @offset:	Offset of the node in the device tree
+ * @compat:	Value of its compatible property, so that the table entry can
+ *		be checked against the device tree actually in use
+ * @compat_len:	Length of @compat in bytes, including the final nul
+ * @slots:	Index in struct dm_devtab's @match for each string in @compat
+ */
+struct dm_devtab_node {
+	int offset;
+	const char *compat;
+	int compat_len;
+	const u16 *slots;
+};
+
+/**
+ * struct dm_devtab - Table of the nodes in a device tree
+ *
+ * This is generated by 'dtoc devtab' from the device tree built with U-Boot.
+ * Each different compatible string in the tree has a slot in @match, so it
+ * is only matched against the drivers once.
+ *
+ * @nodes:	Nodes with a compatible string, in order of offset
+ * @node_count:	Number of nodes
+ * @match:	Driver matching each compatible string
+ * @match_count: Number of compatible strings
+ */
+struct dm_devtab {
+	const struct dm_devtab_node *nodes;
+	int node_count;
+	struct dm_devtab_match *match;
+	int match_count;
+};
+
+/* Declare a device table, normally only done by dtoc */
+#define U_BOOT_DEVTAB(__name)						\
+	ll_entry_declare(struct dm_devtab, __name, devtab)
+
+#endif
@@ -44,6 +44,28 @@ struct uclass_driver *lists_uclass_lookup(enum uclass_id id);
  */
 int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 
+/**
+ * lists_compat_index_set_enabled() - Enable the index of compatible strings
+ *
+ * The index is used by default. This also frees it, so that it is built
+ * again on next use. It is used by tests, to compare binding with and
+ * without the index.
+ *
+ * @enable: true to use the index, false to search the drivers each time
+ */
+void lists_compat_index_set_enabled(bool enable);
+
+/**
+ * lists_devtab_set_enabled() - Enable use of the device tables from dtoc
+ *
+ * The tables are used by default. This also forgets the drivers already
+ * found for each compatible string. It is used by tests, to compare binding
+ * with and without the tables.
+ *
+ * @enable: true to use the tables, false to ignore them
+ */
+void lists_devtab_set_enabled(bool enable);
+
 /**
  * lists_bind_fdt() - bind a device tree node
  *
@@ -35,10 +35,13 @@ struct property {
  * @type: Node type (value of device_type property) or "<NULL>" if none
  * @phandle: Phandle value of this none, or 0 if none
  * @full_name: Full path to node, e.g. "/bus@1/spi@1100"
- * @properties: Pointer to head of list of properties, or NULL if none
+ * @properties: Pointer to head of list of properties, or NULL if none. Use
+ *	of_node_props() to read this.
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
  * @sibling: Pointer to the next sibling node, or NULL if this is the last
+ * @offset: Offset of the node in the flat tree while its properties are not
+ *	yet decoded, else -1 (only with CONFIG_OF_LIVE_LAZY)
  */
 struct device_node {
 	const char *name;
@@ -50,6 +53,9 @@ struct device_node {
 	struct device_node *parent;
 	struct device_node *child;
 	struct device_node *sibling;
+#ifdef CONFIG_OF_LIVE_LAZY
+	int offset;
+#endif
 };
 
 #define OF_MAX_PHANDLE_ARGS 16
@@ -102,6 +108,33 @@ static inline bool of_live_active(void)
 }
 #endif
 
+#ifdef CONFIG_OF_LIVE_LAZY
+/**
+ * of_live_decode_props() - Decode the properties of a node from the flat tree
+ *
+ * @np: Node whose properties have not yet been decoded
+ * @return first property of the node, or NULL if none or out of memory
+ */
+struct property *of_live_decode_props(struct device_node *np);
+#endif
+
+/**
+ * of_node_props() - Get the first property of a node
+ *
+ * With CONFIG_OF_LIVE_LAZY the properties are decoded on first use.
+ *
+ * @np: Node to check
+ * @return first property of the node, or NULL if none
+ */
+static inline struct property *of_node_props(const struct device_node *np)
+{
+#ifdef CONFIG_OF_LIVE_LAZY
+	if (np->offset >= 0)
+		return of_live_decode_props((struct device_node *)np);
+#endif
+	return np->properties;
+}
+
 #define OF_BAD_ADDR	((u64)-1)
 
 static inline const char *of_node_full_name(const struct device_node *np)
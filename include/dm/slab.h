@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Size-class allocator for driver-model objects
+ */
+
+#ifndef _DM_SLAB_H
+#define _DM_SLAB_H
+
+#include <malloc.h>
+
+/* Number of size classes, the largest being DM_SLAB_MAX_SIZE bytes */
+#define DM_SLAB_CLASSES		10
+#define DM_SLAB_MAX_SIZE	512
+
+/**
+ * struct dm_slab_class_stats - Information about one size class
+ *
+ * @size:	Size of each object in the class, in bytes
+ * @slabs:	Number of slabs allocated for the class
+ * @used:	Number of objects in use
+ * @free:	Number of objects free in the class's slabs
+ */
+struct dm_slab_class_stats {
+	int size;
+	int slabs;
+	int used;
+	int free;
+};
+
+/**
+ * struct dm_slab_stats - Information about driver-model allocations
+ *
+ * Only allocations made after relocation are counted.
+ *
+ * @allocs:	Number of objects in use from the size classes
+ * @req_bytes:	Bytes requested for these objects
+ * @used_bytes:	Bytes of size class used for these objects
+ * @malloc_bytes: Bytes malloc() would have used for these objects,
+ *		including its own overhead, for comparison
+ * @slab_bytes:	Bytes allocated for slabs
+ * @large_allocs: Number of objects in use which are too large for a size
+ *		class, and so come from malloc()
+ * @large_bytes: Bytes requested for these objects
+ * @total_allocs: Number of allocations since boot
+ * @class:	Information about each size class
+ */
+struct dm_slab_stats {
+	int allocs;
+	ulong req_bytes;
+	ulong used_bytes;
+	ulong malloc_bytes;
+	ulong slab_bytes;
+	int large_allocs;
+	ulong large_bytes;
+	ulong total_allocs;
+	struct dm_slab_class_stats class[DM_SLAB_CLASSES];
+};
+
+#if CONFIG_IS_ENABLED(DM_SLAB)
+/**
+ * dm_slab_alloc() - Allocate a driver-model object
+ *
+ * After relocation, small objects come from slabs of a fixed size holding
+ * objects of the same size class, so there is no per-object overhead.
+ * Larger objects, and all objects before relocation, come from malloc().
+ *
+ * @size: Size of object in bytes
+ * @return pointer to zeroed object, or NULL if out of memory
+ */
+void *dm_slab_alloc(int size);
+
+/**
+ * dm_slab_free() - Free a driver-model object
+ *
+ * @ptr: Object to free, as returned by dm_slab_alloc(), or NULL
+ * @size: Size of object, as passed to dm_slab_alloc()
+ */
+void dm_slab_free(void *ptr, int size);
+
+/**
+ * dm_slab_get_stats() - Get information about driver-model allocations
+ *
+ * @stats: Returns the information
+ */
+void dm_slab_get_stats(struct dm_slab_stats *stats);
+#else
+static inline void *dm_slab_alloc(int size)
+{
+	return calloc(1, size);
+}
+
+static inline void dm_slab_free(void *ptr, int size)
+{
+	free(ptr);
+}
+#endif
+
+#endif
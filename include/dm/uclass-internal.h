@@ -196,6 +196,24 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This keeps the uclass's index of sequence numbers up to date, so dev->seq
+ * must only be changed through here.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 for none
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
+/**
+ * uclass_update_ofnode() - Update the uclass after a device's node changes
+ *
+ * @dev:	Pointer to the device, with its new node already set
+ */
+void uclass_update_ofnode(struct udevice *dev);
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
@@ -251,4 +269,23 @@ struct uclass *uclass_find(enum uclass_id key);
  */
 int uclass_destroy(struct uclass *uc);
 
+/**
+ * uclass_lookup_steps() - Get the number of devices checked by lookups
+ *
+ * This counts the devices looked at by uclass_find_device_by_seq() and
+ * uclass_find_device_by_ofnode(), so that tests can check how lookups scale
+ * with the number of devices. It is only kept with CONFIG_UNIT_TEST.
+ *
+ * @reset:	true to set the count back to 0 after reading it
+ * @return number of devices checked since the count was last reset
+ */
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+uint uclass_lookup_steps(bool reset);
+#else
+static inline uint uclass_lookup_steps(bool reset)
+{
+	return 0;
+}
+#endif
+
 #endif
@@ -14,6 +14,20 @@
 #include <linker_lists.h>
 #include <linux/list.h>
 
+/* Number of buckets in each uclass hash table, a power of two */
+#define DM_UCLASS_HASH_SIZE	16
+
+/**
+ * struct uclass_hash - Hash tables of the devices in a uclass
+ *
+ * @seq: Devices with a sequence number, by number
+ * @node: All devices, by device tree node
+ */
+struct uclass_hash {
+	struct list_head seq[DM_UCLASS_HASH_SIZE];
+	struct list_head node[DM_UCLASS_HASH_SIZE];
+};
+
 /**
  * struct uclass - a U-Boot drive class, collecting together similar drivers
  *
@@ -30,12 +44,17 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @hash: Hash tables of the devices, or NULL before relocation, in which
+ * case lookups walk @dev_head
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass_hash *hash;
+#endif
 };
 
 struct driver;
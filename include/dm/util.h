@@ -39,6 +39,15 @@ static inline void dm_dump_devres(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_SLAB)
+/* Dump out information about the memory used by driver model objects */
+void dm_dump_mem(void);
+#else
+static inline void dm_dump_mem(void)
+{
+}
+#endif
+
 /**
  * Check if an of node should be or was bound before relocation.
  *
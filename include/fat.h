@@ -29,6 +29,9 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* Number of FAT buffers kept by get_fatent() */
+#define FATCACHEBUFS	8
+
 /* Maximum number of entry for long file name according to spec */
 #define MAX_LFN_SLOT	20
 
@@ -175,6 +178,10 @@ typedef struct {
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
 	int	fats;		/* Number of FATs */
+	__u8	*fatcache;	/* Read-only FAT buffers, NULL if none */
+	int	fatcache_num[FATCACHEBUFS];	/* FAT buffer held, or -1 */
+	__u32	fatcache_used[FATCACHEBUFS];	/* LRU stamp of each */
+	__u32	fatcache_tick;	/* Last LRU stamp handed out */
 } fsdata;
 
 static inline u32 clust_to_sect(fsdata *fsdata, u32 clust)
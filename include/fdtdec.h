@@ -665,6 +665,41 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+/**
+ * fdtdec_node_offset_by_phandle() - Find the node with a given phandle
+ *
+ * This is the same as fdt_node_offset_by_phandle() but, with
+ * CONFIG_OF_LOOKUP_CACHE and after relocation, the control FDT is walked
+ * only once to build a table of phandles.
+ *
+ * @blob:	FDT blob
+ * @phandle:	Phandle to look for
+ * @return node offset if found, -ve FDT_ERR_... error code on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_path_offset() - Find the node with a given path or alias
+ *
+ * This is the same as fdt_path_offset() but, with CONFIG_OF_LOOKUP_CACHE
+ * and after relocation, recent lookups in the control FDT are remembered.
+ *
+ * @blob:	FDT blob
+ * @path:	Full path of the node, or alias
+ * @return node offset if found, -ve FDT_ERR_... error code on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_cache_invalidate() - Drop cached lookups in the control FDT
+ *
+ * The cache is dropped automatically when the control FDT moves or changes
+ * size, or when a cached node is found to have moved. Since a path lookup
+ * only checks the name of the node it finds, this should be called after
+ * changes which keep the size of the tree but move nodes around.
+ */
+void fdtdec_cache_invalidate(void);
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
@@ -184,6 +184,8 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
+int do_loadz(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+	     int fstype);
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 int file_exists(const char *dev_type, const char *dev_part, const char *file,
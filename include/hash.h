@@ -12,6 +12,15 @@
  */
 #define HASH_MAX_DIGEST_SIZE	32
 
+/* Maximum number of algorithms which hash_block_multi() can run at once */
+#define HASH_MULTI_MAX		4
+
+/*
+ * Amount of data passed to each algorithm in turn by hash_block_multi(). This
+ * is small enough to stay in a 32KiB L1 data cache between algorithms.
+ */
+#define HASH_MULTI_CHUNK	(16 * 1024)
+
 enum {
 	HASH_FLAG_VERIFY	= 1 << 0,	/* Enable verify mode */
 	HASH_FLAG_ENV		= 1 << 1,	/* Allow env vars */
@@ -139,6 +148,33 @@ int hash_lookup_algo(const char *algo_name, struct hash_algo **algop);
 int hash_progressive_lookup_algo(const char *algo_name,
 				 struct hash_algo **algop);
 
+/**
+ * hash_block_multi() - Hash a block with several algorithms in one pass
+ *
+ * This gives the same results as calling hash_block() once per algorithm,
+ * but the data is only read from memory once: it is split into chunks of
+ * HASH_MULTI_CHUNK bytes and each chunk is passed to every algorithm while it
+ * is still in the cache. This is useful for large images with more than one
+ * hash, such as a FIT with both a crc32 and a sha256 hash node.
+ *
+ * Only algorithms with progressive hash support can be used.
+ *
+ * @algo_names:		Names of the hash algorithms to use
+ * @count:		Number of algorithms (at most HASH_MULTI_MAX)
+ * @data:		Data to hash
+ * @len:		Length of data to hash in bytes
+ * @outputs:		Place to put each hash value. Each must have space for
+ *			HASH_MAX_DIGEST_SIZE bytes
+ * @output_sizes:	If not NULL, returns the number of bytes written to
+ *			each output
+ * @return 0 if ok, -EINVAL if @count is too large, -EPROTONOSUPPORT for an
+ * unknown algorithm or one without progressive hash support, other -ve value
+ * on other error
+ */
+int hash_block_multi(const char *const algo_names[], int count,
+		     const void *data, unsigned int len,
+		     uint8_t *const outputs[], int output_sizes[]);
+
 /**
  * hash_parse_string() - Parse hash string into a binary array
  *
@@ -92,6 +92,31 @@ struct fdt_region;
 #define IMAGE_ENABLE_SHA256	0
 #endif
 
+/*
+ * hash_block_multi() can compute all the hashes of an image in one pass over
+ * its data. Hardware engines may only handle one context at a time.
+ */
+#if defined(USE_HOSTCC) || (defined(CONFIG_HASH) && \
+	!defined(CONFIG_SPL_BUILD) && !defined(CONFIG_SHA_PROG_HW_ACCEL))
+#define IMAGE_ENABLE_MULTI_HASH	1
+#else
+#define IMAGE_ENABLE_MULTI_HASH	0
+#endif
+
+/* Use it when verifying an image with several hash nodes */
+#if defined(CONFIG_FIT_MULTI_HASH) && IMAGE_ENABLE_MULTI_HASH
+#define IMAGE_ENABLE_ONE_PASS_HASH	1
+#else
+#define IMAGE_ENABLE_ONE_PASS_HASH	0
+#endif
+
+/* Calculate the hashes of the images in a FIT on other CPUs, see mp_job.h */
+#if !defined(USE_HOSTCC) && defined(CONFIG_MP_JOB) && IMAGE_ENABLE_MULTI_HASH
+#define IMAGE_ENABLE_MP_VERIFY	1
+#else
+#define IMAGE_ENABLE_MP_VERIFY	0
+#endif
+
 #endif /* IMAGE_ENABLE_FIT */
 
 #ifdef CONFIG_SYS_BOOT_GET_CMDLINE
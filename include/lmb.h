@@ -12,25 +12,60 @@
  * Copyright (C) 2001 Peter Bergner, IBM Corp.
  */
 
-#define MAX_LMB_REGIONS 8
+/*
+ * Number of regions held in struct lmb_region itself. If more are needed, a
+ * larger array is allocated with malloc(), so there is no limit other than
+ * available memory.
+ */
+#define LMB_INIT_REGIONS 8
 
 struct lmb_property {
 	phys_addr_t base;
 	phys_size_t size;
 };
 
+/**
+ * struct lmb_region - A set of regions, sorted by base address
+ *
+ * Regions never overlap, and adjacent regions are merged. Use lmb_regions()
+ * to get at them. The struct holds no pointer into itself, so an all-zero
+ * struct is an empty set and it may be copied by value, e.g. as part of
+ * bootm_headers_t. Once @grown is set, only one of the copies may be used.
+ *
+ * @cnt:	Number of regions in use
+ * @max:	Number of regions @grown has space for
+ * @size:	Unused
+ * @grown:	Regions allocated by malloc() once @init_region is full, or
+ *		NULL if @init_region is in use
+ * @init_region: Space for the first LMB_INIT_REGIONS regions
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *grown;
+	struct lmb_property init_region[LMB_INIT_REGIONS];
 };
 
+/**
+ * lmb_regions() - Get the regions in a set
+ *
+ * @rgn:	Set of regions
+ * @return array of @rgn->cnt regions
+ */
+static inline struct lmb_property *lmb_regions(struct lmb_region *rgn)
+{
+	return rgn->grown ? rgn->grown : rgn->init_region;
+}
+
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
 };
 
 extern void lmb_init(struct lmb *lmb);
+/* Free any memory allocated for regions, once @lmb is no longer needed */
+extern void lmb_uninit(struct lmb *lmb);
 extern void lmb_init_and_reserve(struct lmb *lmb, bd_t *bd, void *fdt_blob);
 extern void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				       phys_size_t size, void *fdt_blob);
@@ -52,7 +87,7 @@ extern void lmb_dump_all(struct lmb *lmb);
 static inline phys_size_t
 lmb_size_bytes(struct lmb_region *type, unsigned long region_nr)
 {
-	return type->region[region_nr].size;
+	return lmb_regions(type)[region_nr].size;
 }
 
 void board_lmb_reserve(struct lmb *lmb);
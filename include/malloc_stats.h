@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Statistics about malloc() use
+ */
+
+#ifndef __MALLOC_STATS_H
+#define __MALLOC_STATS_H
+
+/* Number of size buckets, see malloc_stats_bucket_size() */
+#define MALLOC_STATS_BUCKETS	16
+
+/**
+ * struct malloc_info - Information about the malloc() heap
+ *
+ * Only allocations made once the full malloc() is running (after
+ * relocation) are counted. Sizes are the usable size of each block, which
+ * may be a little larger than requested.
+ *
+ * @heap_size:	Size of the heap in bytes
+ * @in_use:	Bytes currently allocated
+ * @peak:	Largest value of @in_use since boot or malloc_reset_peak()
+ * @count:	Number of blocks currently allocated
+ * @allocs:	Number of allocations since boot
+ * @frees:	Number of frees since boot
+ * @failures:	Number of allocations which failed
+ * @largest_failure: Size of the largest request which failed
+ * @untracked:	Number of blocks allocated whose caller could not be
+ *		recorded because the table was full
+ * @bucket_count: Number of blocks currently allocated in each size bucket
+ * @bucket_allocs: Number of allocations since boot in each size bucket
+ */
+struct malloc_info {
+	ulong heap_size;
+	ulong in_use;
+	ulong peak;
+	ulong count;
+	ulong allocs;
+	ulong frees;
+	ulong failures;
+	ulong largest_failure;
+	ulong untracked;
+	ulong bucket_count[MALLOC_STATS_BUCKETS];
+	ulong bucket_allocs[MALLOC_STATS_BUCKETS];
+};
+
+/**
+ * struct malloc_leak - Blocks allocated by one caller
+ *
+ * @caller:	Address the allocation function was called from
+ * @count:	Number of blocks
+ * @bytes:	Total size of the blocks
+ */
+struct malloc_leak {
+	void *caller;
+	ulong count;
+	ulong bytes;
+};
+
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+/**
+ * malloc_stats_alloc() - Record an allocation
+ *
+ * This is called by malloc() and friends.
+ *
+ * @ptr: Block allocated
+ * @size: Usable size of the block
+ * @caller: Address malloc() etc. was called from
+ */
+void malloc_stats_alloc(void *ptr, size_t size, void *caller);
+
+/**
+ * malloc_stats_free() - Record that a block has been freed
+ *
+ * @ptr: Block freed
+ * @size: Usable size of the block
+ */
+void malloc_stats_free(void *ptr, size_t size);
+
+/**
+ * malloc_stats_fail() - Record that an allocation failed
+ *
+ * @size: Size requested
+ */
+void malloc_stats_fail(size_t size);
+
+/**
+ * malloc_get_info() - Get information about the malloc() heap
+ *
+ * @info: Returns the information
+ */
+void malloc_get_info(struct malloc_info *info);
+
+/* Set the peak usage back to the current usage */
+void malloc_reset_peak(void);
+
+/**
+ * malloc_stats_bucket_size() - Get the largest block size in a bucket
+ *
+ * Bucket 0 holds blocks up to 16 bytes, each later bucket blocks up to
+ * twice the size of the one before. The last bucket holds everything
+ * larger.
+ *
+ * @bucket: Bucket number
+ * @return largest size in the bucket, or 0 for the last bucket
+ */
+ulong malloc_stats_bucket_size(int bucket);
+#endif
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+/**
+ * malloc_leaks_mark() - Get a mark for looking for leaks
+ *
+ * @return a mark, to pass to malloc_get_leaks() to find blocks allocated
+ *	since now which are still allocated
+ */
+ulong malloc_leaks_mark(void);
+
+/**
+ * malloc_get_leaks() - Find blocks still allocated, grouped by caller
+ *
+ * @mark: Only report blocks allocated after this, from malloc_leaks_mark()
+ * @leaks: Returns the callers, with the most bytes first
+ * @max: Size of @leaks
+ * @countp: Returns the number of blocks found, which may be more than fit
+ *	in @leaks
+ * @return number of entries in @leaks filled in
+ */
+int malloc_get_leaks(ulong mark, struct malloc_leak *leaks, int max,
+		     ulong *countp);
+#else
+static inline ulong malloc_leaks_mark(void)
+{
+	return 0;
+}
+
+static inline int malloc_get_leaks(ulong mark, struct malloc_leak *leaks,
+				   int max, ulong *countp)
+{
+	*countp = 0;
+
+	return 0;
+}
+#endif
+
+#endif
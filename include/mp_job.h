@@ -0,0 +1,234 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running jobs on secondary CPUs
+ *
+ * U-Boot runs on one CPU, leaving any others parked. Some boot work, such as
+ * hashing and decompressing images, splits into independent pieces which can
+ * run on those CPUs instead. A job is started with mp_job_start() and its
+ * result collected with mp_job_join(). If no secondary CPU is free, the job
+ * simply runs on the boot CPU within mp_job_start(), so callers need not care
+ * whether any secondary CPUs are available.
+ *
+ * A job may only do computation on memory and call malloc() and free(). It
+ * must not use driver model or any other state which is not protected against
+ * use from several CPUs, nor start jobs itself. Errors should be returned, for
+ * the caller to report after mp_job_join(). Library code which prints a
+ * message on bad input, such as gunzip(), may still be used, but the message
+ * may be mixed up with the boot CPU's output.
+ *
+ * WATCHDOG_RESET() does nothing on a secondary CPU, so code which calls it may
+ * be used in a job. The boot CPU resets the watchdog while it waits in
+ * mp_job_join().
+ */
+
+#ifndef __MP_JOB_H
+#define __MP_JOB_H
+
+#include <linux/types.h>
+
+/* Largest number of secondary CPUs which can run jobs */
+#define MP_JOB_MAX_CPUS		8
+
+/**
+ * struct mp_job - A job which may run on a secondary CPU
+ *
+ * @func:	Function to run
+ * @arg:	Argument for @func
+ * @ret:	Value returned by @func, valid once mp_job_join() returns
+ * @cpu:	Secondary CPU which runs the job, or 0 if run by the boot CPU
+ * @done:	true once @func has returned
+ */
+struct mp_job {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+	int cpu;
+	bool done;
+};
+
+/**
+ * struct mp_lock - A lock which can be taken by any CPU
+ *
+ * @locked:	true if the lock is held
+ */
+struct mp_lock {
+	bool locked;
+};
+
+/**
+ * mp_job_run() - Run a job and mark it as done
+ *
+ * This is called by the CPU which runs the job.
+ *
+ * @job: Job to run
+ */
+static inline void mp_job_run(struct mp_job *job)
+{
+	job->ret = job->func(job->arg);
+	__atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+}
+
+#if CONFIG_IS_ENABLED(MP_JOB)
+/**
+ * mp_job_start() - Start a job
+ *
+ * The job runs on the first free secondary CPU. If there is none, or this is
+ * called before relocation, it runs on this CPU before returning.
+ *
+ * @job: Job to start, which must remain valid until mp_job_join() returns
+ * @func: Function to run
+ * @arg: Argument for @func
+ */
+void mp_job_start(struct mp_job *job, int (*func)(void *arg), void *arg);
+
+/**
+ * mp_job_join() - Wait for a job to finish
+ *
+ * @job: Job started by mp_job_start()
+ * @return value returned by the job's function
+ */
+int mp_job_join(struct mp_job *job);
+
+/**
+ * mp_job_cpus() - Get the number of secondary CPUs which can run jobs
+ *
+ * @return number of CPUs, 0 if jobs always run on the boot CPU
+ */
+int mp_job_cpus(void);
+
+/**
+ * mp_job_set_max_cpus() - Limit the number of secondary CPUs used for jobs
+ *
+ * This must not be called while any jobs are running.
+ *
+ * @max: Largest number of CPUs to use, or -1 for no limit
+ * @return previous limit
+ */
+int mp_job_set_max_cpus(int max);
+
+/**
+ * mp_job_secondary() - Check whether this is a secondary CPU
+ *
+ * Jobs may call code which is only safe on the boot CPU, such as resetting
+ * the watchdog. That code uses this to skip its work.
+ *
+ * @return true if running on a secondary CPU, false on the boot CPU
+ */
+bool mp_job_secondary(void);
+
+/**
+ * mp_job_stop_cpus() - Stop all secondary CPUs before booting an OS
+ *
+ * Any jobs still running are joined first. The CPUs are handed back to the
+ * state they were in before U-Boot started using them, so that the OS can
+ * bring them up itself. Jobs may still be started afterwards, but then
+ * simply run on the boot CPU.
+ */
+void mp_job_stop_cpus(void);
+
+/**
+ * mp_lock() - Take a lock, waiting until it is free
+ *
+ * @lock: Lock to take
+ */
+static inline void mp_lock(struct mp_lock *lock)
+{
+	while (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE))
+		;
+}
+
+/**
+ * mp_unlock() - Release a lock taken by mp_lock()
+ *
+ * @lock: Lock to release
+ */
+static inline void mp_unlock(struct mp_lock *lock)
+{
+	__atomic_clear(&lock->locked, __ATOMIC_RELEASE);
+}
+#else
+static inline void mp_job_start(struct mp_job *job, int (*func)(void *arg),
+				void *arg)
+{
+	job->func = func;
+	job->arg = arg;
+	job->cpu = 0;
+	mp_job_run(job);
+}
+
+static inline int mp_job_join(struct mp_job *job)
+{
+	return job->ret;
+}
+
+static inline int mp_job_cpus(void)
+{
+	return 0;
+}
+
+static inline bool mp_job_secondary(void)
+{
+	return false;
+}
+
+static inline void mp_job_stop_cpus(void)
+{
+}
+
+static inline void mp_lock(struct mp_lock *lock)
+{
+}
+
+static inline void mp_unlock(struct mp_lock *lock)
+{
+}
+#endif
+
+/**
+ * arch_mp_job_cpus() - Get the number of secondary CPUs available for jobs
+ *
+ * @return number of CPUs, which are numbered from 1
+ */
+int arch_mp_job_cpus(void);
+
+/**
+ * arch_mp_job_cpu() - Get the CPU this is running on
+ *
+ * The default implementation returns 0.
+ *
+ * @return CPU number as used by arch_mp_job_start(), 0 for the boot CPU
+ */
+int arch_mp_job_cpu(void);
+
+/**
+ * arch_mp_job_start() - Start a job on a secondary CPU
+ *
+ * The CPU must call mp_job_run() on the job. It is not running any other job.
+ *
+ * @cpu: CPU to run the job on
+ * @job: Job to run
+ * @return 0 if OK, -ve on error, in which case the job is run on the boot CPU
+ */
+int arch_mp_job_start(int cpu, struct mp_job *job);
+
+/**
+ * arch_mp_job_join() - Wait for a job on a secondary CPU to finish
+ *
+ * The default implementation waits for the job's @done flag to be set.
+ *
+ * @cpu: CPU running the job
+ * @job: Job to wait for
+ */
+void arch_mp_job_join(int cpu, struct mp_job *job);
+
+/**
+ * arch_mp_job_stop() - Stop a secondary CPU which may have run jobs
+ *
+ * This is called for every possible CPU, whether or not it was used, and
+ * never while it is running a job. The default implementation does nothing.
+ *
+ * @cpu: CPU to stop
+ */
+void arch_mp_job_stop(int cpu);
+
+#endif
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Minimal TCP client, enough to download a file from a server
+ *
+ * Only one connection is supported at a time and U-Boot is always the
+ * client. The data received is not buffered: it is handed to the caller as
+ * each segment arrives, along with its offset in the stream, so the caller
+ * can store it directly at its final location.
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	Internet Protocol (IP) + TCP header.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgement number	*/
+	u8		tcp_hlen;	/* Header length / 4, in top 4 bits */
+	u8		tcp_flags;	/* Control flags		*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_ugr;	/* Urgent pointer		*/
+} __attribute__((packed));
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PUSH	0x08
+#define TCP_ACK		0x10
+#define TCP_URG		0x20
+
+/* Options carried by a SYN: MSS and window scale, padded to 32 bits */
+#define TCP_O_END	0
+#define TCP_O_NOP	1
+#define TCP_O_MSS	2
+#define TCP_O_WS	3
+#define TCP_SYN_OPT_SIZE	8
+
+/* Largest segment we can receive in one Ethernet frame */
+#define TCP_MSS		(1500 - IP_TCP_HDR_SIZE)
+
+/* Events reported to the user of the connection */
+enum tcp_event {
+	TCP_EVENT_CONNECTED,	/* Handshake done, tcp_send() may be used */
+	TCP_EVENT_CLOSED,	/* Remote closed after sending all its data */
+	TCP_EVENT_RESET,	/* Connection refused, reset or timed out */
+};
+
+/**
+ * typedef tcp_rx_handler - Called with data received on the connection
+ *
+ * Segments are passed on as they arrive, so they may be out of order and
+ * the same data may be passed more than once after a retransmit. Data is
+ * only passed once it is known to fit in the receive window.
+ *
+ * @offset:	Offset of @data in the stream, starting at 0
+ * @data:	Data received
+ * @len:	Number of bytes at @data
+ * @return 0 if OK, -EAGAIN to drop the segment so that the remote sends it
+ * again later, other -ve value to abort the connection
+ */
+typedef int tcp_rx_handler(u32 offset, const uchar *data, unsigned int len);
+
+/**
+ * typedef tcp_event_handler - Called when the connection changes state
+ *
+ * @event:	Event which happened
+ */
+typedef void tcp_event_handler(enum tcp_event event);
+
+/**
+ * tcp_connect() - Open a connection to a server
+ *
+ * This sends a SYN and returns. The connection is reported as up through
+ * @event, once the server has answered.
+ *
+ * @dest:	Server IP address
+ * @dport:	Server port
+ * @rx:		Handler for data received
+ * @event:	Handler for events on the connection
+ * @return 0 if OK, -ve on error
+ */
+int tcp_connect(struct in_addr dest, int dport, tcp_rx_handler *rx,
+		tcp_event_handler *event);
+
+/**
+ * tcp_send() - Send data on the connection
+ *
+ * Only one segment may be in flight, so this fails until the previous one
+ * has been acknowledged. It is retransmitted as needed.
+ *
+ * @data:	Data to send
+ * @len:	Number of bytes, at most the MSS given by the remote
+ * @return 0 if OK, -EBUSY if data is still unacknowledged, -ENOTCONN if
+ * the connection is not up, -E2BIG if @len is too large
+ */
+int tcp_send(const void *data, unsigned int len);
+
+/**
+ * tcp_close() - Close the connection
+ *
+ * This sends a FIN if the remote has already closed its side, otherwise a
+ * RST, since no more data can be received after this. No more events are
+ * reported.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_set_tcp_header() - Set up the IP and TCP headers of a segment
+ *
+ * Any payload must already be at @pkt + IP_TCP_HDR_SIZE, since it is
+ * included in the checksum. A SYN has no payload but carries the options
+ * the connection uses.
+ *
+ * @pkt:	Start of IP header
+ * @dest:	Destination IP address
+ * @dport:	Destination port
+ * @sport:	Source port
+ * @payload_len:	Number of payload bytes
+ * @action:	TCP flags to send (TCP_SYN, TCP_ACK...)
+ * @tcp_seq_num:	Sequence number
+ * @tcp_ack_num:	Acknowledgement number
+ * @return size of the IP and TCP headers, including options
+ */
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num);
+
+/**
+ * tcp_receive() - Handle a TCP packet received by the network stack
+ *
+ * @ip:		IP header of the packet
+ * @len:	Length of the packet from the start of the IP header
+ */
+void tcp_receive(struct ip_tcp_hdr *ip, int len);
+
+#endif /* __TCP_H__ */
@@ -11,6 +11,25 @@
 
 struct device_node;
 
+/**
+ * struct of_live_stats - Information about the live tree
+ *
+ * @size: Bytes allocated when the tree was built
+ * @lazy_size: Bytes allocated since then, to decode properties on first use
+ * @nodes: Number of nodes
+ * @props: Number of properties decoded so far
+ * @lazy_nodes: Number of nodes whose properties are not decoded yet
+ * @build_us: Time taken to build the tree, in microseconds
+ */
+struct of_live_stats {
+	ulong size;
+	ulong lazy_size;
+	int nodes;
+	int props;
+	int lazy_nodes;
+	ulong build_us;
+};
+
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
  *
@@ -20,4 +39,11 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_get_stats() - Get information about the last live tree built
+ *
+ * @return pointer to the information
+ */
+const struct of_live_stats *of_live_get_stats(void);
+
 #endif
@@ -337,6 +337,21 @@ void os_abort(void);
  */
 int os_mprotect_allow(void *start, size_t len);
 
+/**
+ * os_persistent_file() - Get the path of a file for test data
+ *
+ * Tests which need a file on the host put it in the directory given by the
+ * U_BOOT_PERSISTENT_DATA_DIR environment variable, which test/py sets. If
+ * that is not set, the host's temporary directory is used, so that files
+ * are never left in the current directory.
+ *
+ * @buf:	Returns the full path of the file
+ * @maxsize:	Size of @buf
+ * @fname:	Leaf name of the file
+ * @return 0 if OK, -ENOSPC if @buf is too small
+ */
+int os_persistent_file(char *buf, int maxsize, const char *fname);
+
 /**
  * os_write_file() - Write a file to the host filesystem
  *
@@ -364,6 +379,25 @@ int os_write_file(const char *name, const void *buf, int size);
  */
 int os_read_file(const char *name, void **bufp, int *sizep);
 
+/**
+ * os_thread_start() - Start a host thread
+ *
+ * This is used to run jobs in parallel, see mp_job.h
+ *
+ * @threadp:	Returns the thread, to pass to os_thread_join()
+ * @func:	Function to run in the thread
+ * @arg:	Argument for @func
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_start(void **threadp, void *(*func)(void *), void *arg);
+
+/**
+ * os_thread_join() - Wait for a host thread to finish
+ *
+ * @thread:	Thread returned by os_thread_start()
+ */
+void os_thread_join(void *thread);
+
 /*
  * os_find_text_base() - Find the text section in this running process
  *
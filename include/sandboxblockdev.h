@@ -12,6 +12,7 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+	unsigned long read_count;	/* calls to read(), for testing */
 };
 
 int host_dev_bind(int dev, char *filename);
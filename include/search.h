@@ -38,8 +38,9 @@ typedef struct entry {
 	int flags;
 } ENTRY;
 
-/* Opaque type for internal use.  */
+/* Opaque types for internal use.  */
 struct _ENTRY;
+struct hnode;
 
 /*
  * Family of hash table handling functions.  The functions also
@@ -52,6 +53,17 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int deleted;		/* deleted slots in table */
+	/* Previous table, whose entries are being moved to table */
+	struct _ENTRY *old_table;
+	unsigned int old_size;
+	unsigned int rehash_idx;	/* last slot moved from old_table */
+	/* All entries in the order added, with index_sorted sorted by key */
+	struct hnode **index;
+	unsigned int index_len;
+	unsigned int index_sorted;
+	unsigned int index_alloc;
+	unsigned int index_holes;	/* deleted entries in index */
 /*
  * Callback function which will check whether the given change for variable
  * "__item" to "newval" may be applied or not, and possibly apply such change.
@@ -63,7 +75,10 @@ struct hsearch_data {
 		int flag);
 };
 
-/* Create a new hash table which will contain at most "__nel" elements.  */
+/*
+ * Create a new hash table with room for "__nel" elements. The table grows
+ * when more are added.
+ */
 extern int hcreate_r(size_t __nel, struct hsearch_data *__htab);
 
 /* Destroy current internal hash table.  */
@@ -15,12 +15,17 @@
  * @start: Store the starting mallinfo when doing leak test
  * @priv: A pointer to some other info some suites want to track
  * @of_root: Record of the livetree root node (used for setting up tests)
+ * @malloc_count: Number of blocks allocated when the test started, see
+ *	ut_leak_start()
+ * @malloc_mark: Mark from malloc_leaks_mark() when the test started
  */
 struct unit_test_state {
 	int fail_count;
 	struct mallinfo start;
 	void *priv;
 	struct device_node *of_root;
+	ulong malloc_count;
+	ulong malloc_mark;
 };
 
 /**
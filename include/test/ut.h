@@ -8,6 +8,7 @@
 #ifndef __TEST_UT_H
 #define __TEST_UT_H
 
+#include <hexdump.h>
 #include <linux/err.h>
 
 struct unit_test_state;
@@ -38,6 +39,38 @@ void ut_failf(struct unit_test_state *uts, const char *fname, int line,
 	      const char *func, const char *cond, const char *fmt, ...)
 			__attribute__ ((format (__printf__, 6, 7)));
 
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+/**
+ * ut_leak_start() - Start looking for malloc() leaks
+ *
+ * This is called before each test, so that ut_assert_noleaks() can check
+ * for blocks allocated by the test which are still allocated.
+ *
+ * @uts: Test state
+ */
+void ut_leak_start(struct unit_test_state *uts);
+
+/**
+ * ut_check_leaks() - Check for blocks allocated but not freed by a test
+ *
+ * With CONFIG_MALLOC_TRACK_CALLERS this counts the blocks allocated since
+ * ut_leak_start() which are still allocated, and prints who allocated them.
+ * Otherwise it counts how many more blocks are allocated than before.
+ *
+ * @uts: Test state
+ * @return number of blocks leaked, 0 if none
+ */
+ulong ut_check_leaks(struct unit_test_state *uts);
+#else
+static inline void ut_leak_start(struct unit_test_state *uts)
+{
+}
+
+static inline ulong ut_check_leaks(struct unit_test_state *uts)
+{
+	return 0;
+}
+#endif
 
 /* Assert that a condition is non-zero */
 #define ut_assert(cond)							\
@@ -148,4 +181,16 @@ void ut_failf(struct unit_test_state *uts, const char *fname, int line,
 /* Assert that an operation succeeds (returns 0) */
 #define ut_assertok(cond)	ut_asserteq(0, cond)
 
+/* Assert that the test has freed every block it allocated */
+#define ut_assert_noleaks() {						\
+	ulong __leaks = ut_check_leaks(uts);				\
+									\
+	if (__leaks) {							\
+		ut_failf(uts, __FILE__, __LINE__, __func__,		\
+			 "no malloc() leaks",				\
+			 "%lu blocks still allocated", __leaks);	\
+		return CMD_RET_FAILURE;					\
+	}								\
+}
+
 #endif
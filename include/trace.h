@@ -28,6 +28,7 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_BOOTSTAGE,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -36,6 +37,24 @@ struct trace_output_func {
 	uint32_t call_count;		/* Number of times called */
 };
 
+enum {
+	TRACE_SPAN_NAME_LEN	= 40,	/* Space for a bootstage record name */
+
+	TRACE_SPANF_MARK	= 1 << 0,	/* A mark, not a span */
+};
+
+/*
+ * A bootstage mark or span, as written to the profile output file. Times are
+ * from timer_get_boot_us().
+ */
+struct trace_output_span {
+	uint32_t start_us;		/* Start time, or time of a mark */
+	uint32_t duration_us;		/* Duration of a span, 0 for a mark */
+	uint32_t depth;			/* Nesting depth, 0 if outermost */
+	uint32_t flags;			/* TRACE_SPANF_... */
+	char name[TRACE_SPAN_NAME_LEN];	/* Record name, nul-terminated */
+};
+
 /* A header at the start of the trace output buffer */
 struct trace_output_hdr {
 	enum trace_chunk_type type;	/* Record type */
@@ -30,6 +30,19 @@ uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 
+/**
+ * crc32_bytewise() - Calculate crc32() one byte at a time
+ *
+ * This gives the same result as crc32() without using the slice-by-8
+ * tables, which are not kept for EFI runtime services.
+ *
+ * @crc:	CRC to start from, 0 for a new CRC
+ * @buf:	Data to checksum
+ * @len:	Number of bytes in @buf
+ * @return updated CRC
+ */
+uint32_t crc32_bytewise(uint32_t crc, const unsigned char *buf, uint len);
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
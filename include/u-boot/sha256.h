@@ -19,6 +19,31 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/**
+ * sha256_blocks_generic() - Hash whole blocks in portable C
+ *
+ * This is the SHA256 block function used when there is no faster one for
+ * the CPU.
+ *
+ * @state:	Hash state to update (sha256_context.state)
+ * @data:	Data to hash
+ * @blocks:	Number of 64-byte blocks in @data, must be at least 1
+ */
+void sha256_blocks_generic(uint32_t state[8], const uint8_t *data,
+			   unsigned int blocks);
+
+/**
+ * sha256_blocks_arch() - Hash whole blocks with an arch-specific function
+ *
+ * This is provided by the architecture when CONFIG_SHA256_ARCH is enabled,
+ * and has the same arguments as sha256_blocks_generic().
+ *
+ * @return 0 if the blocks were hashed, -ENOSYS if this CPU does not have the
+ * instructions needed, in which case sha256_blocks_generic() is used
+ */
+int sha256_blocks_arch(uint32_t state[8], const uint8_t *data,
+		       unsigned int blocks);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
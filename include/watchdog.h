@@ -73,6 +73,31 @@ int init_func_watchdog_reset(void);
 	#endif /* CONFIG_WATCHDOG && !__ASSEMBLY__ */
 #endif /* CONFIG_HW_WATCHDOG */
 
+/*
+ * Jobs on secondary CPUs may call code which resets the watchdog, but only
+ * the boot CPU looks after it, see mp_job.h
+ */
+#if !defined(USE_HOSTCC) && !defined(__ASSEMBLY__)
+#if CONFIG_IS_ENABLED(MP_JOB) && \
+	(defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG))
+#include <mp_job.h>
+
+static inline void mp_job_watchdog_reset(void)
+{
+	if (mp_job_secondary())
+		return;
+#ifdef CONFIG_HW_WATCHDOG
+	hw_watchdog_reset();
+#else
+	watchdog_reset();
+#endif
+}
+
+#undef WATCHDOG_RESET
+#define WATCHDOG_RESET mp_job_watchdog_reset
+#endif
+#endif
+
 /*
  * Prototypes from $(CPU)/cpu.c.
  */
@@ -76,6 +76,190 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id)
 	return compat_names[id];
 }
 
+#if CONFIG_IS_ENABLED(OF_LOOKUP_CACHE)
+/* Number of paths remembered, a power of two */
+#define FDT_PATH_CACHE_SIZE	16
+/* Longer paths are not cached */
+#define FDT_PATH_CACHE_LEN	64
+/* Larger phandles are not cached, to bound the size of the table */
+#define FDT_PHANDLE_CACHE_MAX	0x10000
+
+struct fdt_path_cache {
+	char path[FDT_PATH_CACHE_LEN];
+	int offset;
+};
+
+/*
+ * Lookups in the control FDT, which libfdt does by walking the whole tree.
+ * This is only used once relocated, since it is kept in BSS.
+ *
+ * Nodes can move without the size of the tree changing, e.g. when one node
+ * is deleted and another of the same size added elsewhere. So each cached
+ * offset is checked before it is used: a phandle must still be at that
+ * offset, and for a path, the node at that offset must still have that full
+ * path. If not, the cache is dropped. Lookups which fail are not cached,
+ * since a node may be added. Only full paths are cached, not aliases or
+ * paths which leave out a unit address, so that the check is exact.
+ *
+ * @blob: Blob the cache is for
+ * @struct_size: Size of its structure block; the cache is dropped when this
+ *	changes, since nodes have certainly moved
+ * @phandles: Node offset for each phandle up to @max_phandle, or
+ *	-FDT_ERR_NOTFOUND. This is NULL until the first phandle lookup
+ * @max_phandle: Largest phandle in @phandles
+ * @no_phandles: true if the table could not be built, e.g. because the
+ *	phandles are too large or there is no memory, so it is not tried again
+ *	until the cache is dropped
+ * @paths: Results of recent path lookups
+ */
+static struct {
+	const void *blob;
+	int struct_size;
+	int *phandles;
+	uint max_phandle;
+	bool no_phandles;
+	struct fdt_path_cache paths[FDT_PATH_CACHE_SIZE];
+} fdt_cache;
+
+void fdtdec_cache_invalidate(void)
+{
+	free(fdt_cache.phandles);
+	memset(&fdt_cache, '\0', sizeof(fdt_cache));
+}
+
+/* Check if lookups in @blob can use the cache, emptying it if out of date */
+static bool fdtdec_cache_valid(const void *blob)
+{
+	if (!(gd->flags & GD_FLG_RELOC) || blob != gd->fdt_blob)
+		return false;
+	if (fdt_cache.blob != blob ||
+	    fdt_cache.struct_size != fdt_size_dt_struct(blob)) {
+		fdtdec_cache_invalidate();
+		fdt_cache.blob = blob;
+		fdt_cache.struct_size = fdt_size_dt_struct(blob);
+	}
+
+	return true;
+}
+
+/* Drop the cache after finding that a node has moved */
+static void fdtdec_cache_moved(const void *blob)
+{
+	debug("%s: Nodes have moved, dropping cache\n", __func__);
+	fdtdec_cache_invalidate();
+	fdt_cache.blob = blob;
+	fdt_cache.struct_size = fdt_size_dt_struct(blob);
+}
+
+/* Build the phandle table with a single walk of the tree */
+static int fdtdec_cache_phandles(const void *blob)
+{
+	uint max_phandle = fdt_get_max_phandle(blob);
+	int offset, depth = 0;
+	uint phandle, i;
+
+	if (!max_phandle || max_phandle > FDT_PHANDLE_CACHE_MAX)
+		return -ENOENT;
+	fdt_cache.phandles = malloc((max_phandle + 1) * sizeof(int));
+	if (!fdt_cache.phandles)
+		return -ENOMEM;
+	for (i = 0; i <= max_phandle; i++)
+		fdt_cache.phandles[i] = -FDT_ERR_NOTFOUND;
+	fdt_cache.max_phandle = max_phandle;
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle <= max_phandle &&
+		    fdt_cache.phandles[phandle] < 0)
+			fdt_cache.phandles[phandle] = offset;
+	}
+
+	return 0;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	int offset;
+
+	if (!fdtdec_cache_valid(blob) || !phandle || phandle == -1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+	if (!fdt_cache.phandles && !fdt_cache.no_phandles &&
+	    fdtdec_cache_phandles(blob))
+		fdt_cache.no_phandles = true;
+	if (fdt_cache.no_phandles || phandle > fdt_cache.max_phandle)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	offset = fdt_cache.phandles[phandle];
+	if (offset < 0)
+		return fdt_node_offset_by_phandle(blob, phandle);
+	if (fdt_get_phandle(blob, offset) != phandle) {
+		fdtdec_cache_moved(blob);
+		return fdt_node_offset_by_phandle(blob, phandle);
+	}
+
+	return offset;
+}
+
+static uint fdtdec_hash(const char *str)
+{
+	uint hash = 0;
+
+	for (; *str; str++)
+		hash = hash * 31 + *str;
+
+	return hash;
+}
+
+/* Check that the node at @offset has the full path @path */
+static bool fdtdec_path_is(const void *blob, int offset, const char *path)
+{
+	char buf[FDT_PATH_CACHE_LEN];
+
+	return !fdt_get_path(blob, offset, buf, sizeof(buf)) &&
+		!strcmp(buf, path);
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	struct fdt_path_cache *entry;
+	int offset;
+
+	if (!fdtdec_cache_valid(blob) || strlen(path) >= FDT_PATH_CACHE_LEN)
+		return fdt_path_offset(blob, path);
+
+	entry = &fdt_cache.paths[fdtdec_hash(path) &
+				 (FDT_PATH_CACHE_SIZE - 1)];
+	if (*entry->path && !strcmp(entry->path, path)) {
+		if (fdtdec_path_is(blob, entry->offset, path))
+			return entry->offset;
+		fdtdec_cache_moved(blob);
+	}
+
+	offset = fdt_path_offset(blob, path);
+	if (offset >= 0 && fdtdec_path_is(blob, offset, path)) {
+		strcpy(entry->path, path);
+		entry->offset = offset;
+	}
+
+	return offset;
+}
+#else
+void fdtdec_cache_invalidate(void)
+{
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+#endif /* OF_LOOKUP_CACHE */
+
 fdt_addr_t fdtdec_get_addr_size_fixed(const void *blob, int node,
 				      const char *prop_name, int index, int na,
 				      int ns, fdt_size_t *sizep,
@@ -363,7 +547,7 @@ int fdtdec_next_alias(const void *blob, const char *name, enum fdt_compat_id id,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -398,7 +582,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -429,7 +613,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -512,7 +696,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -551,7 +735,7 @@ int fdtdec_get_alias_highest_id(const void *blob, const char *base)
 
 	debug("Looking for highest alias id for '%s'\n", base);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -581,7 +765,7 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
 	return fdt_getprop(blob, chosen_node, name, NULL);
 }
 
@@ -592,7 +776,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -643,7 +827,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -774,7 +958,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
+				node = fdtdec_node_offset_by_phandle(blob,
 								  phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
@@ -900,7 +1084,7 @@ int fdtdec_get_config_int(const void *blob, const char *prop_name,
 	int config_node;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return default_val;
 	return fdtdec_get_int(blob, config_node, prop_name, default_val);
@@ -912,7 +1096,7 @@ int fdtdec_get_config_bool(const void *blob, const char *prop_name)
 	const void *prop;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return 0;
 	prop = fdt_get_property(blob, config_node, prop_name, NULL);
@@ -927,7 +1111,7 @@ char *fdtdec_get_config_string(const void *blob, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	nodeoffset = fdt_path_offset(blob, "/config");
+	nodeoffset = fdtdec_path_offset(blob, "/config");
 	if (nodeoffset < 0)
 		return NULL;
 
@@ -1093,7 +1277,7 @@ int fdtdec_setup_mem_size_base_fdt(const void *blob)
 	int ret, mem;
 	struct fdt_resource res;
 
-	mem = fdt_path_offset(blob, "/memory");
+	mem = fdtdec_path_offset(blob, "/memory");
 	if (mem < 0) {
 		debug("%s: Missing /memory node\n", __func__);
 		return -EINVAL;
@@ -1333,7 +1517,7 @@ int fdtdec_add_reserved_memory(void *blob, const char *basename,
 	char name[64];
 
 	/* create an empty /reserved-memory node if one doesn't exist */
-	parent = fdt_path_offset(blob, "/reserved-memory");
+	parent = fdtdec_path_offset(blob, "/reserved-memory");
 	if (parent < 0) {
 		parent = fdtdec_init_reserved_memory(blob);
 		if (parent < 0)
@@ -1433,7 +1617,7 @@ int fdtdec_get_carveout(const void *blob, const char *node, const char *name,
 	int offset, len;
 	fdt_size_t size;
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0)
 		return offset;
 
@@ -1455,7 +1639,7 @@ int fdtdec_get_carveout(const void *blob, const char *node, const char *name,
 
 	phandle = fdt32_to_cpu(prop[index]);
 
-	offset = fdt_node_offset_by_phandle(blob, phandle);
+	offset = fdtdec_node_offset_by_phandle(blob, phandle);
 	if (offset < 0) {
 		debug("failed to find node for phandle %u\n", phandle);
 		return offset;
@@ -1494,7 +1678,7 @@ int fdtdec_set_carveout(void *blob, const char *node, const char *prop_name,
 		return err;
 	}
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0) {
 		debug("failed to find offset for node %s: %d\n", node, offset);
 		return offset;
@@ -1624,7 +1808,7 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 	debug("%s: board_id=%d\n", __func__, board_id);
 	if (!area)
 		area = "/memory";
-	node = fdt_path_offset(blob, area);
+	node = fdtdec_path_offset(blob, area);
 	if (node < 0) {
 		debug("No %s node found\n", area);
 		return -ENOENT;
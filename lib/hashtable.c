@@ -59,14 +59,27 @@
  * which describes the current status.
  */
 
+/*
+ * Each entry is allocated once, together with its key, and never moves. The
+ * hash table and the index only hold pointers to entries, so an ENTRY pointer
+ * returned by hsearch_r() stays valid while the table is resized.
+ */
+struct hnode {
+	ENTRY entry;		/* must be first */
+	unsigned int hash;	/* hash of the key, see hash_key() */
+	unsigned int pos;	/* position in htab->index */
+	char key[];
+};
+
 typedef struct _ENTRY {
-	int used;
-	ENTRY entry;
+	int used;		/* USED_FREE, USED_DELETED or the first index */
+	struct hnode *node;
 } _ENTRY;
 
+/* Number of slots of the old table moved to the new one on each operation */
+#define HREHASH_STEP	16
 
-static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
-	int idx);
+static void _hdelete(struct hsearch_data *htab, struct hnode *node);
 
 /*
  * hcreate()
@@ -90,6 +103,18 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Return the first prime number not smaller than nel, and at least 3 */
+static unsigned int hprime(size_t nel)
+{
+	if (nel < 3)
+		nel = 3;
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -97,6 +122,9 @@ static int isprime(unsigned int number)
  * indexing as explained in the comment for the hsearch function.
  * The contents of the table is zeroed, especially the field used
  * becomes zero.
+ *
+ * The size given is only a starting point: the table grows as entries are
+ * added, see hgrow().
  */
 
 int hcreate_r(size_t nel, struct hsearch_data *htab)
@@ -111,13 +139,17 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table != NULL)
 		return 0;
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hprime(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
+	htab->old_table = NULL;
+	htab->old_size = 0;
+	htab->rehash_idx = 0;
+	htab->index = NULL;
+	htab->index_len = 0;
+	htab->index_sorted = 0;
+	htab->index_alloc = 0;
+	htab->index_holes = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (_ENTRY *) calloc(htab->size + 1, sizeof(_ENTRY));
@@ -149,18 +181,80 @@ void hdestroy_r(struct hsearch_data *htab)
 	}
 
 	/* free used memory */
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			ENTRY *ep = &htab->table[i].entry;
+	for (i = 0; i < htab->index_len; ++i) {
+		struct hnode *node = htab->index[i];
 
-			free((void *)ep->key);
-			free(ep->data);
+		if (node) {
+			free(node->entry.data);
+			free(node);
 		}
 	}
+	free(htab->index);
+	free(htab->old_table);
 	free(htab->table);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->old_table = NULL;
+	htab->index = NULL;
+	htab->index_len = 0;
+	htab->index_alloc = 0;
+	htab->filled = 0;
+}
+
+/*
+ * The index
+ */
+
+/*
+ * All entries are also kept in an array, htab->index, in the order they
+ * were added. This is used to walk the table and to export it: the part up
+ * to index_sorted is sorted by key, so only the entries added since the
+ * last export need to be sorted and merged in, see hindex_sort(). Deleted
+ * entries leave a NULL behind, which is removed by hindex_compact().
+ */
+
+static void hindex_compact(struct hsearch_data *htab)
+{
+	unsigned int i, n, sorted = 0;
+
+	for (i = 0, n = 0; i < htab->index_len; i++) {
+		struct hnode *node = htab->index[i];
+
+		if (i == htab->index_sorted)
+			sorted = n;
+		if (!node)
+			continue;
+		node->pos = n;
+		htab->index[n++] = node;
+	}
+	if (i == htab->index_sorted)
+		sorted = n;
+	htab->index_len = n;
+	htab->index_sorted = sorted;
+	htab->index_holes = 0;
+}
+
+static int hindex_add(struct hsearch_data *htab, struct hnode *node)
+{
+	if (htab->index_holes > htab->index_len / 2)
+		hindex_compact(htab);
+
+	if (htab->index_len == htab->index_alloc) {
+		unsigned int alloc = htab->index_alloc ?
+			htab->index_alloc * 2 : htab->size;
+		struct hnode **index;
+
+		index = realloc(htab->index, alloc * sizeof(*index));
+		if (!index)
+			return -ENOMEM;
+		htab->index = index;
+		htab->index_alloc = alloc;
+	}
+	node->pos = htab->index_len;
+	htab->index[htab->index_len++] = node;
+
+	return 0;
 }
 
 /*
@@ -170,9 +264,7 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
@@ -182,6 +274,11 @@ void hdestroy_r(struct hsearch_data *htab)
  * equality of the stored and the parameter value. This helps to prevent
  * unnecessary expensive calls of strcmp.
  *
+ * When the table gets 3/4 full (counting deleted slots) a larger one is
+ * allocated. Entries are moved over from the old table a few at a time by
+ * each following operation, see hrehash_step(), so no single call has to
+ * move the whole table. Until that is done, lookups check both tables.
+ *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
  *
@@ -194,230 +291,325 @@ void hdestroy_r(struct hsearch_data *htab)
  * - The standard implementation does not provide a way to update an
  *   existing entry.  This version will create a new entry or update an
  *   existing one when both "action == ENTER" and "item.data != NULL".
- * - Instead of returning 1 on success, we return the index into the
- *   internal hash table, which is also guaranteed to be positive.
- *   This allows us direct access to the found hash table slot for
- *   example for functions like hdelete().
+ * - Instead of returning 1 on success, we return a positive index for an
+ *   existing entry, which can be passed to hmatch_r() to continue with
+ *   the following entries. A new entry returns 1.
  */
 
-int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
-	     struct hsearch_data *htab)
+/* FNV-1a, which unlike a shift-and-add hash uses every character */
+static unsigned int hash_key(const char *key)
 {
-	unsigned int idx;
-	size_t key_len = strlen(match);
+	unsigned int hash = 2166136261u;
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
-		if (htab->table[idx].used <= 0)
-			continue;
-		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
-			*retval = &htab->table[idx].entry;
-			return idx;
-		}
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619;
 	}
 
-	__set_errno(ESRCH);
-	*retval = NULL;
-	return 0;
+	return hash;
 }
 
 /*
- * Compare an existing entry with the desired key, and overwrite if the action
- * is ENTER.  This is simply a helper function for hsearch_r().
+ * Look for key in one table. Returns its index if found. Otherwise returns
+ * 0 and, if insertp is not NULL, sets *insertp to the slot where it can be
+ * added, or 0 if the table is full.
  */
-static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
-	ENTRY **retval, struct hsearch_data *htab, int flag,
-	unsigned int hval, unsigned int idx)
-{
-	if (htab->table[idx].used == hval
-	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-		/* Overwrite existing value? */
-		if ((action == ENTER) && (item.data != NULL)) {
-			/* check for permission */
-			if (htab->change_ok != NULL && htab->change_ok(
-			    &htab->table[idx].entry, item.data,
-			    env_op_overwrite, flag)) {
-				debug("change_ok() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EPERM);
-				*retval = NULL;
-				return 0;
-			}
-
-			/* If there is a callback, call it */
-			if (htab->table[idx].entry.callback &&
-			    htab->table[idx].entry.callback(item.key,
-			    item.data, env_op_overwrite, flag)) {
-				debug("callback() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EINVAL);
-				*retval = NULL;
-				return 0;
-			}
-
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
-				__set_errno(ENOMEM);
-				*retval = NULL;
-				return 0;
-			}
-		}
-		/* return found entry */
-		*retval = &htab->table[idx].entry;
-		return idx;
-	}
-	/* keep searching */
-	return -1;
-}
-
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
-	      struct hsearch_data *htab, int flag)
+static unsigned int hprobe(_ENTRY *table, unsigned int size, unsigned int hash,
+			   const char *key, unsigned int *insertp)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
+	unsigned int hval, hval2, idx;
 	unsigned int first_deleted = 0;
-	int ret;
-
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
 
 	/*
 	 * First hash function:
 	 * simply take the modul but prevent zero.
 	 */
-	hval %= htab->size;
+	hval = hash % size;
 	if (hval == 0)
 		++hval;
 
-	/* The first index tried. */
+	/*
+	 * Second hash function:
+	 * as suggested in [Knuth]
+	 */
+	hval2 = 1 + hval % (size - 2);
+
 	idx = hval;
+	do {
+		if (table[idx].used == USED_FREE) {
+			if (insertp)
+				*insertp = first_deleted ? first_deleted : idx;
+			return 0;
+		}
+		if (table[idx].used == USED_DELETED) {
+			if (!first_deleted)
+				first_deleted = idx;
+		} else if (table[idx].used == hval &&
+			   !strcmp(key, table[idx].node->entry.key)) {
+			return idx;
+		}
 
-	if (htab->table[idx].used) {
 		/*
-		 * Further action might be required according to the
-		 * action value.
+		 * Because SIZE is prime this guarantees to
+		 * step through all available indices.
 		 */
-		unsigned hval2;
+		if (idx <= hval2)
+			idx = size + idx - hval2;
+		else
+			idx -= hval2;
+	} while (idx != hval);
 
-		if (htab->table[idx].used == USED_DELETED
-		    && !first_deleted)
-			first_deleted = idx;
+	/* We visited all entries */
+	if (insertp)
+		*insertp = first_deleted;
 
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
-		if (ret != -1)
-			return ret;
+	return 0;
+}
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+static void hslot_set(struct hsearch_data *htab, unsigned int idx,
+		      struct hnode *node)
+{
+	unsigned int hval = node->hash % htab->size;
 
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
+	if (htab->table[idx].used == USED_DELETED)
+		--htab->deleted;
+	htab->table[idx].used = hval ? hval : 1;
+	htab->table[idx].node = node;
+}
 
-			if (htab->table[idx].used == USED_DELETED
-			    && !first_deleted)
-				first_deleted = idx;
+/* Move up to count slots from the old table to the new one */
+static void hrehash_step(struct hsearch_data *htab, unsigned int count)
+{
+	unsigned int idx;
+
+	while (htab->old_table && count--) {
+		_ENTRY *slot = &htab->old_table[++htab->rehash_idx];
 
-			/* If entry is found use it. */
-			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
-			if (ret != -1)
-				return ret;
+		if (slot->used > 0) {
+			hprobe(htab->table, htab->size, slot->node->hash,
+			       slot->node->entry.key, &idx);
+			hslot_set(htab, idx, slot->node);
+			/* Leave a deleted slot so that probing carries on */
+			slot->used = USED_DELETED;
+		}
+		if (htab->rehash_idx == htab->old_size) {
+			free(htab->old_table);
+			htab->old_table = NULL;
 		}
-		while (htab->table[idx].used != USED_FREE);
 	}
+}
 
-	/* An empty bucket has been found. */
-	if (action == ENTER) {
-		/*
-		 * If table is full and another entry should be
-		 * entered return with error.
-		 */
-		if (htab->filled == htab->size) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
-		}
+/*
+ * Start moving to a table twice the size of the number of entries. If
+ * there is not enough memory, carry on with the current table until it is
+ * full.
+ */
+static void hgrow(struct hsearch_data *htab)
+{
+	unsigned int size;
+	_ENTRY *table;
 
-		/*
-		 * Create new entry;
-		 * create copies of item.key and item.data
-		 */
-		if (first_deleted)
-			idx = first_deleted;
-
-		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
-		if (!htab->table[idx].entry.key ||
-		    !htab->table[idx].entry.data) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
+	/* Finish off the previous resize first */
+	hrehash_step(htab, UINT_MAX);
+
+	size = hprime(2 * (htab->filled + 1));
+	table = calloc(size + 1, sizeof(_ENTRY));
+	if (!table)
+		return;
+	debug("hgrow: %u entries, size %u -> %u\n", htab->filled, htab->size,
+	      size);
+
+	htab->old_table = htab->table;
+	htab->old_size = htab->size;
+	htab->rehash_idx = 0;
+	htab->table = table;
+	htab->size = size;
+	htab->deleted = 0;
+}
+
+/* Find the slot holding a key, in the new table or else the old one */
+static _ENTRY *hlookup(struct hsearch_data *htab, unsigned int hash,
+		       const char *key)
+{
+	unsigned int idx;
+
+	if (!htab->table)
+		return NULL;
+
+	idx = hprobe(htab->table, htab->size, hash, key, NULL);
+	if (idx)
+		return &htab->table[idx];
+	if (htab->old_table) {
+		idx = hprobe(htab->old_table, htab->old_size, hash, key, NULL);
+		if (idx)
+			return &htab->old_table[idx];
+	}
+
+	return NULL;
+}
+
+int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
+	     struct hsearch_data *htab)
+{
+	unsigned int idx;
+	size_t key_len = strlen(match);
+
+	/* The index returned is one more than the position in htab->index */
+	for (idx = last_idx; idx < htab->index_len; ++idx) {
+		struct hnode *node = htab->index[idx];
+
+		if (!node)
+			continue;
+		if (!strncmp(match, node->entry.key, key_len)) {
+			*retval = &node->entry;
+			return idx + 1;
 		}
+	}
 
-		++htab->filled;
+	__set_errno(ESRCH);
+	*retval = NULL;
+	return 0;
+}
 
-		/* This is a new entry, so look up a possible callback */
-		env_callback_init(&htab->table[idx].entry);
-		/* Also look for flags */
-		env_flags_init(&htab->table[idx].entry);
+/*
+ * Overwrite an existing entry if the action is ENTER. This is simply a
+ * helper function for hsearch_r().
+ */
+static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
+	ENTRY **retval, struct hsearch_data *htab, int flag,
+	struct hnode *node)
+{
+	ENTRY *ep = &node->entry;
 
+	/* Overwrite existing value? */
+	if ((action == ENTER) && (item.data != NULL)) {
 		/* check for permission */
 		if (htab->change_ok != NULL && htab->change_ok(
-		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
+		    ep, item.data, env_op_overwrite, flag)) {
 			debug("change_ok() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
 			__set_errno(EPERM);
 			*retval = NULL;
 			return 0;
 		}
 
 		/* If there is a callback, call it */
-		if (htab->table[idx].entry.callback &&
-		    htab->table[idx].entry.callback(item.key, item.data,
-		    env_op_create, flag)) {
+		if (ep->callback &&
+		    ep->callback(item.key, item.data, env_op_overwrite, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
 			__set_errno(EINVAL);
 			*retval = NULL;
 			return 0;
 		}
 
-		/* return new entry */
-		*retval = &htab->table[idx].entry;
-		return 1;
+		free(ep->data);
+		ep->data = strdup(item.data);
+		if (!ep->data) {
+			__set_errno(ENOMEM);
+			*retval = NULL;
+			return 0;
+		}
 	}
+	/* return found entry */
+	*retval = ep;
+	return node->pos + 1;
+}
 
-	__set_errno(ESRCH);
-	*retval = NULL;
-	return 0;
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab, int flag)
+{
+	struct hnode *node;
+	unsigned int hash;
+	unsigned int idx;
+	_ENTRY *slot;
+
+	hrehash_step(htab, HREHASH_STEP);
+
+	hash = hash_key(item.key);
+	slot = hlookup(htab, hash, item.key);
+	if (slot)
+		return _compare_and_overwrite_entry(item, action, retval, htab,
+						    flag, slot->node);
+
+	if (action != ENTER || !htab->table) {
+		__set_errno(ESRCH);
+		*retval = NULL;
+		return 0;
+	}
+
+	/* Keep the table at most 3/4 full, counting deleted slots */
+	if ((htab->filled + htab->deleted + 1) * 4 > htab->size * 3)
+		hgrow(htab);
+
+	/*
+	 * If table is full and another entry should be
+	 * entered return with error.
+	 */
+	hprobe(htab->table, htab->size, hash, item.key, &idx);
+	if (!idx) {
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
+
+	/*
+	 * Create new entry;
+	 * create copies of item.key and item.data
+	 */
+	node = malloc(sizeof(*node) + strlen(item.key) + 1);
+	if (!node) {
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
+	strcpy(node->key, item.key);
+	node->entry.key = node->key;
+	node->entry.data = strdup(item.data);
+	node->entry.callback = NULL;
+	node->entry.flags = 0;
+	node->hash = hash;
+	if (!node->entry.data || hindex_add(htab, node)) {
+		free(node->entry.data);
+		free(node);
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
+	hslot_set(htab, idx, node);
+
+	++htab->filled;
+
+	/* This is a new entry, so look up a possible callback */
+	env_callback_init(&node->entry);
+	/* Also look for flags */
+	env_flags_init(&node->entry);
+
+	/* check for permission */
+	if (htab->change_ok != NULL && htab->change_ok(
+	    &node->entry, item.data, env_op_create, flag)) {
+		debug("change_ok() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		_hdelete(htab, node);
+		__set_errno(EPERM);
+		*retval = NULL;
+		return 0;
+	}
+
+	/* If there is a callback, call it */
+	if (node->entry.callback &&
+	    node->entry.callback(item.key, item.data, env_op_create, flag)) {
+		debug("callback() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		_hdelete(htab, node);
+		__set_errno(EINVAL);
+		*retval = NULL;
+		return 0;
+	}
+
+	/* return new entry */
+	*retval = &node->entry;
+	return 1;
 }
 
 
@@ -431,38 +623,47 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
  * do that.
  */
 
-static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
-	int idx)
+static void _hdelete(struct hsearch_data *htab, struct hnode *node)
 {
+	_ENTRY *slot;
+
 	/* free used ENTRY */
-	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
-	ep->callback = NULL;
-	ep->flags = 0;
-	htab->table[idx].used = USED_DELETED;
+	debug("hdelete: DELETING key \"%s\"\n", node->entry.key);
+
+	/* Callbacks may have resized the table, so look the slot up again */
+	slot = hlookup(htab, node->hash, node->entry.key);
+	slot->used = USED_DELETED;
+	if (slot >= htab->table && slot <= htab->table + htab->size)
+		++htab->deleted;
+
+	htab->index[node->pos] = NULL;
+	++htab->index_holes;
+
+	free(node->entry.data);
+	free(node);
 
 	--htab->filled;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 {
-	ENTRY e, *ep;
-	int idx;
+	struct hnode *node;
+	_ENTRY *slot;
 
 	debug("hdelete: DELETE key \"%s\"\n", key);
 
-	e.key = (char *)key;
+	hrehash_step(htab, HREHASH_STEP);
 
-	idx = hsearch_r(e, FIND, &ep, htab, 0);
-	if (idx == 0) {
+	slot = hlookup(htab, hash_key(key), key);
+	if (!slot) {
 		__set_errno(ESRCH);
 		return 0;	/* not found */
 	}
+	node = slot->node;
 
 	/* Check for permission */
 	if (htab->change_ok != NULL &&
-	    htab->change_ok(ep, NULL, env_op_delete, flag)) {
+	    htab->change_ok(&node->entry, NULL, env_op_delete, flag)) {
 		debug("change_ok() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EPERM);
@@ -470,15 +671,15 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (htab->table[idx].entry.callback &&
-	    htab->table[idx].entry.callback(key, NULL, env_op_delete, flag)) {
+	if (node->entry.callback &&
+	    node->entry.callback(key, NULL, env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EINVAL);
 		return 0;
 	}
 
-	_hdelete(key, htab, ep, idx);
+	_hdelete(htab, node);
 
 	return 1;
 }
@@ -528,10 +729,58 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 
 static int cmpkey(const void *p1, const void *p2)
 {
-	ENTRY *e1 = *(ENTRY **) p1;
-	ENTRY *e2 = *(ENTRY **) p2;
+	struct hnode *e1 = *(struct hnode **) p1;
+	struct hnode *e2 = *(struct hnode **) p2;
 
-	return (strcmp(e1->key, e2->key));
+	return (strcmp(e1->entry.key, e2->entry.key));
+}
+
+/*
+ * Sort the index by key. The entries up to index_sorted are in order
+ * already, so only those added since are sorted, then merged in. When a
+ * sorted environment is imported the new entries are in order too, and
+ * no sorting is needed at all.
+ */
+static int hindex_sort(struct hsearch_data *htab)
+{
+	struct hnode **index = htab->index;
+	struct hnode **tail, **merged;
+	unsigned int n, ntail, i, j, k;
+
+	hindex_compact(htab);
+	n = htab->index_len;
+	tail = index + htab->index_sorted;
+	ntail = n - htab->index_sorted;
+
+	for (i = 1; i < ntail; i++) {
+		if (cmpkey(&tail[i - 1], &tail[i]) > 0) {
+			qsort(tail, ntail, sizeof(*tail), cmpkey);
+			break;
+		}
+	}
+
+	if (ntail && ntail < n && cmpkey(&tail[-1], &tail[0]) > 0) {
+		merged = malloc(n * sizeof(*merged));
+		if (!merged) {
+			__set_errno(ENOMEM);
+			return -1;
+		}
+		for (i = 0, j = htab->index_sorted, k = 0; k < n; k++) {
+			if (j == n || (i < htab->index_sorted &&
+				       cmpkey(&index[i], &index[j]) < 0))
+				merged[k] = index[i++];
+			else
+				merged[k] = index[j++];
+		}
+		memcpy(index, merged, n * sizeof(*merged));
+		free(merged);
+	}
+
+	for (i = 0; i < n; i++)
+		index[i]->pos = i;
+	htab->index_sorted = n;
+
+	return 0;
 }
 
 static int match_string(int flag, const char *str, const char *pat, void *priv)
@@ -592,14 +841,49 @@ static int match_entry(ENTRY *ep, int flag,
 	return 0;
 }
 
+/*
+ * Add up the length needed to export an entry. Returns 0 if the entry is
+ * not to be exported.
+ */
+static size_t hexport_len(ENTRY *ep, const char sep, int flag,
+			  int argc, char * const argv[])
+{
+	size_t totlen;
+	int found = match_entry(ep, flag, argc, argv);
+
+	if ((argc > 0) && (found == 0))
+		return 0;
+
+	if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+		return 0;
+
+	totlen = strlen(ep->key);
+
+	if (sep == '\0') {
+		totlen += strlen(ep->data);
+	} else {	/* check if escapes are needed */
+		char *s = ep->data;
+
+		while (*s) {
+			++totlen;
+			/* add room for needed escape chars */
+			if ((*s == sep) || (*s == '\\'))
+				++totlen;
+			++s;
+		}
+	}
+	totlen += 2;	/* for '=' and 'sep' char */
+
+	return totlen;
+}
+
 ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	ENTRY *list[htab->size];
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	int i;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -609,55 +893,18 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+
+	/* Sort the index by keys */
+	if (hindex_sort(htab))
+		return (-1);
+
 	/*
 	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * compute total length of the entries to export
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
-
-		if (htab->table[i].used > 0) {
-			ENTRY *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
-
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
-
-			list[n++] = ep;
-
-			totlen += strlen(ep->key);
-
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
-
-				while (*s) {
-					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
-			}
-			totlen += 2;	/* for '=' and 'sep' char */
-		}
-	}
-
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(ENTRY *), cmpkey);
+	for (i = 0, totlen = 0; i < htab->index_len; ++i)
+		totlen += hexport_len(&htab->index[i]->entry, sep, flag,
+				      argc, argv);
 
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
@@ -688,15 +935,19 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	 * Pass 2:
 	 * export sorted list of result data
 	 */
-	for (i = 0, p = res; i < n; ++i) {
+	for (i = 0, p = res; i < htab->index_len; ++i) {
+		ENTRY *ep = &htab->index[i]->entry;
 		const char *s;
 
-		s = list[i]->key;
+		if (!hexport_len(ep, sep, flag, argc, argv))
+			continue;
+
+		s = ep->key;
 		while (*s)
 			*p++ = *s++;
 		*p++ = '=';
 
-		s = list[i]->data;
+		s = ep->data;
 
 		while (*s) {
 			if ((*s == sep) || (*s == '\\'))
@@ -833,7 +1084,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. This is only
+	 * the starting size: the table grows if more entries are added.
 	 */
 
 	if (!htab->table) {
@@ -981,9 +1233,9 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(ENTRY *))
 	int i;
 	int retval;
 
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			retval = callback(&htab->table[i].entry);
+	for (i = 0; i < htab->index_len; ++i) {
+		if (htab->index[i]) {
+			retval = callback(&htab->index[i]->entry);
 			if (retval)
 				return retval;
 		}
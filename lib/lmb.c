@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -22,9 +23,9 @@ void lmb_dump_all(struct lmb *lmb)
 	      (unsigned long long)lmb->memory.size);
 	for (i = 0; i < lmb->memory.cnt; i++) {
 		debug("    memory.reg[0x%lx].base   = 0x%llx\n", i,
-		      (unsigned long long)lmb->memory.region[i].base);
+		      (unsigned long long)lmb_regions(&lmb->memory)[i].base);
 		debug("		   .size   = 0x%llx\n",
-		      (unsigned long long)lmb->memory.region[i].size);
+		      (unsigned long long)lmb_regions(&lmb->memory)[i].size);
 	}
 
 	debug("\n    reserved.cnt	   = 0x%lx\n",
@@ -33,9 +34,9 @@ void lmb_dump_all(struct lmb *lmb)
 		(unsigned long long)lmb->reserved.size);
 	for (i = 0; i < lmb->reserved.cnt; i++) {
 		debug("    reserved.reg[0x%lx].base = 0x%llx\n", i,
-		      (unsigned long long)lmb->reserved.region[i].base);
+		      (unsigned long long)lmb_regions(&lmb->reserved)[i].base);
 		debug("		     .size = 0x%llx\n",
-		      (unsigned long long)lmb->reserved.region[i].size);
+		      (unsigned long long)lmb_regions(&lmb->reserved)[i].size);
 	}
 #endif /* DEBUG */
 }
@@ -60,25 +61,45 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/*
+ * Find the last region whose base is at or below @addr, or -1 if none. Since
+ * regions are sorted and do not overlap, this is the only one which can
+ * contain @addr.
+ */
+static long lmb_find_below(struct lmb_region *rgn, phys_addr_t addr)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	long lo = 0, hi = rgn->cnt;
+	long mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (lmb_regions(rgn)[mid].base <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	return lo - 1;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/* Check whether region r contains the range (base, size) */
+static bool lmb_region_contains(struct lmb_region *rgn, long r,
+				phys_addr_t base, phys_size_t size)
 {
-	unsigned long i;
+	phys_addr_t rgnbase, rgnend;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
+	if (r < 0)
+		return false;
+	rgnbase = lmb_regions(rgn)[r].base;
+	rgnend = rgnbase + lmb_regions(rgn)[r].size - 1;
+
+	return rgnbase <= base && base + size - 1 <= rgnend;
+}
+
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+{
+	memmove(&lmb_regions(rgn)[r], &lmb_regions(rgn)[r + 1],
+		(rgn->cnt - r - 1) * sizeof(struct lmb_property));
 	rgn->cnt--;
 }
 
@@ -86,16 +107,58 @@ static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
 				 unsigned long r2)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
+	lmb_regions(rgn)[r1].size += lmb_regions(rgn)[r2].size;
 	lmb_remove_region(rgn, r2);
 }
 
+/* Number of regions which fit in the space @rgn has now */
+static unsigned long lmb_region_space(struct lmb_region *rgn)
+{
+	return rgn->grown ? rgn->max : LMB_INIT_REGIONS;
+}
+
+/* Double the space for regions, moving them to a new array */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max = lmb_region_space(rgn) * 2;
+
+	region = malloc(max * sizeof(struct lmb_property));
+	if (!region)
+		return -1;
+	memcpy(region, lmb_regions(rgn),
+	       rgn->cnt * sizeof(struct lmb_property));
+	free(rgn->grown);
+	rgn->grown = region;
+	rgn->max = max;
+
+	return 0;
+}
+
+static void lmb_init_region(struct lmb_region *rgn)
+{
+	rgn->cnt = 0;
+	rgn->max = 0;
+	rgn->size = 0;
+	rgn->grown = NULL;
+}
+
+static void lmb_uninit_region(struct lmb_region *rgn)
+{
+	free(rgn->grown);
+	lmb_init_region(rgn);
+}
+
 void lmb_init(struct lmb *lmb)
 {
-	lmb->memory.cnt = 0;
-	lmb->memory.size = 0;
-	lmb->reserved.cnt = 0;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+}
+
+void lmb_uninit(struct lmb *lmb)
+{
+	lmb_uninit_region(&lmb->memory);
+	lmb_uninit_region(&lmb->reserved);
 }
 
 static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
@@ -141,68 +204,49 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 /* This routine called with relocation disabled. */
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->cnt = 1;
+	struct lmb_property *prev = NULL, *next = NULL;
+	long i;
+
+	/* Find the neighbours of the new region */
+	i = lmb_find_below(rgn, base);
+	if (i >= 0)
+		prev = &lmb_regions(rgn)[i];
+	if (i + 1 < rgn->cnt)
+		next = &lmb_regions(rgn)[i + 1];
+
+	if (prev && prev->base == base && prev->size == size)
+		/* Already have this region, so we're done */
 		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
-			return -1;
-		}
-	}
-
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		lmb_coalesce_regions(rgn, i, i + 1);
-		coalesced++;
-	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
+	if ((prev && lmb_addrs_overlap(base, size, prev->base, prev->size)) ||
+	    (next && lmb_addrs_overlap(base, size, next->base, next->size)))
+		/* regions overlap */
 		return -1;
 
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			break;
+	/* First try and coalesce this LMB with its neighbours. */
+	if (prev && lmb_addrs_adjacent(base, size, prev->base, prev->size) < 0) {
+		prev->size += size;
+		if (next && lmb_addrs_adjacent(prev->base, prev->size,
+					       next->base, next->size) > 0) {
+			lmb_coalesce_regions(rgn, i, i + 1);
+			return 2;
 		}
+		return 1;
 	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
+	if (next && lmb_addrs_adjacent(base, size, next->base, next->size) > 0) {
+		next->base -= size;
+		next->size += size;
+		return 1;
 	}
 
+	/* Couldn't coalesce the LMB, so add it to the sorted table. */
+	if (rgn->cnt == lmb_region_space(rgn) && lmb_grow_region(rgn))
+		return -1;
+	i++;
+	memmove(&lmb_regions(rgn)[i + 1], &lmb_regions(rgn)[i],
+		(rgn->cnt - i) * sizeof(struct lmb_property));
+	lmb_regions(rgn)[i].base = base;
+	lmb_regions(rgn)[i].size = size;
 	rgn->cnt++;
 
 	return 0;
@@ -221,22 +265,14 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
-
-	/* Didn't find the region */
-	if (i == rgn->cnt)
+	i = lmb_find_below(rgn, base);
+	if (!lmb_region_contains(rgn, i, base, size))
 		return -1;
+	rgnbegin = lmb_regions(rgn)[i].base;
+	rgnend = rgnbegin + lmb_regions(rgn)[i].size - 1;
 
 	/* Check to see if we are removing entire region */
 	if ((rgnbegin == base) && (rgnend == end)) {
@@ -246,14 +282,14 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 
 	/* Check to see if region is matching at the front */
 	if (rgnbegin == base) {
-		rgn->region[i].base = end + 1;
-		rgn->region[i].size -= size;
+		lmb_regions(rgn)[i].base = end + 1;
+		lmb_regions(rgn)[i].size -= size;
 		return 0;
 	}
 
 	/* Check to see if the region is matching at the end */
 	if (rgnend == end) {
-		rgn->region[i].size -= size;
+		lmb_regions(rgn)[i].size -= size;
 		return 0;
 	}
 
@@ -261,7 +297,9 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * We need to split the entry -  adjust the current one to the
 	 * beginging of the hole and add the region after hole.
 	 */
-	rgn->region[i].size = base - rgn->region[i].base;
+	if (rgn->cnt == lmb_region_space(rgn) && lmb_grow_region(rgn))
+		return -1;
+	lmb_regions(rgn)[i].size = base - lmb_regions(rgn)[i].base;
 	return lmb_add_region(rgn, end + 1, rgnend - end);
 }
 
@@ -275,16 +313,15 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
+	long i;
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	/* Only the last region starting before the end can overlap */
+	i = lmb_find_below(rgn, base + size - 1);
+	if (i >= 0 && lmb_addrs_overlap(base, size, lmb_regions(rgn)[i].base,
+					lmb_regions(rgn)[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -312,40 +349,48 @@ static phys_addr_t lmb_align_down(phys_addr_t addr, phys_size_t size)
 
 phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
 {
+	struct lmb_property *res;
 	long i, rgn;
-	phys_addr_t base = 0;
-	phys_addr_t res_base;
+	phys_addr_t base;
+	phys_addr_t top;
 
+	if (!size)
+		return 0;
 	for (i = lmb->memory.cnt - 1; i >= 0; i--) {
-		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
+		phys_addr_t lmbbase = lmb_regions(&lmb->memory)[i].base;
+		phys_size_t lmbsize = lmb_regions(&lmb->memory)[i].size;
 
 		if (lmbsize < size)
 			continue;
-		if (max_addr == LMB_ALLOC_ANYWHERE)
-			base = lmb_align_down(lmbbase + lmbsize - size, align);
-		else if (lmbbase < max_addr) {
-			base = lmbbase + lmbsize;
-			if (base < lmbbase)
-				base = -1;
-			base = min(base, max_addr);
-			base = lmb_align_down(base - size, align);
-		} else
-			continue;
+		/* Work out the last byte that may be allocated */
+		top = lmbbase + lmbsize - 1;
+		if (max_addr != LMB_ALLOC_ANYWHERE) {
+			if (lmbbase >= max_addr)
+				continue;
+			top = min(top, max_addr - 1);
+		}
 
-		while (base && lmbbase <= base) {
-			rgn = lmb_overlaps_region(&lmb->reserved, base, size);
-			if (rgn < 0) {
+		/*
+		 * Walk down through the reserved regions below the top,
+		 * stopping at the first gap which is large enough
+		 */
+		rgn = lmb_find_below(&lmb->reserved, top);
+		while (top >= lmbbase && top - lmbbase >= size - 1) {
+			base = lmb_align_down(top - (size - 1), align);
+			if (!base || base < lmbbase)
+				break;
+			res = rgn >= 0 ? &lmb_regions(&lmb->reserved)[rgn] : NULL;
+			if (!res || res->base + res->size - 1 < base) {
 				/* This area isn't reserved, take it */
 				if (lmb_add_region(&lmb->reserved, base,
 						   size) < 0)
 					return 0;
 				return base;
 			}
-			res_base = lmb->reserved.region[rgn].base;
-			if (res_base < size)
+			if (!res->base)
 				break;
-			base = lmb_align_down(res_base - size, align);
+			top = res->base - 1;
+			rgn--;
 		}
 	}
 	return 0;
@@ -359,20 +404,12 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
 	long rgn;
 
-	/* Check if the requested address is in one of the memory regions */
-	rgn = lmb_overlaps_region(&lmb->memory, base, size);
-	if (rgn >= 0) {
-		/*
-		 * Check if the requested end address is in the same memory
-		 * region we found.
-		 */
-		if (lmb_addrs_overlap(lmb->memory.region[rgn].base,
-				      lmb->memory.region[rgn].size,
-				      base + size - 1, 1)) {
-			/* ok, reserve the memory */
-			if (lmb_reserve(lmb, base, size) >= 0)
-				return base;
-		}
+	/* Check if the requested range is within one of the memory regions */
+	rgn = lmb_find_below(&lmb->memory, base);
+	if (lmb_region_contains(&lmb->memory, rgn, base, size)) {
+		/* ok, reserve the memory */
+		if (lmb_reserve(lmb, base, size) >= 0)
+			return base;
 	}
 	return 0;
 }
@@ -380,41 +417,31 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-	long rgn;
+	struct lmb_region *res = &lmb->reserved;
+	long i;
 
 	/* check if the requested address is in the memory regions */
-	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
-	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
-			if (addr < lmb->reserved.region[i].base) {
-				/* first reserved range > requested address */
-				return lmb->reserved.region[i].base - addr;
-			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+	i = lmb_find_below(&lmb->memory, addr);
+	if (lmb_region_contains(&lmb->memory, i, addr, 1)) {
+		i = lmb_find_below(res, addr);
+		if (lmb_region_contains(res, i, addr, 1)) {
+			/* requested addr is in this reserved range */
+			return 0;
+		}
+		if (i + 1 < res->cnt) {
+			/* first reserved range > requested address */
+			return lmb_regions(res)[i + 1].base - addr;
 		}
 		/* if we come here: no reserved ranges above requested addr */
-		return lmb->memory.region[lmb->memory.cnt - 1].base +
-		       lmb->memory.region[lmb->memory.cnt - 1].size - addr;
+		return lmb_regions(&lmb->memory)[lmb->memory.cnt - 1].base +
+		       lmb_regions(&lmb->memory)[lmb->memory.cnt - 1].size - addr;
 	}
 	return 0;
 }
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
@@ -61,20 +61,24 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+int ulz4fn_stream(struct ulz4_stream *s, const void *src, size_t *srcn,
+		  void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
+	const void *in_end = src + *srcn;
 	const void *in = src;
 	void *out = dst;
-	int has_block_checksum;
-	int ret;
+	int ret = -EAGAIN;
+
+	*srcn = 0;
 	*dstn = 0;
 
-	{ /* With in-place decompression the header may become invalid later. */
+	if (!s->started) {
+		/* With in-place decompression the header may become invalid */
 		const struct lz4_frame_header *h = in;
 
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
+		if (in_end - in < sizeof(*h) + sizeof(u64) + sizeof(u8))
+			return -EAGAIN;	/* need more input */
 
 		/* We assume there's always only a single, standard frame. */
 		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
@@ -83,7 +87,8 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			return -EINVAL;	/* reserved must be zero */
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
+		s->has_block_checksum = h->has_block_checksum;
+		s->started = 1;
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -93,20 +98,26 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 
 	while (1) {
 		struct lz4_block_header b;
+		size_t bsize;
 
-		b.raw = le32_to_cpu(*(u32 *)in);
-		in += sizeof(struct lz4_block_header);
-
-		if (in - src + b.size > srcn) {
-			ret = -EINVAL;		/* input overrun */
-			break;
-		}
+		if (in_end - in < sizeof(struct lz4_block_header))
+			break;		/* need more input */
 
+		b.raw = le32_to_cpu(*(u32 *)in);
 		if (!b.size) {
+			in += sizeof(struct lz4_block_header);
 			ret = 0;	/* decompression successful */
 			break;
 		}
 
+		/* Only decompress whole blocks */
+		bsize = sizeof(struct lz4_block_header) + b.size;
+		if (s->has_block_checksum)
+			bsize += sizeof(u32);
+		if (in_end - in < bsize)
+			break;		/* need more input */
+		in += sizeof(struct lz4_block_header);
+
 		if (b.not_compressed) {
 			size_t size = min((ptrdiff_t)b.size, end - out);
 			memcpy(out, in, size);
@@ -125,13 +136,27 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 				break;
 			}
 			out += ret;
+			ret = -EAGAIN;
 		}
 
 		in += b.size;
-		if (has_block_checksum)
+		if (s->has_block_checksum)
 			in += sizeof(u32);
 	}
 
+	*srcn = in - src;
 	*dstn = out - dst;
 	return ret;
 }
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct ulz4_stream s = { 0 };
+	int ret;
+
+	ret = ulz4fn_stream(&s, src, &srcn, dst, dstn);
+	if (ret == -EAGAIN)
+		ret = -EINVAL;	/* input overrun */
+
+	return ret;
+}
@@ -15,6 +15,14 @@
 #include <dm/of_access.h>
 #include <linux/err.h>
 
+/* Statistics for the last tree built */
+static struct of_live_stats of_live_stats;
+
+#ifdef CONFIG_OF_LIVE_LAZY
+/* Flat tree from which the properties of the live tree are decoded */
+static const void *of_live_blob;
+#endif
+
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
 {
@@ -27,6 +35,71 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+#ifdef CONFIG_OF_LIVE_LAZY
+/* Get the phandle of a node, as the properties are not decoded yet */
+static phandle unflatten_dt_phandle(const void *blob, int offset)
+{
+	const fdt32_t *p;
+
+	p = fdt_getprop(blob, offset, "ibm,phandle", NULL);
+	if (!p)
+		p = fdt_getprop(blob, offset, "phandle", NULL);
+	if (!p)
+		p = fdt_getprop(blob, offset, "linux,phandle", NULL);
+
+	return p ? fdt32_to_cpu(*p) : 0;
+}
+
+struct property *of_live_decode_props(struct device_node *np)
+{
+	const void *blob = of_live_blob;
+	struct property *pp, **prev_pp;
+	bool has_name = false;
+	const char *pname;
+	int count = 0;
+	int offset, sz;
+	const void *p;
+
+	fdt_for_each_property_offset(offset, blob, np->offset) {
+		fdt_getprop_by_offset(blob, offset, &pname, NULL);
+		if (pname && !strcmp(pname, "name"))
+			has_name = true;
+		count++;
+	}
+	if (!has_name)
+		count++;
+
+	pp = malloc(count * sizeof(*pp));
+	if (!pp)
+		return NULL;
+	of_live_stats.lazy_size += count * sizeof(*pp);
+	of_live_stats.props += count;
+	of_live_stats.lazy_nodes--;
+
+	prev_pp = &np->properties;
+	fdt_for_each_property_offset(offset, blob, np->offset) {
+		p = fdt_getprop_by_offset(blob, offset, &pname, &sz);
+		pp->name = (char *)pname;
+		pp->length = sz;
+		pp->value = (void *)p;
+		*prev_pp = pp;
+		prev_pp = &pp->next;
+		pp++;
+	}
+	if (!has_name) {
+		pp->name = "name";
+		pp->length = strlen(np->name) + 1;
+		pp->value = (void *)np->name;
+		*prev_pp = pp;
+		prev_pp = &pp->next;
+	}
+	*prev_pp = NULL;
+	np->offset = -1;
+
+	return np->properties;
+}
+#endif
+
 /**
  * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -54,6 +127,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	int offset;
 	int has_name = 0;
 	int new_format = 0;
+	char *name;
 
 	pathp = fdt_get_name(blob, *poffset, &l);
 	if (!pathp)
@@ -121,8 +195,11 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			dad->child = np;
 		}
 	}
-	/* process properties */
-	for (offset = fdt_first_property_offset(blob, *poffset);
+	/* process properties, unless they are to be decoded on first use */
+	if (IS_ENABLED(CONFIG_OF_LIVE_LAZY))
+		has_name = fdt_getprop(blob, *poffset, "name", NULL) != NULL;
+	for (offset = IS_ENABLED(CONFIG_OF_LIVE_LAZY) ? -FDT_ERR_NOTFOUND :
+			fdt_first_property_offset(blob, *poffset);
 	     (offset >= 0);
 	     (offset = fdt_next_property_offset(blob, offset))) {
 		const char *pname;
@@ -165,6 +242,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			pp->value = (__be32 *)p;
 			*prev_pp = pp;
 			prev_pp = &pp->next;
+			of_live_stats.props++;
 		}
 	}
 	/*
@@ -185,29 +263,51 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		if (pa < ps)
 			pa = p1;
 		sz = (pa - ps) + 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
-					__alignof__(struct property));
-		if (!dryrun) {
-			pp->name = "name";
-			pp->length = sz;
-			pp->value = pp + 1;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
-			memcpy(pp->value, ps, sz - 1);
-			((char *)pp->value)[sz - 1] = 0;
-			debug("fixed up name for %s -> %s\n", pathp,
-			      (char *)pp->value);
+		if (IS_ENABLED(CONFIG_OF_LIVE_LAZY)) {
+			/* Only the name is needed until properties are used */
+			name = unflatten_dt_alloc(&mem, sz, 1);
+			if (!dryrun) {
+				memcpy(name, ps, sz - 1);
+				name[sz - 1] = 0;
+				np->name = name;
+			}
+		} else {
+			pp = unflatten_dt_alloc(&mem,
+						sizeof(struct property) + sz,
+						__alignof__(struct property));
+			if (!dryrun) {
+				pp->name = "name";
+				pp->length = sz;
+				pp->value = pp + 1;
+				*prev_pp = pp;
+				prev_pp = &pp->next;
+				memcpy(pp->value, ps, sz - 1);
+				((char *)pp->value)[sz - 1] = 0;
+				debug("fixed up name for %s -> %s\n", pathp,
+				      (char *)pp->value);
+				of_live_stats.props++;
+			}
 		}
 	}
 	if (!dryrun) {
 		*prev_pp = NULL;
+#ifdef CONFIG_OF_LIVE_LAZY
+		np->offset = *poffset;
+		if (has_name)
+			np->name = fdt_getprop(blob, *poffset, "name", NULL);
+		np->type = fdt_getprop(blob, *poffset, "device_type", NULL);
+		np->phandle = unflatten_dt_phandle(blob, *poffset);
+#else
 		np->name = of_get_property(np, "name", NULL);
 		np->type = of_get_property(np, "device_type", NULL);
+#endif
 
 		if (!np->name)
 			np->name = "<NULL>";
 		if (!np->type)
-			np->type = "<NULL>";	}
+			np->type = "<NULL>";
+		of_live_stats.nodes++;
+	}
 
 	old_depth = depth;
 	*poffset = fdt_next_node(blob, *poffset, &depth);
@@ -294,7 +394,10 @@ static int unflatten_device_tree(const void *blob,
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
+	of_live_stats.size = size + 4;
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
 
@@ -316,14 +419,22 @@ static int unflatten_device_tree(const void *blob,
 
 int of_live_build(const void *fdt_blob, struct device_node **rootp)
 {
+	ulong start = timer_get_us();
 	int ret;
 
 	debug("%s: start\n", __func__);
+	memset(&of_live_stats, '\0', sizeof(of_live_stats));
+#ifdef CONFIG_OF_LIVE_LAZY
+	of_live_blob = fdt_blob;
+#endif
 	ret = unflatten_device_tree(fdt_blob, rootp);
 	if (ret) {
 		debug("Failed to create live tree: err=%d\n", ret);
 		return ret;
 	}
+	if (IS_ENABLED(CONFIG_OF_LIVE_LAZY))
+		of_live_stats.lazy_nodes = of_live_stats.nodes;
+	of_live_stats.build_us = timer_get_us() - start;
 	ret = of_alias_scan();
 	if (ret) {
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
@@ -333,3 +444,8 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 
 	return ret;
 }
+
+const struct of_live_stats *of_live_get_stats(void)
+{
+	return &of_live_stats;
+}
@@ -55,12 +55,23 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
-static void sha256_process(sha256_context *ctx, const uint8_t data[64])
+void sha256_blocks_generic(uint32_t state[8], const uint8_t *data,
+			   unsigned int blocks)
 {
 	uint32_t temp1, temp2;
-	uint32_t W[64];
+	uint32_t W[16];
 	uint32_t A, B, C, D, E, F, G, H;
 
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
+	F = state[5];
+	G = state[6];
+	H = state[7];
+
+next_block:
 	GET_UINT32_BE(W[0], data, 0);
 	GET_UINT32_BE(W[1], data, 4);
 	GET_UINT32_BE(W[2], data, 8);
@@ -90,10 +101,14 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 #define F0(x,y,z) ((x & y) | (z & (x | y)))
 #define F1(x,y,z) (z ^ (x & (y ^ z)))
 
-#define R(t)					\
-(						\
-	W[t] = S1(W[t - 2]) + W[t - 7] +	\
-		S0(W[t - 15]) + W[t - 16]	\
+/*
+ * Only the last 16 words of the message schedule are needed, so keep them in
+ * a ring which the compiler can hold in registers or a single cache line
+ */
+#define R(t)						\
+(							\
+	W[(t) & 15] += S1(W[((t) - 2) & 15]) +		\
+		W[((t) - 7) & 15] + S0(W[((t) - 15) & 15])	\
 )
 
 #define P(a,b,c,d,e,f,g,h,x,K) {		\
@@ -102,15 +117,6 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	d += temp1; h = temp1 + temp2;		\
 }
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-	F = ctx->state[5];
-	G = ctx->state[6];
-	H = ctx->state[7];
-
 	P(A, B, C, D, E, F, G, H, W[0], 0x428A2F98);
 	P(H, A, B, C, D, E, F, G, W[1], 0x71374491);
 	P(G, H, A, B, C, D, E, F, W[2], 0xB5C0FBCF);
@@ -176,14 +182,29 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	P(C, D, E, F, G, H, A, B, R(62), 0xBEF9A3F7);
 	P(B, C, D, E, F, G, H, A, R(63), 0xC67178F2);
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-	ctx->state[5] += F;
-	ctx->state[6] += G;
-	ctx->state[7] += H;
+	A = state[0] += A;
+	B = state[1] += B;
+	C = state[2] += C;
+	D = state[3] += D;
+	E = state[4] += E;
+	F = state[5] += F;
+	G = state[6] += G;
+	H = state[7] += H;
+
+	data += 64;
+	if (--blocks)
+		goto next_block;
+}
+
+/* Hash whole 64-byte blocks, with the fastest implementation available */
+static void sha256_process(sha256_context *ctx, const uint8_t *data,
+			   unsigned int blocks)
+{
+#if defined(CONFIG_SHA256_ARCH) && !defined(USE_HOSTCC)
+	if (!sha256_blocks_arch(ctx->state, data, blocks))
+		return;
+#endif
+	sha256_blocks_generic(ctx->state, data, blocks);
 }
 
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
@@ -204,16 +225,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_process(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_process(ctx, input, length / 64);
+		input += length & ~0x3F;
+		length &= 0x3F;
 	}
 
 	if (length)
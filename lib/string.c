@@ -20,6 +20,7 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
 
 
 /**
@@ -481,6 +482,28 @@ char *strswab(const char *s)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(FAST_MEMFUNCS)
+/*
+ * The memset(), memcpy() and memcmp() below work on whole words once the
+ * destination is aligned, four words at a time where possible. Loads and
+ * stores are always aligned, so this is safe on any architecture.
+ */
+#define WORD_SIZE	sizeof(unsigned long)
+#define WORD_MASK	(WORD_SIZE - 1)
+/* Below this many bytes, aligning first costs more than it saves */
+#define WORD_MIN	(2 * WORD_SIZE)
+
+/*
+ * Combine two aligned words @w0 and @w1 into the word which starts @sh0 bits
+ * into @w0, @sh1 being the number of bits it takes from @w1
+ */
+#ifdef __LITTLE_ENDIAN
+#define WORD_MERGE(w0, sh0, w1, sh1)	(((w0) >> (sh0)) | ((w1) << (sh1)))
+#else
+#define WORD_MERGE(w0, sh0, w1, sh1)	(((w0) << (sh0)) | ((w1) >> (sh1)))
+#endif
+#endif
+
 #ifndef __HAVE_ARCH_MEMSET
 /**
  * memset - Fill a region of memory with the given value
@@ -490,6 +513,40 @@ char *strswab(const char *s)
  *
  * Do not use memset() to access IO space, use memset_io() instead.
  */
+#if CONFIG_IS_ENABLED(FAST_MEMFUNCS)
+void *memset(void *s, int c, size_t count)
+{
+	unsigned char *s8 = s;
+	unsigned long *sl;
+	unsigned long cl;
+
+	if (count >= WORD_MIN) {
+		while ((ulong)s8 & WORD_MASK) {
+			*s8++ = c;
+			count--;
+		}
+		cl = (c & 0xff) * (~0UL / 0xff);
+		sl = (unsigned long *)s8;
+		while (count >= 4 * WORD_SIZE) {
+			sl[0] = cl;
+			sl[1] = cl;
+			sl[2] = cl;
+			sl[3] = cl;
+			sl += 4;
+			count -= 4 * WORD_SIZE;
+		}
+		while (count >= WORD_SIZE) {
+			*sl++ = cl;
+			count -= WORD_SIZE;
+		}
+		s8 = (unsigned char *)sl;
+	}
+	while (count--)
+		*s8++ = c;
+
+	return s;
+}
+#else
 void * memset(void * s,int c,size_t count)
 {
 	unsigned long *sl = (unsigned long *) s;
@@ -518,6 +575,7 @@ void * memset(void * s,int c,size_t count)
 	return s;
 }
 #endif
+#endif
 
 #ifndef __HAVE_ARCH_MEMCPY
 /**
@@ -529,6 +587,71 @@ void * memset(void * s,int c,size_t count)
  * You should not use this function to access IO space, use memcpy_toio()
  * or memcpy_fromio() instead.
  */
+#if CONFIG_IS_ENABLED(FAST_MEMFUNCS)
+/*
+ * Copy whole words to an aligned @dl from a @src which is not aligned, by
+ * reading aligned words and shifting them into place. The last word read
+ * holds at least one source byte, so this never crosses into another page.
+ */
+static void memcpy_shift(unsigned long *dl, const unsigned char *src,
+			 size_t words)
+{
+	uint off = (ulong)src & WORD_MASK;
+	const unsigned long *sl = (const unsigned long *)(src - off);
+	uint sh0 = off * 8, sh1 = (WORD_SIZE - off) * 8;
+	unsigned long w0, w1;
+
+	w0 = *sl++;
+	while (words--) {
+		w1 = *sl++;
+		*dl++ = WORD_MERGE(w0, sh0, w1, sh1);
+		w0 = w1;
+	}
+}
+
+void *memcpy(void *dest, const void *src, size_t count)
+{
+	unsigned char *d8 = dest;
+	const unsigned char *s8 = src;
+	const unsigned long *sl;
+	unsigned long *dl;
+	size_t words;
+
+	if (src == dest)
+		return dest;
+
+	if (count >= WORD_MIN) {
+		while ((ulong)d8 & WORD_MASK) {
+			*d8++ = *s8++;
+			count--;
+		}
+		dl = (unsigned long *)d8;
+		sl = (const unsigned long *)s8;
+		words = count / WORD_SIZE;
+		d8 += words * WORD_SIZE;
+		s8 += words * WORD_SIZE;
+		count &= WORD_MASK;
+		if ((ulong)sl & WORD_MASK) {
+			memcpy_shift(dl, (const unsigned char *)sl, words);
+		} else {
+			for (; words >= 4; words -= 4) {
+				dl[0] = sl[0];
+				dl[1] = sl[1];
+				dl[2] = sl[2];
+				dl[3] = sl[3];
+				dl += 4;
+				sl += 4;
+			}
+			while (words--)
+				*dl++ = *sl++;
+		}
+	}
+	while (count--)
+		*d8++ = *s8++;
+
+	return dest;
+}
+#else
 void * memcpy(void *dest, const void *src, size_t count)
 {
 	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
@@ -553,6 +676,7 @@ void * memcpy(void *dest, const void *src, size_t count)
 	return dest;
 }
 #endif
+#endif
 
 #ifndef __HAVE_ARCH_MEMMOVE
 /**
@@ -587,6 +711,40 @@ void * memmove(void * dest,const void *src,size_t count)
  * @ct: Another area of memory
  * @count: The size of the area.
  */
+#if CONFIG_IS_ENABLED(FAST_MEMFUNCS)
+int memcmp(const void *cs, const void *ct, size_t count)
+{
+	const unsigned char *su1 = cs, *su2 = ct;
+	const unsigned long *sl1, *sl2;
+	int res;
+
+	/* Skip over equal words, leaving the bytes to say which is greater */
+	if (count >= WORD_MIN &&
+	    !(((ulong)su1 ^ (ulong)su2) & WORD_MASK)) {
+		for (; (ulong)su1 & WORD_MASK; su1++, su2++, count--) {
+			res = *su1 - *su2;
+			if (res)
+				return res;
+		}
+		sl1 = (const unsigned long *)su1;
+		sl2 = (const unsigned long *)su2;
+		while (count >= WORD_SIZE && *sl1 == *sl2) {
+			sl1++;
+			sl2++;
+			count -= WORD_SIZE;
+		}
+		su1 = (const unsigned char *)sl1;
+		su2 = (const unsigned char *)sl2;
+	}
+	for (; count; su1++, su2++, count--) {
+		res = *su1 - *su2;
+		if (res)
+			return res;
+	}
+
+	return 0;
+}
+#else
 int memcmp(const void * cs,const void * ct,size_t count)
 {
 	const unsigned char *su1, *su2;
@@ -598,6 +756,7 @@ int memcmp(const void * cs,const void * ct,size_t count)
 	return res;
 }
 #endif
+#endif
 
 #ifndef __HAVE_ARCH_MEMSCAN
 /**
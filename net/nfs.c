@@ -45,10 +45,27 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+#ifndef CONFIG_NET_MAXDEFRAG
+#define CONFIG_NET_MAXDEFRAG 16384
+#endif
+/*
+ * Space taken in an NFSv3 READ reply by everything but the data: UDP header,
+ * RPC reply header, status, attributes, count, eof and data length
+ */
+#define NFS3_READ_OVERHEAD	(8 + 24 + 4 + 88 + 12)
+#define NFS_HASH_BYTES		(NFS_READ_SIZE / 2 * 10)
+/* File size to use when the server does not tell us */
+#define NFS_SIZE_UNKNOWN	0xffffffff
+
+/* A READ request in flight, or a free slot if len is 0 */
+struct nfs_read_slot {
+	unsigned long id;
+	unsigned int offset;
+	unsigned int len;
+};
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
@@ -69,6 +86,7 @@ static int nfs_state;
 #define STATE_LOOKUP_REQ		5
 #define STATE_READ_REQ			6
 #define STATE_READLINK_REQ		7
+#define STATE_FSINFO_REQ		8
 
 static char *nfs_filename;
 static char *nfs_path;
@@ -78,6 +96,14 @@ static char nfs_path_buff[2048];
 #define NFSV3_FLAG 1 << 1
 static char supported_nfs_versions = NFSV2_FLAG | NFSV3_FLAG;
 
+static struct nfs_read_slot nfs_reads[CONFIG_NFS_READ_WINDOW];
+static int nfs_reads_pending;
+static unsigned int nfs_read_size;
+static unsigned int nfs_next_offset;	/* Next offset to ask for */
+static unsigned int nfs_file_size;
+static unsigned int nfs_received;	/* Bytes stored so far */
+static unsigned int nfs_hashes;
+
 static inline int store_block(uchar *src, unsigned offset, unsigned len)
 {
 	ulong newsize = offset + len;
@@ -170,7 +196,8 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static unsigned long rpc_req(int rpc_prog, int rpc_proc, uint32_t *data,
+			     int datalen)
 {
 	struct rpc_t rpc_pkt;
 	unsigned long id;
@@ -215,6 +242,8 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 
 	net_send_udp_packet(net_server_ethaddr, nfs_server_ip, sport,
 			    nfs_our_port, pktlen);
+
+	return id;
 }
 
 /**************************************************************************
@@ -356,7 +385,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static unsigned long nfs_read_req(int offset, int readlen)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -383,7 +412,95 @@ static void nfs_read_req(int offset, int readlen)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	return rpc_req(PROG_NFS, NFS_READ, data, len);
+}
+
+/**************************************************************************
+NFS3_FSINFO - Ask the server for its preferred transfer sizes
+**************************************************************************/
+static void nfs_fsinfo_req(void)
+{
+	uint32_t data[1024];
+	uint32_t *p;
+	int len;
+
+	p = &(data[0]);
+	p = rpc_add_credentials(p);
+
+	*p++ = htonl(filefh3_length);
+	memcpy(p, filefh, filefh3_length);
+	p += (filefh3_length / 4);
+
+	len = (uint32_t *)p - (uint32_t *)&(data[0]);
+
+	rpc_req(PROG_NFS, NFS3PROC_FSINFO, data, len);
+}
+
+/**************************************************************************
+READ pipeline - keep up to CONFIG_NFS_READ_WINDOW READ requests in flight.
+Replies are matched to requests by xid, so they may come in any order.
+**************************************************************************/
+static void nfs_read_send(struct nfs_read_slot *slot, unsigned int offset,
+			  unsigned int len)
+{
+	slot->offset = offset;
+	slot->len = len;
+	slot->id = nfs_read_req(offset, len);
+}
+
+/* Ask for more of the file, until the window is full */
+static void nfs_read_fill(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		struct nfs_read_slot *slot = &nfs_reads[i];
+		unsigned int len;
+
+		if (nfs_next_offset >= nfs_file_size)
+			break;
+		if (slot->len)
+			continue;
+		len = min(nfs_read_size, nfs_file_size - nfs_next_offset);
+		nfs_read_send(slot, nfs_next_offset, len);
+		nfs_next_offset += len;
+		nfs_reads_pending++;
+	}
+}
+
+/* Send all requests in flight again, with new xids */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		struct nfs_read_slot *slot = &nfs_reads[i];
+
+		if (slot->len)
+			nfs_read_send(slot, slot->offset, slot->len);
+	}
+}
+
+static void nfs_read_start(void)
+{
+	memset(nfs_reads, '\0', sizeof(nfs_reads));
+	nfs_reads_pending = 0;
+	nfs_next_offset = 0;
+	nfs_received = 0;
+	nfs_hashes = 0;
+	nfs_read_fill();
+}
+
+static struct nfs_read_slot *nfs_read_find(unsigned long id)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_reads[i].len && nfs_reads[i].id == id)
+			return &nfs_reads[i];
+	}
+
+	return NULL;
 }
 
 /**************************************************************************
@@ -416,7 +533,10 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
+		break;
+	case STATE_FSINFO_REQ:
+		nfs_fsinfo_req();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -567,12 +687,26 @@ static int nfs_lookup_reply(uchar *pkt, unsigned len)
 
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+		/* fattr: type, mode, nlink, uid, gid, size... */
+		nfs_file_size = ntohl(rpc_pkt.u.reply.data[1 + NFS_FHSIZE / 4 +
+							   5]);
 	} else {  /* NFSV3_FLAG */
+		uint32_t *attr;
+
 		filefh3_length = ntohl(rpc_pkt.u.reply.data[1]);
 		if (filefh3_length > NFS3_FHSIZE)
 			filefh3_length  = NFS3_FHSIZE;
 		memcpy(filefh, rpc_pkt.u.reply.data + 2, filefh3_length);
+
+		/* attributes_follow, then fattr3 with a 64-bit size */
+		attr = rpc_pkt.u.reply.data + 2 + filefh3_length / 4;
+		nfs_file_size = NFS_SIZE_UNKNOWN;
+		if (ntohl(attr[0]) && !attr[6])
+			nfs_file_size = ntohl(attr[7]);
 	}
+	/* Read until EOF if there is no size, which is also safe for 0 */
+	if (!nfs_file_size)
+		nfs_file_size = NFS_SIZE_UNKNOWN;
 
 	return 0;
 }
@@ -605,6 +739,39 @@ static int nfs3_get_attributes_offset(uint32_t *data)
 	}
 }
 
+static int nfs_fsinfo_reply(uchar *pkt, unsigned len)
+{
+	struct rpc_t rpc_pkt;
+	unsigned int rtmax, max_size;
+	int attr;
+
+	debug("%s\n", __func__);
+
+	memcpy(&rpc_pkt.u.data[0], pkt, len);
+
+	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
+		return -NFS_RPC_ERR;
+	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+		return -NFS_RPC_DROP;
+
+	if (rpc_pkt.u.reply.rstatus  ||
+	    rpc_pkt.u.reply.verifier ||
+	    rpc_pkt.u.reply.astatus  ||
+	    rpc_pkt.u.reply.data[0])
+		return -1;
+
+	/* Use the largest power of two that the server and defrag allow */
+	attr = nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
+	rtmax = ntohl(rpc_pkt.u.reply.data[1 + attr]);
+	max_size = min(rtmax, (unsigned int)(CONFIG_NET_MAXDEFRAG -
+					     IP_HDR_SIZE - NFS3_READ_OVERHEAD));
+	while (nfs_read_size * 2 <= max_size)
+		nfs_read_size *= 2;
+	debug("NFS rtmax %u, read size %u\n", rtmax, nfs_read_size);
+
+	return 0;
+}
+
 static int nfs_readlink_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
@@ -652,19 +819,32 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
+static void nfs_show_progress(void)
+{
+	while (nfs_hashes < nfs_received / NFS_HASH_BYTES) {
+		if (nfs_hashes && !(nfs_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_hashes++;
+	}
+}
+
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot;
+	unsigned int rlen;
 	uchar *data_ptr;
+	bool eof;
+	int ret;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	memcpy(&rpc_pkt.u.data[0], pkt, min_t(unsigned int, len,
+					      sizeof(rpc_pkt.u.reply)));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	slot = nfs_read_find(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -678,33 +858,54 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
 		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		eof = !rlen;
 	} else {  /* NFSV3_FLAG */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
 		/* Skip unused values :
-			EOF:		32 bits value,
 			data_size:	32 bits value,
 		*/
 		data_ptr = (uchar *)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
+	/* The data is taken from the packet, which may be bigger than rpc_t */
+	data_ptr = pkt + (data_ptr - rpc_pkt.u.data);
+	if (rlen > slot->len || data_ptr + rlen > pkt + len)
+		return -NFS_RPC_DROP;
+
+	/* An empty reply past the end must not move net_boot_file_size */
+	if (rlen) {
+		if (store_block(data_ptr, slot->offset, rlen))
 			return -9999;
+		nfs_received += rlen;
+		nfs_show_progress();
+	}
 
-	return rlen;
+	ret = rlen;
+	if (rlen < slot->len) {
+		if (eof) {
+			/* Nothing more to ask for past here */
+			if (slot->offset + rlen < nfs_file_size)
+				nfs_file_size = slot->offset + rlen;
+		} else {
+			/* The server sent less than asked for, get the rest */
+			nfs_read_send(slot, slot->offset + rlen,
+				      slot->len - rlen);
+			return ret;
+		}
+	}
+	slot->len = 0;
+	nfs_reads_pending--;
+
+	return ret;
 }
 
 /**************************************************************************
@@ -735,6 +936,10 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	if (dest != nfs_our_port)
 		return;
 
+	/* Only READ replies may be larger than struct rpc_t */
+	if (nfs_state != STATE_READ_REQ && len > sizeof(struct rpc_t))
+		return;
+
 	switch (nfs_state) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
 		if (rpc_lookup_reply(PROG_MOUNT, pkt, len) == -NFS_RPC_DROP)
@@ -795,13 +1000,28 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_state = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
 			nfs_send();
 		} else {
+			nfs_read_size = NFS_READ_SIZE;
+#ifdef CONFIG_IP_DEFRAG
+			/* Bigger reads need fragments, so ask the server */
+			if (!(supported_nfs_versions & NFSV2_FLAG)) {
+				nfs_state = STATE_FSINFO_REQ;
+				nfs_send();
+				break;
+			}
+#endif
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
+	case STATE_FSINFO_REQ:
+		/* Keep the default read size if this fails */
+		if (nfs_fsinfo_reply(pkt, len) == -NFS_RPC_DROP)
+			break;
+		nfs_state = STATE_READ_REQ;
+		nfs_read_start();
+		break;
+
 	case STATE_READLINK_REQ:
 		reply = nfs_readlink_reply(pkt, len);
 		if (reply == -NFS_RPC_DROP) {
@@ -825,15 +1045,15 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
+		if (rlen >= 0 && (nfs_reads_pending ||
+				  nfs_next_offset < nfs_file_size)) {
+			nfs_read_fill();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
+			if (rlen >= 0)
 				nfs_download_state = NETLOOP_SUCCESS;
 			if (rlen < 0)
 				debug("NFS READ error (%d)\n", rlen);
@@ -25,6 +25,7 @@
 #define NFS_READ        6
 
 #define NFS3PROC_LOOKUP 3
+#define NFS3PROC_FSINFO 19
 
 #define NFS_FHSIZE      32
 #define NFS3_FHSIZE     64
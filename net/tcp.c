@@ -0,0 +1,539 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Minimal TCP client
+ *
+ * This is built for downloads: U-Boot sends a short request and then takes
+ * in a large amount of data, such as a kernel image. Nothing is buffered
+ * here. Each segment is handed to the user with its offset in the stream as
+ * soon as it arrives, even when out of order, and only the ranges received
+ * are remembered. So the receive window can be large, advertised with the
+ * window scale option (RFC 7323), without costing any memory.
+ *
+ * SACK is not supported. When a segment is lost, every later segment is
+ * acknowledged at once with the same number, so the sender sees duplicate
+ * ACKs and does a fast retransmit (RFC 5681) instead of waiting for its
+ * timeout. Our own data is sent one segment at a time and is retransmitted
+ * the same way after three duplicate ACKs, or on timeout.
+ */
+
+#include <common.h>
+#include <net.h>
+#include <net/tcp.h>
+
+/* Initial retransmit timeout in ms, doubled on each retry up to the max */
+#define TCP_RTO		1000
+#define TCP_RTO_MAX	16000
+/* # of timeouts in a row before giving up */
+#define TCP_RETRIES	8
+/* # of duplicate ACKs which trigger a fast retransmit */
+#define TCP_DUP_ACKS	3
+/* # of out-of-order ranges we can remember */
+#define TCP_RANGES	8
+/* MSS to assume if the remote does not send one (RFC 1122) */
+#define TCP_DEFAULT_MSS	536
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+	TCP_CLOSE_WAIT,		/* The remote has closed, we have not */
+};
+
+/* Sequence numbers [start, end) received ahead of tcp_rcv_nxt */
+struct tcp_range {
+	u32 start;
+	u32 end;
+};
+
+static enum tcp_state tcp_state;
+static struct in_addr tcp_remote_ip;
+static uchar tcp_remote_ethaddr[ARP_HLEN];
+static int tcp_remote_port;
+static int tcp_local_port;
+static tcp_rx_handler *tcp_rx;
+static tcp_event_handler *tcp_event;
+
+/* Send side: first unacknowledged and next sequence numbers, and the data */
+static u32 tcp_snd_una;
+static u32 tcp_snd_nxt;
+static uchar tcp_snd_buf[TCP_MSS];
+static unsigned int tcp_snd_len;
+static unsigned int tcp_snd_mss;
+static int tcp_dup_acks;
+
+/* Receive side: initial and next sequence numbers, and what came early */
+static u32 tcp_rcv_isn;
+static u32 tcp_rcv_nxt;
+static struct tcp_range tcp_ranges[TCP_RANGES];
+static int tcp_range_count;
+static bool tcp_fin_pending;
+static u32 tcp_fin_seq;
+/* Shift applied to the window we advertise, 0 if the remote cannot scale */
+static int tcp_rcv_wscale;
+
+static int tcp_retries;
+static ulong tcp_rto;
+
+static inline bool tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline bool tcp_seq_after(u32 a, u32 b)
+{
+	return (s32)(a - b) > 0;
+}
+
+/* Smallest shift which fits our receive window into 16 bits */
+static int tcp_wscale(void)
+{
+	int shift = 0;
+
+	while (shift < 14 && (CONFIG_TCP_RX_WINDOW >> shift) > 0xffff)
+		shift++;
+
+	return shift;
+}
+
+/*
+ * Checksum over the pseudo header and TCP segment. This gives 0 for a
+ * segment with a correct checksum.
+ */
+static unsigned int tcp_checksum(struct ip_tcp_hdr *ip, int tcp_len)
+{
+	__be32 pseudo[3];
+
+	pseudo[0] = ip->ip_src.s_addr;
+	pseudo[1] = ip->ip_dst.s_addr;
+	pseudo[2] = htonl(IPPROTO_TCP << 16 | tcp_len);
+
+	return add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&ip->tcp_src, tcp_len));
+}
+
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num)
+{
+	struct ip_tcp_hdr *ip = (struct ip_tcp_hdr *)pkt;
+	int hdr_len = IP_TCP_HDR_SIZE;
+	ulong win;
+
+	if (action & TCP_SYN) {
+		uchar *opt = pkt + IP_TCP_HDR_SIZE;
+
+		opt[0] = TCP_O_MSS;
+		opt[1] = 4;
+		opt[2] = TCP_MSS >> 8;
+		opt[3] = TCP_MSS & 0xff;
+		opt[4] = TCP_O_NOP;
+		opt[5] = TCP_O_WS;
+		opt[6] = 3;
+		opt[7] = tcp_wscale();
+		hdr_len += TCP_SYN_OPT_SIZE;
+
+		/* The window in a SYN is never scaled */
+		win = min_t(ulong, CONFIG_TCP_RX_WINDOW, 0xffff);
+	} else {
+		win = min_t(ulong, CONFIG_TCP_RX_WINDOW >> tcp_rcv_wscale,
+			    0xffff);
+	}
+
+	net_set_ip_header(pkt, dest, net_ip, hdr_len + payload_len,
+			  IPPROTO_TCP);
+
+	ip->tcp_src = htons(sport);
+	ip->tcp_dst = htons(dport);
+	ip->tcp_seq = htonl(tcp_seq_num);
+	ip->tcp_ack = htonl(action & TCP_ACK ? tcp_ack_num : 0);
+	ip->tcp_hlen = (hdr_len - IP_HDR_SIZE) << 2;
+	ip->tcp_flags = action;
+	ip->tcp_win = htons(win);
+	ip->tcp_xsum = 0;
+	ip->tcp_ugr = 0;
+	ip->tcp_xsum = tcp_checksum(ip, hdr_len - IP_HDR_SIZE + payload_len);
+
+	return hdr_len;
+}
+
+static void tcp_send_segment(u8 action, u32 seq, const void *data,
+			     unsigned int len)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_TCP_HDR_SIZE;
+
+	if (len)
+		memcpy(pkt, data, len);
+	net_send_ip_packet(tcp_remote_ethaddr, tcp_remote_ip, tcp_remote_port,
+			   tcp_local_port, len, IPPROTO_TCP, action, seq,
+			   tcp_rcv_nxt);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_send_segment(TCP_ACK, tcp_snd_nxt, NULL, 0);
+}
+
+/* Send whatever the remote has not acknowledged yet */
+static void tcp_retransmit(void)
+{
+	if (tcp_state == TCP_SYN_SENT)
+		tcp_send_segment(TCP_SYN, tcp_snd_una, NULL, 0);
+	else if (tcp_snd_len)
+		tcp_send_segment(TCP_ACK | TCP_PUSH, tcp_snd_una, tcp_snd_buf,
+				 tcp_snd_len);
+	else
+		tcp_send_ack();
+}
+
+static void tcp_timeout_handler(void);
+
+/* Restart the retransmit timer, after progress has been made */
+static void tcp_restart_timer(void)
+{
+	tcp_retries = 0;
+	tcp_rto = TCP_RTO;
+	net_set_timeout_handler(tcp_rto, tcp_timeout_handler);
+}
+
+/* Drop the connection without telling the remote, and tell the user */
+static void tcp_fail(const char *why)
+{
+	printf("\nTCP: %s\n", why);
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	tcp_event(TCP_EVENT_RESET);
+}
+
+static void tcp_timeout_handler(void)
+{
+	if (++tcp_retries > TCP_RETRIES) {
+		tcp_fail("connection timed out");
+		return;
+	}
+	puts("T ");
+	tcp_rto = min(tcp_rto * 2, (ulong)TCP_RTO_MAX);
+	net_set_timeout_handler(tcp_rto, tcp_timeout_handler);
+	tcp_retransmit();
+}
+
+int tcp_connect(struct in_addr dest, int dport, tcp_rx_handler *rx,
+		tcp_event_handler *event)
+{
+	u32 isn;
+
+	/* Any earlier connection is forgotten, e.g. after Ctrl-C */
+	tcp_remote_ip = dest;
+	tcp_remote_port = dport;
+	tcp_local_port = random_port();
+	memset(tcp_remote_ethaddr, '\0', ARP_HLEN);
+	tcp_rx = rx;
+	tcp_event = event;
+
+	isn = (u32)get_ticks() ^ (tcp_local_port << 16);
+	tcp_snd_una = isn;
+	tcp_snd_nxt = isn + 1;
+	tcp_snd_len = 0;
+	tcp_snd_mss = TCP_DEFAULT_MSS;
+	tcp_dup_acks = 0;
+	tcp_rcv_nxt = 0;
+	tcp_range_count = 0;
+	tcp_fin_pending = false;
+	tcp_rcv_wscale = 0;
+
+	debug("TCP: connecting to %pI4:%d from port %d\n", &dest, dport,
+	      tcp_local_port);
+	tcp_state = TCP_SYN_SENT;
+	tcp_restart_timer();
+	tcp_send_segment(TCP_SYN, isn, NULL, 0);
+
+	return 0;
+}
+
+int tcp_send(const void *data, unsigned int len)
+{
+	if (tcp_state != TCP_ESTABLISHED)
+		return -ENOTCONN;
+	if (tcp_snd_len)
+		return -EBUSY;
+	if (len > tcp_snd_mss)
+		return -E2BIG;
+
+	memcpy(tcp_snd_buf, data, len);
+	tcp_snd_len = len;
+	tcp_snd_nxt = tcp_snd_una + len;
+	tcp_dup_acks = 0;
+	tcp_restart_timer();
+	tcp_send_segment(TCP_ACK | TCP_PUSH, tcp_snd_una, tcp_snd_buf, len);
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	/* We cannot take more data once closed, so abort unless it is all in */
+	if (tcp_state == TCP_CLOSE_WAIT)
+		tcp_send_segment(TCP_FIN | TCP_ACK, tcp_snd_nxt, NULL, 0);
+	else if (tcp_state != TCP_CLOSED)
+		tcp_send_segment(TCP_RST | TCP_ACK, tcp_snd_nxt, NULL, 0);
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+}
+
+/* Pick up the MSS and window scale options from a SYN */
+static void tcp_parse_options(const uchar *opt, int len, bool *wscale)
+{
+	int i = 0;
+
+	*wscale = false;
+	while (i < len && opt[i] != TCP_O_END) {
+		int olen;
+
+		if (opt[i] == TCP_O_NOP) {
+			i++;
+			continue;
+		}
+		if (i + 1 >= len)
+			break;
+		olen = opt[i + 1];
+		if (olen < 2 || i + olen > len)
+			break;
+		if (opt[i] == TCP_O_MSS && olen == 4)
+			tcp_snd_mss = min_t(unsigned int,
+					    opt[i + 2] << 8 | opt[i + 3],
+					    TCP_MSS);
+		else if (opt[i] == TCP_O_WS && olen == 3)
+			*wscale = true;
+		i += olen;
+	}
+}
+
+static void tcp_rx_syn_ack(struct ip_tcp_hdr *ip, int hlen, u32 seq, u32 ack)
+{
+	bool wscale;
+
+	if ((ip->tcp_flags & (TCP_SYN | TCP_ACK)) != (TCP_SYN | TCP_ACK) ||
+	    ack != tcp_snd_nxt)
+		return;
+
+	tcp_parse_options((uchar *)ip + IP_TCP_HDR_SIZE,
+			  hlen - TCP_HDR_SIZE, &wscale);
+	/* Scaling only applies if both sides ask for it */
+	tcp_rcv_wscale = wscale ? tcp_wscale() : 0;
+	tcp_rcv_isn = seq;
+	tcp_rcv_nxt = seq + 1;
+	tcp_snd_una = ack;
+	tcp_state = TCP_ESTABLISHED;
+	debug("TCP: connected, mss %u, window shift %d\n", tcp_snd_mss,
+	      tcp_rcv_wscale);
+
+	tcp_restart_timer();
+	tcp_send_ack();
+	tcp_event(TCP_EVENT_CONNECTED);
+}
+
+/* Handle the ACK number, which tells us how much of our data has arrived */
+static void tcp_rx_ack(u32 ack, int len, u8 flags)
+{
+	if (tcp_snd_una == tcp_snd_nxt)
+		return;
+
+	if (tcp_seq_after(ack, tcp_snd_una) &&
+	    !tcp_seq_after(ack, tcp_snd_nxt)) {
+		unsigned int acked = ack - tcp_snd_una;
+
+		tcp_snd_len -= acked;
+		memmove(tcp_snd_buf, tcp_snd_buf + acked, tcp_snd_len);
+		tcp_snd_una = ack;
+		tcp_dup_acks = 0;
+		tcp_restart_timer();
+	} else if (ack == tcp_snd_una && !len && !(flags & TCP_FIN)) {
+		if (++tcp_dup_acks == TCP_DUP_ACKS)
+			tcp_retransmit();
+	}
+}
+
+/* Check whether [start, end) can be remembered as an out-of-order range */
+static bool tcp_range_fits(u32 start, u32 end)
+{
+	int i;
+
+	if (tcp_range_count < TCP_RANGES)
+		return true;
+	for (i = 0; i < tcp_range_count; i++) {
+		if (!tcp_seq_before(end, tcp_ranges[i].start) &&
+		    !tcp_seq_after(start, tcp_ranges[i].end))
+			return true;
+	}
+
+	return false;
+}
+
+static void tcp_range_add(u32 start, u32 end)
+{
+	int i = 0;
+
+	/* Merge with any ranges that overlap or touch this one */
+	while (i < tcp_range_count) {
+		struct tcp_range *range = &tcp_ranges[i];
+
+		if (tcp_seq_before(end, range->start) ||
+		    tcp_seq_after(start, range->end)) {
+			i++;
+			continue;
+		}
+		if (tcp_seq_before(range->start, start))
+			start = range->start;
+		if (tcp_seq_after(range->end, end))
+			end = range->end;
+		*range = tcp_ranges[--tcp_range_count];
+	}
+	tcp_ranges[tcp_range_count].start = start;
+	tcp_ranges[tcp_range_count].end = end;
+	tcp_range_count++;
+}
+
+/* Move tcp_rcv_nxt past any ranges which are now contiguous with it */
+static void tcp_range_pull(void)
+{
+	int i = 0;
+
+	while (i < tcp_range_count) {
+		struct tcp_range *range = &tcp_ranges[i];
+
+		if (tcp_seq_after(range->start, tcp_rcv_nxt)) {
+			i++;
+			continue;
+		}
+		if (tcp_seq_after(range->end, tcp_rcv_nxt))
+			tcp_rcv_nxt = range->end;
+		*range = tcp_ranges[--tcp_range_count];
+		i = 0;
+	}
+}
+
+/* Pass data on to the user and work out what to acknowledge */
+static void tcp_rx_data(u32 seq, const uchar *data, int len, bool fin)
+{
+	s32 dist = seq - tcp_rcv_nxt;
+	int ret;
+
+	if (!len && !fin)
+		return;
+
+	/* Drop anything we already have */
+	if (dist < 0) {
+		if (-dist > len || (-dist == len && !fin)) {
+			tcp_send_ack();
+			return;
+		}
+		data -= dist;
+		len += dist;
+		seq = tcp_rcv_nxt;
+		dist = 0;
+	}
+
+	/* ...and anything beyond the window */
+	if (dist + len > CONFIG_TCP_RX_WINDOW) {
+		len = CONFIG_TCP_RX_WINDOW - dist;
+		fin = false;
+		if (len <= 0) {
+			tcp_send_ack();
+			return;
+		}
+	}
+
+	if (len && (dist == 0 || tcp_range_fits(seq, seq + len))) {
+		ret = tcp_rx(seq - tcp_rcv_isn - 1, data, len);
+		if (ret && ret != -EAGAIN) {
+			debug("TCP: aborted by user, err=%d\n", ret);
+			tcp_close();
+			return;
+		}
+		if (!ret) {
+			if (dist)
+				tcp_range_add(seq, seq + len);
+			else
+				tcp_rcv_nxt += len;
+			tcp_range_pull();
+		} else {
+			fin = false;
+		}
+	}
+	if (fin) {
+		tcp_fin_pending = true;
+		tcp_fin_seq = seq + len;
+	}
+
+	/*
+	 * Always acknowledge at once: if something is missing, this tells
+	 * the remote what to send again
+	 */
+	if (tcp_fin_pending && tcp_fin_seq == tcp_rcv_nxt) {
+		tcp_rcv_nxt++;
+		tcp_state = TCP_CLOSE_WAIT;
+		net_set_timeout_handler(0, NULL);
+		tcp_send_ack();
+		tcp_event(TCP_EVENT_CLOSED);
+		return;
+	}
+	if (len)
+		tcp_restart_timer();
+	tcp_send_ack();
+}
+
+void tcp_receive(struct ip_tcp_hdr *ip, int len)
+{
+	u32 seq, ack;
+	int hlen;
+	u8 flags;
+
+	if (len < IP_TCP_HDR_SIZE)
+		return;
+	hlen = (ip->tcp_hlen >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || IP_HDR_SIZE + hlen > len)
+		return;
+	if (tcp_checksum(ip, len - IP_HDR_SIZE)) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+	if (tcp_state == TCP_CLOSED ||
+	    net_read_ip(&ip->ip_src).s_addr != tcp_remote_ip.s_addr ||
+	    ntohs(ip->tcp_src) != tcp_remote_port ||
+	    ntohs(ip->tcp_dst) != tcp_local_port)
+		return;
+
+	flags = ip->tcp_flags;
+	seq = ntohl(ip->tcp_seq);
+	ack = ntohl(ip->tcp_ack);
+	len -= IP_HDR_SIZE + hlen;
+	debug_cond(DEBUG_DEV_PKT, "TCP: flags %02x seq %u ack %u len %d\n",
+		   flags, seq - tcp_rcv_isn, ack - tcp_snd_una, len);
+
+	if (flags & TCP_RST) {
+		if (tcp_state == TCP_SYN_SENT) {
+			if (flags & TCP_ACK && ack == tcp_snd_nxt)
+				tcp_fail("connection refused");
+		} else if (seq == tcp_rcv_nxt) {
+			tcp_fail("connection reset");
+		}
+		return;
+	}
+
+	if (tcp_state == TCP_SYN_SENT) {
+		tcp_rx_syn_ack(ip, hlen, seq, ack);
+		return;
+	}
+	if (!(flags & TCP_ACK))
+		return;
+
+	tcp_rx_ack(ack, len, flags);
+	if (tcp_state == TCP_CLOSE_WAIT) {
+		/* Our ACK of the FIN may have been lost */
+		if (len || flags & TCP_FIN)
+			tcp_send_ack();
+		return;
+	}
+	tcp_rx_data(seq, (uchar *)ip + IP_HDR_SIZE + hlen, len,
+		    flags & TCP_FIN);
+}
@@ -78,6 +78,10 @@ static int	timeout_count;
 static ulong	tftp_cur_block;
 /* last packet sequence number received */
 static ulong	tftp_prev_block;
+/* blocks received in order since we last sent an ACK */
+static int	tftp_window_count;
+/* tftp_prev_block when we last ACKed because of a gap, to only ACK once */
+static ulong	tftp_gap_ack_block;
 /* count of sequence number wraparounds */
 static ulong	tftp_block_wrap;
 /* memory offset due to wrapping */
@@ -140,6 +144,13 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * Number of blocks the server may send before waiting for an ACK (RFC 7440).
+ * Only requested for reads, and only if more than one.
+ */
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = CONFIG_TFTP_WINDOWSIZE;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -192,6 +203,8 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 static void new_transfer(void)
 {
 	tftp_prev_block = 0;
+	tftp_window_count = 0;
+	tftp_gap_ack_block = -1;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
 #ifdef CONFIG_CMD_TFTPPUT
@@ -346,6 +359,9 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -358,6 +374,8 @@ static void tftp_send(void)
 		s[0] = htons(TFTP_ACK);
 		s[1] = htons(tftp_cur_block);
 		pkt = (uchar *)(s + 2);
+		/* The server starts a new window after each ACK */
+		tftp_window_count = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
 			int toload = tftp_block_size;
@@ -399,6 +417,34 @@ static void tftp_send(void)
 			    tftp_remote_port, tftp_our_port, len);
 }
 
+/*
+ * With a window of more than one block, check that a data block is the next
+ * one expected. If one has been lost, ACK the last block received in order so
+ * that the server sends again from there (RFC 7440 section 3). Only do this
+ * once for each gap, since the rest of the window arrives out of order too.
+ * Blocks from before the expected one are duplicates.
+ *
+ * @param block	Block number received
+ * @return true if the block should be ignored
+ */
+static bool tftp_window_skip(ushort block)
+{
+	ushort expected = tftp_prev_block + 1;
+
+	if (tftp_window_size == 1 || block == expected)
+		return false;
+
+	if ((ushort)(block - expected) < TFTP_SEQUENCE_SIZE / 2 &&
+	    tftp_gap_ack_block != tftp_prev_block) {
+		debug("TFTP block %d lost, got %d\n", expected, block);
+		tftp_gap_ack_block = tftp_prev_block;
+		tftp_cur_block = tftp_prev_block;
+		tftp_send();
+	}
+
+	return true;
+}
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 struct in_addr sip, unsigned src, uchar *pkt,
@@ -490,6 +536,15 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_window_size)
+					tftp_window_size = 1;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -512,6 +567,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
+		if (tftp_state == STATE_DATA &&
+		    tftp_window_skip(ntohs(*(__be16 *)pkt)))
+			break;
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
 		update_block_number();
@@ -552,10 +610,13 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 
 		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	Acknowledge the last block of each window, which will
+		 *	prompt the remote for the next window, and the final
+		 *	block.
 		 */
-		tftp_send();
+		if (++tftp_window_count >= tftp_window_size ||
+		    len < tftp_block_size)
+			tftp_send();
 
 		if (len < tftp_block_size)
 			tftp_complete();
@@ -609,6 +670,7 @@ static int tftp_init_load_addr(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -632,6 +694,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -653,8 +719,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %d, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -755,6 +821,7 @@ void tftp_start(enum proto_t protocol)
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -787,6 +854,7 @@ void tftp_start_server(void)
 
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * wget - download a file over HTTP
+ *
+ * An HTTP/1.0 GET is sent, so the server closes the connection once the
+ * whole file is sent and never uses chunked encoding. The body is written
+ * straight to the load address as each TCP segment arrives.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <environment.h>
+#include <lmb.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include "wget.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Space for the status line and headers of the response */
+#define WGET_HDR_MAX		2048
+/* Space for the request, which must fit in one TCP segment */
+#define WGET_REQ_MAX		512
+/* Bytes per hash mark printed */
+#define WGET_HASH_BYTES		(64 << 10)
+#define HASHES_PER_LINE		65
+
+static struct in_addr wget_server_ip;
+static int wget_server_port;
+static char wget_path[256];
+static ulong wget_load_addr;
+static ulong wget_load_size;
+static ulong wget_time_start;
+
+static char wget_hdr[WGET_HDR_MAX];
+static unsigned int wget_hdr_len;
+static bool wget_have_headers;
+/* Offset of the body in the TCP stream */
+static u32 wget_body_start;
+/* Size given by the server, or -1 if none */
+static long wget_content_len;
+static unsigned int wget_hashes;
+
+static void wget_fail(const char *msg)
+{
+	printf("\nwget error: %s\n", msg);
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_show_progress(void)
+{
+	while (wget_hashes < net_boot_file_size / WGET_HASH_BYTES) {
+		putc('#');
+		if (!(++wget_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+	}
+}
+
+static int wget_store(u32 offset, const uchar *data, unsigned int len)
+{
+	ulong store_addr = wget_load_addr + offset;
+	void *ptr;
+
+	/* Ignore anything past the size the server gave us */
+	if (wget_content_len >= 0) {
+		if (offset >= (ulong)wget_content_len)
+			return 0;
+		len = min_t(ulong, len, wget_content_len - offset);
+	}
+
+#ifdef CONFIG_LMB
+	if (store_addr + len > wget_load_addr + wget_load_size) {
+		wget_fail("trying to overwrite reserved memory...");
+		return -ENOSPC;
+	}
+#endif
+	ptr = map_sysmem(store_addr, len);
+	memcpy(ptr, data, len);
+	unmap_sysmem(ptr);
+
+	if (net_boot_file_size < offset + len)
+		net_boot_file_size = offset + len;
+	wget_show_progress();
+
+	return 0;
+}
+
+/* Check the status line and pick out the headers we care about */
+static int wget_parse_headers(void)
+{
+	char *line, *end;
+
+	if (strncmp(wget_hdr, "HTTP/", 5))
+		goto bad;
+	line = strchr(wget_hdr, ' ');
+	if (!line)
+		goto bad;
+	if (simple_strtoul(line + 1, NULL, 10) != 200) {
+		end = strstr(wget_hdr, "\r\n");
+		*end = '\0';
+		printf("\nwget error: server replied '%s'\n", wget_hdr);
+		net_set_state(NETLOOP_FAIL);
+		return -ENOENT;
+	}
+
+	wget_content_len = -1;
+	line = wget_hdr;
+	while ((line = strstr(line, "\r\n"))) {
+		line += 2;
+		if (!strncasecmp(line, "Content-Length:", 15)) {
+			char *val = line + 15;
+
+			/* simple_strtoul() does not skip white space */
+			while (*val == ' ' || *val == '\t')
+				val++;
+			wget_content_len = simple_strtoul(val, NULL, 10);
+		} else if (!strncasecmp(line, "Transfer-Encoding:", 18)) {
+			wget_fail("transfer encoding not supported");
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+bad:
+	wget_fail("bad HTTP response");
+	return -EINVAL;
+}
+
+/* Collect the headers, which must be taken in order */
+static int wget_rx_headers(u32 offset, const uchar *data, unsigned int len)
+{
+	unsigned int skip, count;
+	char *end;
+	u32 pos;
+
+	if (offset > wget_hdr_len)
+		return -EAGAIN;
+	skip = wget_hdr_len - offset;
+	if (skip >= len)
+		return 0;
+	data += skip;
+	len -= skip;
+
+	count = min(len, WGET_HDR_MAX - 1 - wget_hdr_len);
+	memcpy(wget_hdr + wget_hdr_len, data, count);
+	pos = wget_hdr_len;
+	wget_hdr_len += count;
+	wget_hdr[wget_hdr_len] = '\0';
+
+	/* The end marker may straddle two segments, so search the lot */
+	end = strstr(wget_hdr, "\r\n\r\n");
+	if (!end) {
+		if (wget_hdr_len == WGET_HDR_MAX - 1) {
+			wget_fail("HTTP headers too long");
+			return -E2BIG;
+		}
+		return 0;
+	}
+	end[2] = '\0';
+	wget_body_start = end + 4 - wget_hdr;
+	wget_have_headers = true;
+	if (wget_parse_headers())
+		return -EINVAL;
+
+	/* Store the start of the body, if it came with the headers */
+	if (pos + len > wget_body_start)
+		return wget_store(0, data + wget_body_start - pos,
+				  pos + len - wget_body_start);
+
+	return 0;
+}
+
+static int wget_rx(u32 offset, const uchar *data, unsigned int len)
+{
+	if (!wget_have_headers)
+		return wget_rx_headers(offset, data, len);
+
+	if (offset < wget_body_start) {
+		unsigned int skip = wget_body_start - offset;
+
+		if (skip >= len)
+			return 0;
+		data += skip;
+		len -= skip;
+		offset = wget_body_start;
+	}
+
+	return wget_store(offset - wget_body_start, data, len);
+}
+
+static void wget_send_request(void)
+{
+	char req[WGET_REQ_MAX];
+	int len, ret;
+
+	len = snprintf(req, sizeof(req),
+		       "GET %s%s HTTP/1.0\r\n"
+		       "Host: %pI4\r\n"
+		       "User-Agent: U-Boot\r\n"
+		       "\r\n",
+		       *wget_path == '/' ? "" : "/", wget_path,
+		       &wget_server_ip);
+	if (len >= sizeof(req)) {
+		tcp_close();
+		wget_fail("path too long");
+		return;
+	}
+	ret = tcp_send(req, len);
+	if (ret) {
+		tcp_close();
+		printf("\nwget error: cannot send request (err=%d)\n", ret);
+		net_set_state(NETLOOP_FAIL);
+	}
+}
+
+static void wget_complete(void)
+{
+	ulong time;
+
+	time = get_timer(wget_time_start);
+	if (time > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static void wget_event(enum tcp_event event)
+{
+	switch (event) {
+	case TCP_EVENT_CONNECTED:
+		wget_send_request();
+		break;
+	case TCP_EVENT_CLOSED:
+		tcp_close();
+		if (!wget_have_headers)
+			wget_fail("no HTTP response");
+		else if (wget_content_len >= 0 &&
+			 net_boot_file_size != (ulong)wget_content_len)
+			wget_fail("connection closed before end of file");
+		else
+			wget_complete();
+		break;
+	case TCP_EVENT_RESET:
+		net_set_state(NETLOOP_FAIL);
+		break;
+	}
+}
+
+/* Initialize wget_load_addr and wget_load_size from load_addr and lmb */
+static int wget_init_load_addr(void)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	phys_size_t max_size;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	max_size = lmb_get_free_size(&lmb, load_addr);
+	lmb_uninit(&lmb);
+	if (!max_size)
+		return -1;
+
+	wget_load_size = max_size;
+#endif
+	wget_load_addr = load_addr;
+	return 0;
+}
+
+void wget_start(void)
+{
+	char *ep;
+
+	wget_server_ip = net_server_ip;
+	if (!net_parse_bootfile(&wget_server_ip, wget_path,
+				sizeof(wget_path))) {
+		wget_fail("no file name given");
+		return;
+	}
+
+	wget_server_port = WGET_DEFAULT_PORT;
+	ep = env_get("httpdstp");
+	if (ep)
+		wget_server_port = simple_strtol(ep, NULL, 10);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4:%d; our IP address is %pI4\n",
+	       &wget_server_ip, wget_server_port, &net_ip);
+	printf("Filename '%s'.\n", wget_path);
+
+	if (wget_init_load_addr()) {
+		wget_fail("trying to overwrite reserved memory...");
+		return;
+	}
+	printf("Load address: 0x%lx\n", wget_load_addr);
+	puts("Loading: *\b");
+
+	wget_hdr_len = 0;
+	wget_have_headers = false;
+	wget_body_start = 0;
+	wget_content_len = -1;
+	wget_hashes = 0;
+	net_boot_file_size = 0;
+	wget_time_start = get_timer(0);
+
+	tcp_connect(wget_server_ip, wget_server_port, wget_rx, wget_event);
+}
@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * wget - download a file over HTTP
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+/* Well known HTTP port # */
+#define WGET_DEFAULT_PORT	80
+
+void wget_start(void);	/* Begin HTTP download */
+
+#endif /* __WGET_H__ */
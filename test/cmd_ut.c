@@ -8,6 +8,7 @@
 #include <command.h>
 #include <test/suites.h>
 #include <test/test.h>
+#include <test/ut.h>
 
 static int do_ut_all(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
@@ -26,6 +27,7 @@ int cmd_ut_category(const char *name, struct unit_test *tests, int n_ents,
 		printf("Test: %s\n", test->name);
 
 		uts.start = mallinfo();
+		ut_leak_start(&uts);
 
 		test->func(&uts);
 	}
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for devices which finish probing in the background
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <asm/test.h>
+#include <test/ut.h>
+
+/**
+ * struct async_test_pdata - Behaviour of an async test device
+ *
+ * @polls: Number of polls before the device is ready
+ * @ret: Value to return when ready
+ */
+struct async_test_pdata {
+	int polls;
+	int ret;
+};
+
+struct async_test_priv {
+	int polls;
+};
+
+static int async_test_poll(struct udevice *dev)
+{
+	struct async_test_pdata *plat = dev_get_platdata(dev);
+	struct async_test_priv *priv = dev_get_priv(dev);
+
+	if (++priv->polls < plat->polls)
+		return -EAGAIN;
+
+	return plat->ret;
+}
+
+static int async_test_probe(struct udevice *dev)
+{
+	return device_async_start(dev, async_test_poll);
+}
+
+U_BOOT_DRIVER(async_test_drv) = {
+	.name	= "async_test_drv",
+	.id	= UCLASS_NOP,
+	.probe	= async_test_probe,
+	.priv_auto_alloc_size	= sizeof(struct async_test_priv),
+};
+
+/* The test uclass counts calls to its post_probe() method */
+U_BOOT_DRIVER(async_test_uc_drv) = {
+	.name	= "async_test_uc_drv",
+	.id	= UCLASS_TEST,
+	.probe	= async_test_probe,
+	.priv_auto_alloc_size	= sizeof(struct async_test_priv),
+};
+
+static int async_test_bind(struct unit_test_state *uts,
+			   struct udevice *parent, const char *name,
+			   struct async_test_pdata *plat, struct udevice **devp)
+{
+	ut_assertok(device_bind(parent, DM_GET_DRIVER(async_test_drv), name,
+				plat, -1, devp));
+
+	return 0;
+}
+
+static int async_test_polls(struct udevice *dev)
+{
+	struct async_test_priv *priv = dev_get_priv(dev);
+
+	return priv->polls;
+}
+
+/* Test that the waits of several devices overlap */
+static int dm_test_async_overlap(struct unit_test_state *uts)
+{
+	struct async_test_pdata plat_a = { .polls = 5 };
+	struct async_test_pdata plat_b = { .polls = 3 };
+	struct udevice *dev_a, *dev_b;
+
+	ut_assertok(async_test_bind(uts, dm_root(), "a", &plat_a, &dev_a));
+	ut_assertok(async_test_bind(uts, dm_root(), "b", &plat_b, &dev_b));
+
+	/* Both probes return before their devices are ready */
+	ut_assertok(device_probe(dev_a));
+	ut_assertok(device_probe(dev_b));
+	ut_assert(dev_a->flags & DM_FLAG_ACTIVATED);
+	ut_assert(dev_a->flags & DM_FLAG_PROBE_ASYNC);
+	ut_assert(dev_b->flags & DM_FLAG_PROBE_ASYNC);
+	ut_asserteq(0, async_test_polls(dev_a));
+
+	ut_asserteq(2, device_async_poll());
+	ut_asserteq(1, async_test_polls(dev_a));
+	ut_asserteq(1, async_test_polls(dev_b));
+
+	/* Probing again waits for b, which polls a at the same time */
+	ut_assertok(device_probe(dev_b));
+	ut_assert(!(dev_b->flags & DM_FLAG_PROBE_ASYNC));
+	ut_asserteq(3, async_test_polls(dev_b));
+	ut_asserteq(3, async_test_polls(dev_a));
+	ut_assert(dev_a->flags & DM_FLAG_PROBE_ASYNC);
+
+	/* So a needs only two more polls, not five */
+	ut_assertok(device_async_wait_all());
+	ut_assert(!(dev_a->flags & DM_FLAG_PROBE_ASYNC));
+	ut_asserteq(5, async_test_polls(dev_a));
+	ut_asserteq(0, device_async_poll());
+
+	return 0;
+}
+DM_TEST(dm_test_async_overlap, 0);
+
+/* Test that a child waits for its parent to be ready */
+static int dm_test_async_parent(struct unit_test_state *uts)
+{
+	struct async_test_pdata plat_parent = { .polls = 4 };
+	struct async_test_pdata plat_child = { .polls = 1 };
+	struct udevice *parent, *child;
+
+	ut_assertok(async_test_bind(uts, dm_root(), "parent", &plat_parent,
+				    &parent));
+	ut_assertok(async_test_bind(uts, parent, "child", &plat_child, &child));
+
+	ut_assertok(device_probe(parent));
+	ut_assert(parent->flags & DM_FLAG_PROBE_ASYNC);
+
+	ut_assertok(device_probe(child));
+	ut_assert(!(parent->flags & DM_FLAG_PROBE_ASYNC));
+	ut_asserteq(4, async_test_polls(parent));
+	ut_assert(child->flags & DM_FLAG_ACTIVATED);
+	ut_assertok(device_async_wait_all());
+
+	return 0;
+}
+DM_TEST(dm_test_async_parent, 0);
+
+/* Test that a failure is reported to the waiter and the device removed */
+static int dm_test_async_error(struct unit_test_state *uts)
+{
+	struct async_test_pdata plat = { .polls = 2, .ret = -EIO };
+	struct udevice *dev;
+
+	ut_assertok(async_test_bind(uts, dm_root(), "fail", &plat, &dev));
+
+	ut_assertok(device_probe(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_ASYNC);
+	ut_asserteq(-EIO, device_async_wait(dev));
+	ut_assert(!(dev->flags & DM_FLAG_ACTIVATED));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_ASYNC));
+
+	/* Removing a device stops the wait */
+	ut_assertok(device_probe(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_ASYNC);
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_ASYNC));
+	ut_asserteq(0, device_async_poll());
+
+	return 0;
+}
+DM_TEST(dm_test_async_error, 0);
+
+/* Test that the uclass only sees the device once it is ready */
+static int dm_test_async_post_probe(struct unit_test_state *uts)
+{
+	struct async_test_pdata plat = { .polls = 3 };
+	struct udevice *dev;
+	int count;
+
+	ut_assertok(device_bind(dm_root(), DM_GET_DRIVER(async_test_uc_drv),
+				"post", &plat, -1, &dev));
+	count = dm_testdrv_op_count[DM_TEST_OP_POST_PROBE];
+
+	ut_assertok(device_probe(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_ASYNC);
+	ut_asserteq(count, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+	ut_asserteq(1, device_async_poll());
+	ut_asserteq(count, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	ut_assertok(device_async_wait(dev));
+	ut_asserteq(count + 1, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	/* Probing again does not call it twice */
+	ut_assertok(device_probe(dev));
+	ut_asserteq(count + 1, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	/* If the device fails, the uclass never sees it */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	plat.ret = -EIO;
+	ut_assertok(device_probe(dev));
+	ut_asserteq(-EIO, device_async_wait(dev));
+	ut_asserteq(count + 1, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	return 0;
+}
+DM_TEST(dm_test_async_post_probe, 0);
+
+/* Test that the sandbox delayed devices wait at the same time */
+static int dm_test_async_sandbox(struct unit_test_state *uts)
+{
+	struct udevice *dev0, *dev1;
+	ulong start, elapsed;
+
+	start = get_timer(0);
+	ut_assertok(sandbox_async_start_all());
+	ut_asserteq(2, device_async_poll());
+
+	/* Waiting for the first (50ms) lets the second (30ms) finish too */
+	ut_assertok(uclass_get_device_by_name(UCLASS_MISC, "async-delay-0",
+					      &dev0));
+	ut_asserteq(0, device_async_poll());
+	ut_assertok(uclass_get_device_by_name(UCLASS_MISC, "async-delay-1",
+					      &dev1));
+	elapsed = get_timer(start);
+	ut_assert(elapsed >= 50);
+	ut_assert(elapsed < 50 + 30);
+
+	return 0;
+}
+DM_TEST(dm_test_async_sandbox, DM_TESTF_SCAN_FDT);
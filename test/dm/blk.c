@@ -4,9 +4,14 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
+#include <linux/sizes.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -162,3 +167,177 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that the block cache serves partial hits and saves device reads */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	char fname[256];
+	struct block_cache_stats stats, old;
+	struct blk_readahead_stats ra_old;
+	struct host_block_dev *host_dev;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char *data, *buf;
+	int i;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname),
+				       "blkcache_test.img"));
+	data = malloc(16 * 512);
+	buf = malloc(16 * 512);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	for (i = 0; i < 16 * 512; i++)
+		data[i] = i / 512 + i % 251;
+	ut_assertok(os_write_file(fname, data, 16 * 512));
+	ut_assertok(host_dev_bind(0, fname));
+	ut_assertok(blk_get_device(IF_TYPE_HOST, 0, &dev));
+	desc = dev_get_uclass_platdata(dev);
+	host_dev = dev_get_platdata(dev);
+
+	blkcache_stats(&old);
+	blkcache_configure(8, 32);
+	blk_readahead_stats(&ra_old);
+	blk_readahead_configure(0);
+
+	/* A cold read goes to the device */
+	host_dev->read_count = 0;
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(1, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 4 * 512);
+
+	/* Reading it again is served entirely from the cache */
+	memset(buf, '\0', 16 * 512);
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(1, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 4 * 512);
+
+	/* A partial hit only reads the missing blocks */
+	ut_asserteq(4, blk_dread(desc, 2, 4, buf));
+	ut_asserteq(2, host_dev->read_count);
+	ut_asserteq_mem(data + 2 * 512, buf, 4 * 512);
+
+	/* Each run of missing blocks needs one read */
+	ut_asserteq(2, blk_dread(desc, 8, 2, buf));
+	ut_asserteq(3, host_dev->read_count);
+	ut_asserteq(8, blk_dread(desc, 4, 8, buf));
+	ut_asserteq(5, host_dev->read_count);
+	ut_asserteq_mem(data + 4 * 512, buf, 8 * 512);
+	ut_asserteq(12, blk_dread(desc, 0, 12, buf));
+	ut_asserteq(5, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 12 * 512);
+	blkcache_stats(&stats);
+	ut_asserteq(8 * 32, stats.max_entries);
+	ut_asserteq(22, stats.hits);
+	ut_asserteq(12, stats.misses);
+	ut_asserteq(0, stats.evictions);
+	ut_asserteq(12, stats.entries);
+
+	/* A write discards the cached blocks */
+	ut_asserteq(1, blk_dwrite(desc, 3, 1, data + 3 * 512));
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(6, host_dev->read_count);
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.entries);
+
+	/* The size can also be given in MiB */
+	blkcache_configure_size(8, 1);
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(7, host_dev->read_count);
+	blkcache_stats(&stats);
+	ut_asserteq(SZ_1M / 512, stats.max_entries);
+	ut_asserteq(1024, stats.size_kb);
+
+	/* With the cache disabled every read goes to the device */
+	blkcache_configure(0, 0);
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(9, host_dev->read_count);
+
+	blkcache_configure_size(old.max_blocks_per_entry, old.size_mb);
+	blk_readahead_configure(ra_old.size_kb);
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(fname);
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+/* Test that sequential reads are served from the read-ahead buffer */
+static int dm_test_blk_readahead(struct unit_test_state *uts)
+{
+	char fname[256];
+	struct block_cache_stats old;
+	struct blk_readahead_stats stats, ra_old;
+	struct host_block_dev *host_dev;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char *data, *buf;
+	int i;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "blkra_test.img"));
+	data = malloc(256 * 512);
+	buf = malloc(256 * 512);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	for (i = 0; i < 256 * 512; i++)
+		data[i] = i / 512 + i % 251;
+	ut_assertok(os_write_file(fname, data, 256 * 512));
+	ut_assertok(host_dev_bind(0, fname));
+	ut_assertok(blk_get_device(IF_TYPE_HOST, 0, &dev));
+	desc = dev_get_uclass_platdata(dev);
+	host_dev = dev_get_platdata(dev);
+
+	/* Keep the block cache out of the way */
+	blkcache_stats(&old);
+	blkcache_configure(0, 0);
+	blk_readahead_stats(&ra_old);
+
+	/* Without read-ahead, reading 8 blocks at a time needs 32 reads */
+	blk_readahead_configure(0);
+	host_dev->read_count = 0;
+	for (i = 0; i < 256; i += 8)
+		ut_asserteq(8, blk_dread(desc, i, 8, buf + i * 512));
+	ut_asserteq(32, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 256 * 512);
+
+	/*
+	 * With a 64KiB window, the first read is not known to be sequential.
+	 * The second reads blocks 8-135 and the 18th reads the rest.
+	 */
+	blk_readahead_configure(64);
+	blk_readahead_invalidate(desc);
+	host_dev->read_count = 0;
+	memset(buf, '\0', 256 * 512);
+	for (i = 0; i < 256; i += 8)
+		ut_asserteq(8, blk_dread(desc, i, 8, buf + i * 512));
+	ut_asserteq(3, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 256 * 512);
+	blk_readahead_stats(&stats);
+	ut_asserteq(32, stats.requests);
+	ut_asserteq(3, stats.dev_reads);
+	ut_asserteq(29, stats.hits);
+
+	/* A random read goes straight to the device */
+	ut_asserteq(8, blk_dread(desc, 100, 8, buf));
+	ut_asserteq(4, host_dev->read_count);
+
+	/* A write discards data read ahead */
+	ut_asserteq(1, blk_dwrite(desc, 240, 1, data));
+	ut_asserteq(8, blk_dread(desc, 240, 8, buf));
+	ut_asserteq(5, host_dev->read_count);
+	ut_asserteq_mem(data, buf, 512);
+
+	blkcache_configure_size(old.max_blocks_per_entry, old.size_mb);
+	blk_readahead_configure(ra_old.size_kb);
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(fname);
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_readahead, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -737,6 +737,160 @@ static int dm_test_uclass_before_ready(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_before_ready, 0);
 
+/* Number of devices to bind, enough to put several in each hash bucket */
+#define DM_TEST_INDEX_DEVS	(DM_UCLASS_HASH_SIZE * 4)
+
+/* Check finding devices by sequence number as they come and go */
+static int dm_test_uclass_index_seq(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev[DM_TEST_INDEX_DEVS], *found;
+	int i, seq;
+
+	/* Devices are probed out of order, which test_post_probe() rejects */
+	dms->skip_post_probe = 1;
+	for (i = 0; i < DM_TEST_INDEX_DEVS; i++) {
+		ut_assertok(device_bind_by_name(dms->root, false,
+						&driver_info_manual, &dev[i]));
+		ut_assertok(device_probe(dev[i]));
+	}
+	ut_asserteq_ptr(dev[0]->uclass, uclass_find(UCLASS_TEST));
+
+	for (i = 0; i < DM_TEST_INDEX_DEVS; i++) {
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[i]->seq,
+						      false, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+
+	/* Removing a device frees its number, which the next probe takes */
+	for (i = 0; i < DM_TEST_INDEX_DEVS; i += 2) {
+		seq = dev[i]->seq;
+		ut_assertok(device_remove(dev[i], DM_REMOVE_NORMAL));
+		ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq,
+							       false, &found));
+	}
+	for (i = DM_TEST_INDEX_DEVS - 2; i >= 0; i -= 2)
+		ut_assertok(device_probe(dev[i]));
+	for (i = 0; i < DM_TEST_INDEX_DEVS; i++) {
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[i]->seq,
+						      false, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+
+	/* Unbound devices must not be found */
+	for (i = 0; i < DM_TEST_INDEX_DEVS; i++) {
+		seq = dev[i]->seq;
+		ut_assertok(device_remove(dev[i], DM_REMOVE_NORMAL));
+		ut_assertok(device_unbind(dev[i]));
+		ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq,
+							       false, &found));
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index_seq, DM_TESTF_SCAN_PDATA);
+
+/* Check finding devices by node, including after the node changes */
+static int dm_test_uclass_index_ofnode(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	struct uclass *uc;
+	ofnode node, other;
+
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	uclass_foreach_dev(dev, uc) {
+		ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							 dev_ofnode(dev),
+							 &found));
+		ut_asserteq_ptr(dev, found);
+	}
+
+	ut_assertok(uclass_find_first_device(UCLASS_TEST_FDT, &dev));
+	node = dev_ofnode(dev);
+	other = ofnode_path("/aliases");
+	ut_assert(ofnode_valid(other));
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  other, &found));
+
+	dev_set_ofnode(dev, other);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, other,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  node, &found));
+
+	dev_set_ofnode(dev, node);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index_ofnode, DM_TESTF_SCAN_FDT);
+
+#define DM_TEST_BENCH_MAX_DEVS	256
+
+/*
+ * Report the number of devices checked, and the time taken, to probe devices
+ * and to find them by sequence number, as the uclass grows. Without
+ * CONFIG_DM_UCLASS_INDEX each lookup checks every device before the one it
+ * finds.
+ */
+static int dm_test_uclass_index_bench(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice **dev, *found;
+	ulong start, probe_us, find_us;
+	uint probe_steps, find_steps;
+	int count, i;
+
+	dev = calloc(DM_TEST_BENCH_MAX_DEVS, sizeof(*dev));
+	ut_assertnonnull(dev);
+	for (count = 16; count <= DM_TEST_BENCH_MAX_DEVS; count *= 4) {
+		for (i = 0; i < count; i++)
+			ut_assertok(device_bind_by_name(dms->root, false,
+							&driver_info_manual,
+							&dev[i]));
+
+		uclass_lookup_steps(true);
+		start = timer_get_us();
+		for (i = 0; i < count; i++)
+			ut_assertok(device_probe(dev[i]));
+		probe_us = timer_get_us() - start;
+		probe_steps = uclass_lookup_steps(true);
+
+		start = timer_get_us();
+		for (i = 0; i < count; i++) {
+			ut_assertok(uclass_find_device_by_seq(UCLASS_TEST,
+							      dev[i]->seq,
+							      false, &found));
+			ut_asserteq_ptr(dev[i], found);
+		}
+		find_us = timer_get_us() - start;
+		find_steps = uclass_lookup_steps(true);
+
+		printf("uclass: %3d devices: probe %5u steps %5lu us, find %5u steps %5lu us\n",
+		       count, probe_steps / count, probe_us, find_steps / count,
+		       find_us);
+		if (IS_ENABLED(CONFIG_DM_UCLASS_INDEX)) {
+			ut_assert(find_steps <=
+				  count * DIV_ROUND_UP(count,
+						       DM_UCLASS_HASH_SIZE));
+		} else {
+			ut_asserteq(count * (count + 1) / 2, find_steps);
+		}
+
+		for (i = 0; i < count; i++) {
+			ut_assertok(device_remove(dev[i], DM_REMOVE_NORMAL));
+			ut_assertok(device_unbind(dev[i]));
+		}
+	}
+	free(dev);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index_bench, 0);
+
 static int dm_test_uclass_devices_find(struct unit_test_state *uts)
 {
 	struct udevice *dev;
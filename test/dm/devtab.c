@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for binding with the device tables generated by dtoc
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/device-internal.h>
+#include <dm/devtab.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of times to bind the tree, to get a measurable time */
+#define DEVTAB_TEST_LOOPS	20
+
+static int devtab_count_devices(struct udevice *parent)
+{
+	struct udevice *dev;
+	int count = 1;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node)
+		count += devtab_count_devices(dev);
+
+	return count;
+}
+
+/* Count the compatible strings for which a driver has been looked up */
+static int devtab_count_matched(void)
+{
+	struct dm_devtab *start = ll_entry_start(struct dm_devtab, devtab);
+	const int n_ents = ll_entry_count(struct dm_devtab, devtab);
+	struct dm_devtab *tab;
+	int count = 0;
+	int i;
+
+	for (tab = start; tab != start + n_ents; tab++) {
+		for (i = 0; i < tab->match_count; i++)
+			count += tab->match[i].done;
+	}
+
+	return count;
+}
+
+/**
+ * devtab_bind() - Bind the device tree a number of times
+ *
+ * @uts: Test state
+ * @loops: Number of times to bind
+ * @timep: Returns the time taken in microseconds
+ * @countp: Returns the number of devices bound each time
+ * @return 0 if OK, -ve on error
+ */
+static int devtab_bind(struct unit_test_state *uts, int loops, ulong *timep,
+		       int *countp)
+{
+	struct udevice *root = dm_root();
+	ulong start;
+	int i;
+
+	*timep = 0;
+	for (i = 0; i < loops; i++) {
+		start = timer_get_us();
+		ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+		*timep += timer_get_us() - start;
+		*countp = devtab_count_devices(root);
+		ut_assertok(device_chld_remove(root, NULL, DM_REMOVE_NORMAL));
+		ut_assertok(device_chld_unbind(root, NULL));
+	}
+
+	return 0;
+}
+
+/* Test that the device tables bind the same devices, and time them */
+static int dm_test_devtab_bind(struct unit_test_state *uts)
+{
+	ulong time_without, time_cold, time_with;
+	int count_without, count_with;
+
+	lists_devtab_set_enabled(false);
+	ut_assertok(devtab_bind(uts, DEVTAB_TEST_LOOPS, &time_without,
+				&count_without));
+	ut_asserteq(0, devtab_count_matched());
+
+	/* The first time, the driver for each compatible string is found */
+	lists_devtab_set_enabled(true);
+	ut_assertok(devtab_bind(uts, 1, &time_cold, &count_with));
+	ut_asserteq(count_without, count_with);
+	ut_assert(devtab_count_matched() > 0);
+
+	ut_assertok(devtab_bind(uts, DEVTAB_TEST_LOOPS, &time_with,
+				&count_with));
+	ut_asserteq(count_without, count_with);
+
+	printf("%d devices: bind %ldus without tables, %ldus with (%ldus the first time)\n",
+	       count_with, time_without / DEVTAB_TEST_LOOPS,
+	       time_with / DEVTAB_TEST_LOOPS, time_cold);
+
+	return 0;
+}
+DM_TEST(dm_test_devtab_bind, DM_TESTF_FLAT_TREE);
+
+/* Test that a node which differs from the table is still bound correctly */
+static int dm_test_devtab_mismatch(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	void *blob = (void *)gd->fdt_blob;
+	int node;
+
+	/* Change a node's compatible string to another driver's */
+	node = fdt_path_offset(blob, "/a-test");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_inplace(blob, node, "compatible",
+					"denx,u-boot-test-bus", 21));
+
+	lists_devtab_set_enabled(true);
+	ut_assertok(dm_scan_fdt(blob, false));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_BUS, "a-test",
+					       &dev));
+	ut_asserteq_str("testbus_drv", dev->driver->name);
+
+	ut_assertok(fdt_setprop_inplace(blob, node, "compatible",
+					"denx,u-boot-fdt-test", 21));
+	ut_assertok(device_chld_remove(dm_root(), NULL, DM_REMOVE_NORMAL));
+	ut_assertok(device_chld_unbind(dm_root(), NULL));
+	ut_assertok(dm_scan_fdt(blob, false));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "a-test",
+					       &dev));
+	ut_asserteq_str("testfdt_drv", dev->driver->name);
+
+	return 0;
+}
+DM_TEST(dm_test_devtab_mismatch, DM_TESTF_FLAT_TREE);
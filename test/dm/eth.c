@@ -10,6 +10,7 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
@@ -428,3 +429,179 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+static int sb_count_arp_reply(struct udevice *dev, void *packet,
+			      unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+	int *replies = priv->priv;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP &&
+	    ntohs(arp->ar_op) == ARPOP_REPLY)
+		(*replies)++;
+
+	return 0;
+}
+
+/* Check that eth_rx() drains the receive ring, and that the ring wraps */
+static int dm_test_eth_rx_ring(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct in_addr old_ip = net_ip;
+	struct udevice *dev;
+	int replies = 0;
+	int i, round;
+
+	env_set("ethact", "eth@10002000");
+	net_init();
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	ut_assertnonnull(dev);
+	priv = dev_get_priv(dev);
+	priv->fake_host_ipaddr = string_to_ip("1.1.2.4");
+	net_ip = string_to_ip("1.1.2.2");
+	memcpy(net_ethaddr, eth_get_ethaddr(), ARP_HLEN);
+
+	sandbox_eth_set_tx_handler(0, sb_count_arp_reply);
+	sandbox_eth_set_priv(0, &replies);
+
+	/* A full ring is handled in one call */
+	for (i = 0; i < PKTBUFSRX; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(-EOVERFLOW, sandbox_eth_recv_arp_req(dev));
+	ut_assertok(eth_rx());
+	ut_asserteq(PKTBUFSRX, replies);
+
+	/* Push a stream of packets through, starting at each ring position */
+	for (round = 0; round < 1000; round++) {
+		for (i = 0; i < PKTBUFSRX - 1; i++)
+			ut_assertok(sandbox_eth_recv_arp_req(dev));
+		ut_assertok(eth_rx());
+	}
+	ut_asserteq(PKTBUFSRX + 1000 * (PKTBUFSRX - 1), replies);
+
+	eth_halt();
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+	net_ip = old_ip;
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_rx_ring, DM_TESTF_SCAN_FDT);
+
+/* Largest UDP payload in a standard Ethernet frame */
+#define ETH_TEST_BENCH_LEN	(1500 - IP_UDP_HDR_SIZE)
+#define ETH_TEST_BENCH_ROUNDS	2000
+
+static ulong eth_test_rx_bytes;
+
+static void eth_test_rx_udp(uchar *pkt, unsigned int dport,
+			    struct in_addr sip, unsigned int sport,
+			    unsigned int len)
+{
+	eth_test_rx_bytes += len;
+}
+
+/* Report how fast full-size UDP frames pass through eth_rx() */
+static int dm_test_eth_rx_bench(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct in_addr old_ip = net_ip;
+	ulong start, elapsed_us;
+	struct udevice *dev;
+	int frames, i, round;
+
+	env_set("ethact", "eth@10002000");
+	net_init();
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	ut_assertnonnull(dev);
+	priv = dev_get_priv(dev);
+	priv->fake_host_ipaddr = string_to_ip("1.1.2.4");
+	net_ip = string_to_ip("1.1.2.2");
+	memcpy(net_ethaddr, eth_get_ethaddr(), ARP_HLEN);
+	net_set_udp_handler(eth_test_rx_udp);
+	eth_test_rx_bytes = 0;
+
+	start = timer_get_us();
+	for (round = 0; round < ETH_TEST_BENCH_ROUNDS; round++) {
+		for (i = 0; i < PKTBUFSRX; i++)
+			ut_assertok(sandbox_eth_recv_udp(dev, 1234, 69,
+							 ETH_TEST_BENCH_LEN));
+		ut_assertok(eth_rx());
+	}
+	elapsed_us = max(timer_get_us() - start, 1UL);
+	frames = ETH_TEST_BENCH_ROUNDS * PKTBUFSRX;
+	ut_asserteq(frames * ETH_TEST_BENCH_LEN, eth_test_rx_bytes);
+
+	printf("eth: %d frames of %d bytes in %lu us: %lu frames/s, %lu KiB/s\n",
+	       frames, (int)ETH_TEST_BENCH_LEN, elapsed_us,
+	       (ulong)((u64)frames * 1000000 / elapsed_us),
+	       (ulong)((u64)eth_test_rx_bytes * 1000000 / 1024 / elapsed_us));
+
+	net_set_udp_handler(NULL);
+	eth_halt();
+	net_ip = old_ip;
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_rx_bench, DM_TESTF_SCAN_FDT);
+
+#if defined(CONFIG_CMD_WGET)
+/* Odd-sized, so that the last segment and the checksum are odd too */
+#define ETH_TEST_WGET_SIZE	(20 * 1024 + 1)
+#define ETH_TEST_WGET_ADDR	0x1000000
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_eth_wget(struct unit_test_state *uts, const u8 *body)
+{
+	u8 *buf;
+
+	buf = map_sysmem(ETH_TEST_WGET_ADDR, ETH_TEST_WGET_SIZE);
+	memset(buf, '\0', ETH_TEST_WGET_SIZE);
+
+	env_set("ethact", "eth@10002000");
+	copy_filename(net_boot_file_name, "1.1.2.2:/image.bin",
+		      sizeof(net_boot_file_name));
+	load_addr = ETH_TEST_WGET_ADDR;
+	ut_asserteq(ETH_TEST_WGET_SIZE, net_loop(WGET));
+	ut_asserteq(ETH_TEST_WGET_SIZE, env_get_hex("filesize", 0));
+	ut_asserteq_mem(body, buf, ETH_TEST_WGET_SIZE);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+/*
+ * Download a file over TCP from the fake HTTP server in the sandbox driver.
+ * Its sequence numbers wrap around during the transfer.
+ */
+static int dm_test_eth_wget(struct unit_test_state *uts)
+{
+	ulong old_load_addr = load_addr;
+	u8 *body;
+	int retval;
+	int i;
+
+	body = malloc(ETH_TEST_WGET_SIZE);
+	ut_assertnonnull(body);
+	for (i = 0; i < ETH_TEST_WGET_SIZE; i++)
+		body[i] = i * 37 + 11;
+	sandbox_eth_set_http(0, body, ETH_TEST_WGET_SIZE);
+
+	retval = _dm_test_eth_wget(uts, body);
+
+	sandbox_eth_set_http(0, NULL, 0);
+	net_boot_file_name[0] = '\0';
+	load_addr = old_load_addr;
+	free(body);
+
+	return retval;
+}
+
+DM_TEST(dm_test_eth_wget, DM_TESTF_SCAN_FDT);
+#endif
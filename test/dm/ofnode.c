@@ -2,10 +2,17 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <dm/of_access.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
+#include <linux/sizes.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -58,3 +65,210 @@ static int dm_test_ofnode_fmap(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_ofnode_fmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Check that every lookup gives the same answer as libfdt, even when cached */
+static int ofnode_check_lookups(struct unit_test_state *uts, const void *blob)
+{
+	int offset, depth = 0;
+	char path[256];
+	uint phandle;
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle)
+			ut_asserteq(offset,
+				    fdtdec_node_offset_by_phandle(blob, phandle));
+		ut_assertok(fdt_get_path(blob, offset, path, sizeof(path)));
+		ut_asserteq(offset, fdtdec_path_offset(blob, path));
+		ut_asserteq(offset, fdtdec_path_offset(blob, path));
+	}
+
+	return 0;
+}
+
+static int dm_test_ofnode_lookup_cache(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int offset, last, node;
+	uint phandle;
+	void *buf;
+	int size;
+
+	ut_assertok(ofnode_check_lookups(uts, blob));
+	phandle = fdt_get_max_phandle(blob) + 1;
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(blob, phandle));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(blob, "/missing"));
+
+	/* Adding a node first moves all the others */
+	size = fdt_totalsize(blob) + 1024;
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertok(fdt_open_into(blob, buf, size));
+	gd->fdt_blob = buf;
+	offset = fdtdec_path_offset(buf, "/aliases");
+	ut_assert(offset > 0);
+	phandle = fdt_get_phandle(buf, fdt_first_subnode(buf, 0));
+	ut_assert(fdt_add_subnode(buf, 0, "aaa-first") >= 0);
+	ut_assert(fdtdec_path_offset(buf, "/aliases") > offset);
+	ut_asserteq(fdt_path_offset(buf, "/aliases"),
+		    fdtdec_path_offset(buf, "/aliases"));
+	ut_asserteq(fdt_node_offset_by_phandle(buf, phandle),
+		    fdtdec_node_offset_by_phandle(buf, phandle));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(buf, "/missing"));
+	ut_assert(fdtdec_path_offset(buf, "/aaa-first") > 0);
+	ut_assertok(ofnode_check_lookups(uts, buf));
+
+	/*
+	 * Delete the node and add one of the same size inside the last
+	 * subnode of the root. The tree keeps its size but the nodes between
+	 * move up.
+	 */
+	size = fdt_size_dt_struct(buf);
+	ut_assertok(fdt_del_node(buf, fdt_path_offset(buf, "/aaa-first")));
+	last = -FDT_ERR_NOTFOUND;
+	fdt_for_each_subnode(node, buf, 0)
+		last = node;
+	ut_assert(last > 0);
+	ut_assert(fdt_add_subnode(buf, last, "bbb-first") >= 0);
+	ut_asserteq(size, fdt_size_dt_struct(buf));
+	ut_assertok(ofnode_check_lookups(uts, buf));
+
+	/* A phandle too large for the table is still found */
+	node = fdt_path_offset(buf, "/aliases");
+	ut_assertok(fdt_setprop_u32(buf, node, "phandle", 0x7fffff00));
+	ut_asserteq(node, fdtdec_node_offset_by_phandle(buf, 0x7fffff00));
+	ut_assertok(ofnode_check_lookups(uts, buf));
+
+	/*
+	 * Renaming a parent changes the path of its child, although the child
+	 * keeps its offset and name
+	 */
+	node = fdt_add_subnode(buf, 0, "ccc-parent");
+	ut_assert(node > 0);
+	offset = fdt_add_subnode(buf, node, "child");
+	ut_assert(offset > 0);
+	ut_asserteq(offset, fdtdec_path_offset(buf, "/ccc-parent/child"));
+	ut_assertok(fdt_set_name(buf, node, "ddd-parent"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_path_offset(buf, "/ccc-parent/child"));
+	ut_asserteq(offset, fdtdec_path_offset(buf, "/ddd-parent/child"));
+
+	gd->fdt_blob = blob;
+	free(buf);
+	fdtdec_cache_invalidate();
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_lookup_cache, DM_TESTF_SCAN_FDT);
+
+#define OFNODE_BENCH_NODES	2000
+
+/*
+ * Report the time taken for the lookups made while probing every device in
+ * a large tree: each node has a phandle and refers to another node by
+ * phandle, and is found by its path. This is compared with libfdt, which
+ * walks the tree from the start for each lookup.
+ */
+static int dm_test_ofnode_lookup_bench(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	ulong start, fdt_us, cached_us;
+	const int size = SZ_256K;
+	char path[32];
+	int offset, i;
+	void *buf;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertok(fdt_create_empty_tree(buf, size));
+	for (i = OFNODE_BENCH_NODES - 1; i >= 0; i--) {
+		snprintf(path, sizeof(path), "dev@%x", i);
+		offset = fdt_add_subnode(buf, 0, path);
+		ut_assert(offset > 0);
+		ut_assertok(fdt_setprop_u32(buf, offset, "phandle", i + 1));
+		ut_assertok(fdt_setprop_u32(buf, offset, "clocks",
+				OFNODE_BENCH_NODES - i));
+	}
+	gd->fdt_blob = buf;
+	fdtdec_cache_invalidate();
+
+	start = timer_get_us();
+	for (i = 0; i < OFNODE_BENCH_NODES; i++) {
+		snprintf(path, sizeof(path), "/dev@%x", i);
+		offset = fdt_path_offset(buf, path);
+		ut_assert(offset > 0);
+		ut_assert(fdt_node_offset_by_phandle(buf,
+				fdtdec_get_int(buf, offset, "clocks", 0)) > 0);
+	}
+	fdt_us = timer_get_us() - start;
+
+	/* Each path is looked up twice, as by alias and then by driver */
+	start = timer_get_us();
+	for (i = 0; i < OFNODE_BENCH_NODES; i++) {
+		snprintf(path, sizeof(path), "/dev@%x", i);
+		offset = fdtdec_path_offset(buf, path);
+		ut_asserteq(offset, fdtdec_path_offset(buf, path));
+		ut_assert(fdtdec_node_offset_by_phandle(buf,
+				fdtdec_get_int(buf, offset, "clocks", 0)) > 0);
+	}
+	cached_us = timer_get_us() - start;
+
+	printf("ofnode: %d nodes: libfdt %lu us, cached %lu us\n",
+	       OFNODE_BENCH_NODES, fdt_us, cached_us);
+	gd->fdt_blob = blob;
+	free(buf);
+	fdtdec_cache_invalidate();
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_lookup_bench, DM_TESTF_SCAN_FDT);
+
+static int ofnode_count_live(struct device_node *np, struct device_node **lazyp)
+{
+	struct device_node *child;
+	int count = 1;
+
+#ifdef CONFIG_OF_LIVE_LAZY
+	if (np->offset >= 0 && !*lazyp)
+		*lazyp = np;
+#endif
+	for (child = np->child; child; child = child->sibling)
+		count += ofnode_count_live(child, lazyp);
+
+	return count;
+}
+
+/* Test the information about the live tree, and decoding nodes on first use */
+static int dm_test_ofnode_live_stats(struct unit_test_state *uts)
+{
+	const struct of_live_stats *stats = of_live_get_stats();
+	struct device_node *lazy = NULL;
+	int lazy_nodes, props;
+
+	ut_assert(of_live_active());
+	ut_assert(stats->size > 0);
+	ut_asserteq(stats->nodes, ofnode_count_live(gd->of_root, &lazy));
+	if (!IS_ENABLED(CONFIG_OF_LIVE_LAZY)) {
+		ut_asserteq(0, stats->lazy_nodes);
+		return 0;
+	}
+
+	/* Reading a property of a node decodes all of them, once */
+	if (!lazy)
+		return 0;
+	lazy_nodes = stats->lazy_nodes;
+	props = stats->props;
+	ut_assert(lazy_nodes > 0);
+	ut_assertnonnull(of_find_property(lazy, "name", NULL));
+	ut_asserteq(lazy_nodes - 1, stats->lazy_nodes);
+	ut_assert(stats->props > props);
+	props = stats->props;
+	ut_assertnonnull(of_find_property(lazy, "name", NULL));
+	ut_asserteq(lazy_nodes - 1, stats->lazy_nodes);
+	ut_asserteq(props, stats->props);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_live_stats, DM_TESTF_SCAN_FDT | DM_TESTF_LIVE_TREE);
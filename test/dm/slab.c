@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the driver-model size-class allocator
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/slab.h>
+#include <dm/test.h>
+#include <dm/util.h>
+#include <test/ut.h>
+
+/* Test allocating and freeing objects directly */
+static int dm_test_slab_alloc(struct unit_test_state *uts)
+{
+	struct dm_slab_stats before, stats;
+	u8 *ptr1, *ptr2, *large;
+	int i;
+
+	dm_slab_get_stats(&before);
+	ptr1 = dm_slab_alloc(40);
+	ut_assertnonnull(ptr1);
+	ptr2 = dm_slab_alloc(44);
+	ut_assertnonnull(ptr2);
+	large = dm_slab_alloc(DM_SLAB_MAX_SIZE + 1);
+	ut_assertnonnull(large);
+
+	/* Both come from the 48-byte size class, zeroed */
+	for (i = 0; i < 44; i++)
+		ut_asserteq(0, ptr2[i]);
+	ut_asserteq(0, (ulong)ptr1 & 15);
+
+	dm_slab_get_stats(&stats);
+	ut_asserteq(before.allocs + 2, stats.allocs);
+	ut_asserteq(before.req_bytes + 84, stats.req_bytes);
+	ut_asserteq(before.used_bytes + 96, stats.used_bytes);
+	ut_asserteq(before.large_allocs + 1, stats.large_allocs);
+	ut_asserteq(before.total_allocs + 3, stats.total_allocs);
+
+	/* A freed object is reused, and zeroed again */
+	memset(ptr1, 0xff, 40);
+	dm_slab_free(ptr1, 40);
+	ut_asserteq_ptr(ptr1, dm_slab_alloc(48));
+	ut_asserteq(0, ptr1[0]);
+	dm_slab_free(ptr1, 48);
+	dm_slab_free(ptr2, 44);
+	dm_slab_free(large, DM_SLAB_MAX_SIZE + 1);
+
+	dm_slab_get_stats(&stats);
+	ut_asserteq(before.allocs, stats.allocs);
+	ut_asserteq(before.req_bytes, stats.req_bytes);
+	ut_asserteq(before.large_allocs, stats.large_allocs);
+
+	return 0;
+}
+DM_TEST(dm_test_slab_alloc, 0);
+
+/* Bind the devices in the device tree and probe the test ones */
+static int slab_bind_probe(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+	uclass_foreach_dev_probe(UCLASS_TEST_FDT, dev)
+		;
+
+	return 0;
+}
+
+/* Test that binding and probing devices uses the slabs, and show the result */
+static int dm_test_slab_devices(struct unit_test_state *uts)
+{
+	struct dm_slab_stats before, stats;
+
+	/* The first time, the uclasses are created as well */
+	ut_assertok(slab_bind_probe(uts));
+	ut_assertok(device_chld_remove(dm_root(), NULL, DM_REMOVE_NORMAL));
+	ut_assertok(device_chld_unbind(dm_root(), NULL));
+
+	dm_slab_get_stats(&before);
+	ut_assertok(slab_bind_probe(uts));
+	dm_slab_get_stats(&stats);
+	ut_assert(stats.allocs > before.allocs);
+	ut_assert(stats.req_bytes > before.req_bytes);
+	ut_assert(stats.malloc_bytes > stats.req_bytes);
+	dm_dump_mem();
+
+	/* Everything allocated for the devices is given back */
+	ut_assertok(device_chld_remove(dm_root(), NULL, DM_REMOVE_NORMAL));
+	ut_assertok(device_chld_unbind(dm_root(), NULL));
+	dm_slab_get_stats(&stats);
+	ut_asserteq(before.allocs, stats.allocs);
+	ut_asserteq(before.req_bytes, stats.req_bytes);
+	ut_asserteq(before.large_allocs, stats.large_allocs);
+
+	return 0;
+}
+DM_TEST(dm_test_slab_devices, 0);
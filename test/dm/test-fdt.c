@@ -264,6 +264,82 @@ static int dm_test_fdt_pre_reloc(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdt_pre_reloc, 0);
 
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/* Number of times to bind the tree, to get a measurable time */
+#define COMPAT_TEST_LOOPS	20
+#define COMPAT_TEST_MAX_DEVS	256
+
+/* Record the driver of each device, in order */
+static int compat_test_get_drivers(struct udevice *parent,
+				   const struct driver **drvs, int count)
+{
+	struct udevice *dev;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if (count < COMPAT_TEST_MAX_DEVS)
+			drvs[count++] = dev->driver;
+		count = compat_test_get_drivers(dev, drvs, count);
+	}
+
+	return count;
+}
+
+static int compat_test_bind(struct unit_test_state *uts,
+			    const struct driver **drvs, int *countp,
+			    ulong *timep)
+{
+	struct udevice *root = dm_root();
+	ulong start;
+	int i;
+
+	*timep = 0;
+	for (i = 0; i < COMPAT_TEST_LOOPS; i++) {
+		start = timer_get_us();
+		ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+		*timep += timer_get_us() - start;
+		*countp = compat_test_get_drivers(root, drvs, 0);
+		ut_assertok(device_chld_remove(root, NULL, DM_REMOVE_NORMAL));
+		ut_assertok(device_chld_unbind(root, NULL));
+	}
+
+	return 0;
+}
+
+/* Test that the index of compatible strings binds the same drivers */
+static int dm_test_fdt_compat_index(struct unit_test_state *uts)
+{
+	const struct driver *drvs_without[COMPAT_TEST_MAX_DEVS];
+	const struct driver *drvs_with[COMPAT_TEST_MAX_DEVS];
+	int count_without, count_with;
+	ulong time_without, time_with;
+
+	/* Make sure each node is looked up in the index */
+#if CONFIG_IS_ENABLED(OF_DEVTAB)
+	lists_devtab_set_enabled(false);
+#endif
+	lists_compat_index_set_enabled(false);
+	ut_assertok(compat_test_bind(uts, drvs_without, &count_without,
+				     &time_without));
+
+	lists_compat_index_set_enabled(true);
+	ut_assertok(compat_test_bind(uts, drvs_with, &count_with, &time_with));
+#if CONFIG_IS_ENABLED(OF_DEVTAB)
+	lists_devtab_set_enabled(true);
+#endif
+
+	ut_asserteq(count_without, count_with);
+	ut_asserteq_mem(drvs_without, drvs_with,
+			min(count_with, COMPAT_TEST_MAX_DEVS) *
+			sizeof(struct driver *));
+	printf("%d devices: bind %ldus searching drivers, %ldus with index\n",
+	       count_with, time_without / COMPAT_TEST_LOOPS,
+	       time_with / COMPAT_TEST_LOOPS);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_compat_index, 0);
+#endif
+
 /* Test that sequence numbers are allocated properly */
 static int dm_test_fdt_uclass_seq(struct unit_test_state *uts)
 {
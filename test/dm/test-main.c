@@ -20,13 +20,24 @@ DECLARE_GLOBAL_DATA_PTR;
 struct unit_test_state global_dm_test_state;
 static struct dm_test_state _global_priv_dm_test_state;
 
+/* Drop the driver model root, so that dm_init() can start again */
+static void dm_test_drop_root(void)
+{
+	gd->dm_root = NULL;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/* dm_init() allocates a new one */
+	free(gd->uclass_index);
+	gd->uclass_index = NULL;
+#endif
+}
+
 /* Get ready for testing */
 static int dm_test_init(struct unit_test_state *uts, bool of_live)
 {
 	struct dm_test_state *dms = uts->priv;
 
 	memset(dms, '\0', sizeof(*dms));
-	gd->dm_root = NULL;
+	dm_test_drop_root();
 	memset(dm_testdrv_op_count, '\0', sizeof(dm_testdrv_op_count));
 	state_reset_for_test(state_get_current());
 
@@ -100,6 +111,7 @@ static int dm_do_test(struct unit_test_state *uts, struct unit_test *test,
 	console_record_reset();
 	if (!state->show_test_output)
 		gd->flags |= GD_FLG_SILENT;
+	ut_leak_start(uts);
 	test->func(uts);
 	gd->flags &= ~GD_FLG_SILENT;
 	state_set_skip_delays(false);
@@ -188,7 +200,7 @@ static int dm_test_main(const char *test_name)
 	else
 		printf("Failures: %d\n", uts->fail_count);
 
-	gd->dm_root = NULL;
+	dm_test_drop_root();
 	ut_assertok(dm_init(false));
 	dm_scan_platdata(false);
 	dm_scan_fdt(gd->fdt_blob, false);
@@ -123,3 +123,148 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Add many more entries than the table was created for */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 100));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 100));
+	ut_asserteq(SIZE * 100, htab.filled);
+	ut_assert(htab.size > SIZE * 100);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Export must be sorted by key whatever order the entries were added in */
+static int env_test_htab_export_sorted(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	char *res = NULL, *p, *prev;
+	ENTRY item, *ritem;
+	char key[20];
+	int i, count;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	/* Some entries, exported once so that they are sorted */
+	for (i = 0; i < SIZE * 4; i++) {
+		sprintf(key, "%d", (i * 7919) % (SIZE * 4));
+		item.callback = NULL;
+		item.data = key;
+		item.flags = 0;
+		item.key = key;
+		ut_asserteq(1, hsearch_r(item, ENTER, &ritem, &htab, 0));
+	}
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	free(res);
+	res = NULL;
+
+	/* Then add more out of order, and delete a few */
+	for (i = SIZE * 8; i > SIZE * 4; i--) {
+		sprintf(key, "%d", i);
+		item.data = key;
+		ut_asserteq(1, hsearch_r(item, ENTER, &ritem, &htab, 0));
+	}
+	ut_asserteq(1, hdelete_r("0", &htab, 0));
+	ut_asserteq(1, hdelete_r("100", &htab, 0));
+
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	for (p = res, prev = NULL, count = 0; *p; count++) {
+		char *end = strchr(p, '\n');
+		char *eq = strchr(p, '=');
+
+		ut_assertnonnull(end);
+		ut_assertnonnull(eq);
+		ut_assert(eq < end);
+		*end = '\0';
+		/* Only the key is sorted: "1=1" comes before "10=10" */
+		*eq = '\0';
+		if (prev)
+			ut_assert(strcmp(prev, p) < 0);
+		prev = p;
+		p = end + 1;
+	}
+	ut_asserteq(SIZE * 8 - 2, count);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export_sorted, 0);
+
+/*
+ * Time adding, finding, exporting and importing a large number of
+ * variables, as a provisioning environment might have
+ */
+static int htab_perf(struct unit_test_state *uts, int count)
+{
+	ulong start, add_us, find_us, export_us, import_us;
+	struct hsearch_data htab;
+	char *res = NULL;
+	ENTRY item, *ritem;
+	char key[30];
+	ssize_t len;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = key;
+	item.data = key;
+	start = timer_get_us();
+	for (i = 0; i < count; i++) {
+		/* Not in order, so that export has something to sort */
+		sprintf(key, "provision_var_%06d", (i * 7919) % count);
+		ut_asserteq(1, hsearch_r(item, ENTER, &ritem, &htab, 0));
+	}
+	add_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < count; i++) {
+		sprintf(key, "provision_var_%06d", i);
+		hsearch_r(item, FIND, &ritem, &htab, 0);
+		ut_assertnonnull(ritem);
+	}
+	find_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	len = hexport_r(&htab, '\0', 0, &res, 0, 0, NULL);
+	export_us = timer_get_us() - start;
+	ut_assert(len > 0);
+
+	start = timer_get_us();
+	ut_asserteq(1, himport_r(&htab, res, len, '\0', 0, 0, 0, NULL));
+	import_us = timer_get_us() - start;
+	ut_asserteq(count, htab.filled);
+	free(res);
+
+	printf("%6d variables: add %lu ms, find %lu ms, export %lu ms, import %lu ms\n",
+	       count, add_us / 1000, find_us / 1000, export_us / 1000,
+	       import_us / 1000);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+/* Two sizes show how the time grows, while keeping 'ut env' quick */
+static int env_test_htab_perf(struct unit_test_state *uts)
+{
+	ut_assertok(htab_perf(uts, 1000));
+	ut_assertok(htab_perf(uts, 10000));
+
+	return 0;
+}
+
+ENV_TEST(env_test_htab_perf, 0);
@@ -18,8 +18,12 @@
 # fs-test.sb.fat32	Summary: PASS: 24 FAIL: 0
 # fs-test.nonfs.fat32	Summary: PASS: 24 FAIL: 0
 # fs-test.fs.fat32	Summary: PASS: 24 FAIL: 0
+# Each file system also gets a read benchmark of a contiguous and a fragmented
+# file, which reports throughput and checks the number of reads issued to the
+# block device:
+# fs-test.bench.<fs>	Summary: PASS: 6 FAIL: 0
 # --------------------------------------------
-# Total Summary: TOTAL PASS: 216 TOTAL FAIL: 0
+# Total Summary: TOTAL PASS: 234 TOTAL FAIL: 0
 # --------------------------------------------
 
 # pre-requisite binaries list.
@@ -44,6 +48,12 @@ SMALL_FILE="1MB.file"
 # $BIG_FILE is the name of the 2.5GB file in the file system image
 BIG_FILE="2.5GB.file"
 
+# $BENCH_FILE is the name of the 32MB file used to benchmark reads
+BENCH_FILE="32MB.file"
+
+# $FRAG_FILE is the name of the 8MB fragmented file used to benchmark reads
+FRAG_FILE="8MB.frag"
+
 # $MD5_FILE will have the expected md5s when we do the test
 # They shall have a suffix which represents their file system (ext4/fat16/...)
 MD5_FILE="${OUT_DIR}/md5s.list"
@@ -54,6 +64,8 @@ OUT="${OUT_DIR}/fs-test"
 # Full Path of the 1 MB file that shall be created in the fs image.
 MB1="${MOUNT_DIR}/${SMALL_FILE}"
 GB2p5="${MOUNT_DIR}/${BIG_FILE}"
+MB32="${MOUNT_DIR}/${BENCH_FILE}"
+MB8="${MOUNT_DIR}/${FRAG_FILE}"
 
 # ************************
 # * Functions start here *
@@ -375,6 +387,26 @@ function create_files() {
 			&> /dev/null
 	fi
 
+	# Create a file for the read benchmark, written in one go so that it
+	# is as contiguous as the file system allows.
+	if [ ! -f "${MB32}" ]; then
+		sudo dd if=/dev/urandom of="${MB32}" bs=1M count=32 \
+			&> /dev/null
+	fi
+
+	# Create a fragmented file for the read benchmark, by appending to it
+	# and to a filler file in turn, 64KB at a time.
+	if [ ! -f "${MB8}" ]; then
+		for i in `seq 128`; do
+			sudo dd if=/dev/urandom of="${MB8}" bs=64K count=1 \
+				oflag=append conv=notrunc &> /dev/null
+			sync
+			sudo dd if=/dev/urandom of="${MB8}.fill" bs=64K \
+				count=1 oflag=append conv=notrunc &> /dev/null
+			sync
+		done
+	fi
+
 	# Delete the small file copies which possibly are written as part of a
 	# previous test.
 	sudo rm -f "${MB1}.w"
@@ -404,11 +436,68 @@ function create_files() {
 	dd if="${GB2p5}" bs=512K skip=4095 count=2 \
 		2> /dev/null | md5sum >> "$2"
 
+	# The whole benchmark file
+	md5sum < "${MB32}" >> "$2"
+
+	# The whole fragmented benchmark file
+	md5sum < "${MB8}" >> "$2"
+
 	sync
 	sudo umount "$MOUNT_DIR"
 	rmdir "$MOUNT_DIR"
 }
 
+# 1st parameter is image file
+# 2nd parameter is the list of files to read
+# UBOOT is set in env
+# Reads each file with the generic load command, with the block cache
+# statistics reset just before, so that the number of device reads can be
+# reported afterwards.
+function bench_image() {
+	addr="0x01000008"
+
+	(
+	echo "host bind 0 $1"
+	for file in $2; do
+		echo "blkcache show"
+		echo "# Benchmark $file"
+		echo "load host 0:0 $addr /$file"
+		echo "printenv filesize"
+		echo "# Benchmark md5 $file"
+		echo "md5sum $addr \$filesize"
+		echo "setenv filesize"
+		echo "# Benchmark stats $file"
+		echo "blkcache show"
+	done
+	echo "reset"
+	) | $UBOOT
+}
+
+# 1st parameter is the name of the output file to check
+# 2nd parameter is the name of the file containing the md5 expected
+# 3rd parameter is the name of the benchmark file
+# 4th parameter is the line # of its md5 in the md5 file
+# 5th parameter is its size in hex
+# 6th parameter is the most block device reads the load may take
+# Checks that the file was read correctly and in few enough device reads, and
+# prints the throughput.
+function check_bench() {
+	grep -A4 "Benchmark $3" "$1" | grep -q "filesize=$5"
+	pass_fail "Bench: load of $3 size"
+	check_md5 "Benchmark md5 $3" "$1" "$2" $4 "Bench: load of $3"
+
+	rate=`grep -A3 "Benchmark $3" "$1" | grep -o "read in .*" | \
+		tr -d '\r'`
+	reads=`grep -A12 "Benchmark stats $3" "$1" | grep "device reads:" | \
+		tr -d '\r'`
+	misses=`grep -A3 "Benchmark stats $3" "$1" | grep "misses:" | \
+		tr -d '\r'`
+	echo "bench - $3: $rate, ${reads##* } device reads," \
+		"${misses##* } blocks not in cache"
+	[ -n "${reads##* }" ] && [ "${reads##* }" -le $6 ]
+	pass_fail "Bench: load of $3 in at most $6 device reads"
+}
+
 # 1st parameter is the text to print
 # if $? is 0 its a pass, else a fail
 # As a side effect it shall update env variable PASS and FAIL
@@ -614,6 +703,19 @@ for fs in ext4 fat16 fat32; do
 
 	test_fs_nonfs nonfs
 	test_fs_nonfs fs
+
+	OUT_FILE="${OUT}.bench.${fs}.out"
+	bench_image $IMAGE "$BENCH_FILE $FRAG_FILE" > ${OUT_FILE} 2>&1
+	echo "** Start $OUT_FILE"
+	PASS=0
+	FAIL=0
+	check_bench $OUT_FILE $MD5_FILE_FS $BENCH_FILE 7 2000000 2048
+	check_bench $OUT_FILE $MD5_FILE_FS $FRAG_FILE 8 800000 512
+	echo "** End $OUT_FILE"
+	TOTAL_FAIL=$((TOTAL_FAIL + FAIL))
+	TOTAL_PASS=$((TOTAL_PASS + PASS))
+	echo "Summary: PASS: $PASS FAIL: $FAIL"
+	echo "--------------------------------------------"
 done
 
 echo "Total Summary: TOTAL PASS: $TOTAL_PASS TOTAL FAIL: $TOTAL_FAIL"
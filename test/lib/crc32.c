@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests and benchmark for crc32()
+ *
+ * The slice-by-8 implementation runs through different lines of code
+ * depending on the alignment and length of the buffer, so both are swept.
+ */
+
+#include <common.h>
+#include <mapmem.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of different alignment values */
+#define SWEEP 8
+/* Check lengths up to this many bytes */
+#define MAXLEN 100
+
+/* Bit-at-a-time CRC32, to check the table-driven code against */
+static u32 crc32_bitwise(u32 crc, const u8 *p, uint len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+static int lib_crc32(struct unit_test_state *uts)
+{
+	u8 buf[SWEEP + MAXLEN];
+	int offset, len, i;
+
+	ut_asserteq(0xcbf43926, crc32(0, (const u8 *)"123456789", 9));
+	ut_asserteq(0, crc32(0, buf, 0));
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	for (offset = 0; offset < SWEEP; offset++) {
+		for (len = 0; len <= MAXLEN; len++) {
+			ut_asserteq(crc32_bitwise(0x12345678, buf + offset, len),
+				    crc32(0x12345678, buf + offset, len));
+			ut_asserteq(crc32_bitwise(0x12345678, buf + offset, len),
+				    crc32_bytewise(0x12345678, buf + offset,
+						   len));
+		}
+	}
+
+	/* Split in two calls, the CRC carries over */
+	ut_asserteq(crc32(0, buf, MAXLEN),
+		    crc32(crc32(0, buf, 13), buf + 13, MAXLEN - 13));
+
+	return 0;
+}
+
+LIB_TEST(lib_crc32, 0);
+
+/* Largest buffer, and the least checksummed for each buffer size */
+#define BENCH_SIZE	SZ_64M
+#define BENCH_TOTAL	SZ_16M
+
+/*
+ * Report crc32() throughput for buffers from 64 bytes to 64MiB. Each size is
+ * repeated until 16MiB, or the whole buffer, have been checksummed. The data
+ * is whatever is in RAM from address 0, since only the speed matters.
+ */
+static int lib_crc32_bench(struct unit_test_state *uts)
+{
+	ulong max = min_t(ulong, BENCH_SIZE, gd->ram_size);
+	ulong size, done, start, us;
+	const u8 *buf;
+	u32 crc = 0;
+
+	buf = map_sysmem(0, max);
+	for (size = 64; size <= max; size <<= 2) {
+		start = timer_get_us();
+		for (done = 0; done < max_t(ulong, size, BENCH_TOTAL);
+		     done += size)
+			crc = crc32(crc, buf, size);
+		us = timer_get_us() - start;
+		printf("crc32: %9lu bytes: %5lu MB/s\n", size,
+		       us ? (ulong)(done / us) : 0);
+	}
+	unmap_sysmem(buf);
+	debug("crc32: %08x\n", crc);
+
+	return 0;
+}
+
+LIB_TEST(lib_crc32_bench, 0);
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for hash_block_multi() and a benchmark of FIT verification
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+static const char *const algos[] = { "crc32", "sha1", "sha256" };
+
+/* Check hash_block_multi() against hash_block() for a buffer */
+static int check_multi(struct unit_test_state *uts, const void *buf, uint len)
+{
+	uint8_t sum[ARRAY_SIZE(algos)][HASH_MAX_DIGEST_SIZE];
+	uint8_t expect[HASH_MAX_DIGEST_SIZE];
+	uint8_t *outputs[ARRAY_SIZE(algos)];
+	int sizes[ARRAY_SIZE(algos)];
+	int i, size;
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++)
+		outputs[i] = sum[i];
+	ut_assertok(hash_block_multi(algos, ARRAY_SIZE(algos), buf, len,
+				     outputs, sizes));
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		size = sizeof(expect);
+		ut_assertok(hash_block(algos[i], buf, len, expect, &size));
+		ut_asserteq(size, sizes[i]);
+		ut_asserteq_mem(expect, sum[i], size);
+	}
+
+	return 0;
+}
+
+static int lib_hash_multi(struct unit_test_state *uts)
+{
+	const char *const bad[] = { "sha1", "nonesuch" };
+	const char *const many[HASH_MULTI_MAX + 1] = { "crc32" };
+	uint8_t sum[HASH_MAX_DIGEST_SIZE];
+	uint8_t *outputs[] = { sum, sum };
+	const uint lens[] = {
+		0, 1, 63, 64, 65, HASH_MULTI_CHUNK - 1, HASH_MULTI_CHUNK,
+		HASH_MULTI_CHUNK + 1, HASH_MULTI_CHUNK * 3 + 100,
+	};
+	uint max = HASH_MULTI_CHUNK * 4;
+	u8 *buf;
+	int i;
+
+	buf = map_sysmem(0, max);
+	for (i = 0; i < max; i++)
+		buf[i] = i * 37 + 11;
+
+	/* Lengths on and around the chunk boundaries */
+	for (i = 0; i < ARRAY_SIZE(lens); i++)
+		ut_assertok(check_multi(uts, buf, lens[i]));
+	ut_assertok(check_multi(uts, buf + 1, max - 1));
+	unmap_sysmem(buf);
+
+	ut_asserteq(-EPROTONOSUPPORT,
+		    hash_block_multi(bad, ARRAY_SIZE(bad), "abc", 3, outputs,
+				     NULL));
+	ut_asserteq(-EINVAL,
+		    hash_block_multi(many, ARRAY_SIZE(many), "abc", 3, outputs,
+				     NULL));
+
+	return 0;
+}
+
+LIB_TEST(lib_hash_multi, 0);
+
+#if CONFIG_IS_ENABLED(FIT)
+/* Size of the image in the benchmark FIT, large enough to time */
+#define FIT_BENCH_SIZE	SZ_4M
+
+/*
+ * Set up a FIT with a single image of @size bytes, which has a crc32, sha1
+ * and sha256 hash node. Returns the image node offset, or -ve on error.
+ */
+static int setup_fit(struct unit_test_state *uts, void *fit, int fit_size,
+		     const void *data, int size)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int images, node, hash;
+	char name[20];
+	int i, len;
+
+	ut_assertok(fdt_create_empty_tree(fit, fit_size));
+	images = fdt_add_subnode(fit, 0, "images");
+	ut_assert(images >= 0);
+	node = fdt_add_subnode(fit, images, "kernel");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop(fit, node, FIT_DATA_PROP, data, size));
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		snprintf(name, sizeof(name), "%s-%d", FIT_HASH_NODENAME, i + 1);
+		hash = fdt_add_subnode(fit, node, name);
+		ut_assert(hash >= 0);
+		ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP,
+					       algos[i]));
+		ut_assertok(calculate_hash(data, size, algos[i], value, &len));
+		ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value,
+					len));
+	}
+
+	return fdt_path_offset(fit, FIT_IMAGES_PATH "/kernel");
+}
+
+/*
+ * Time the verification of a FIT image with crc32, sha1 and sha256 hash
+ * nodes. Also time the hashes being calculated once per node, as
+ * fit_image_verify() does by default, and in one pass with
+ * hash_block_multi(), as it does with CONFIG_FIT_MULTI_HASH.
+ */
+static int lib_hash_fit_bench(struct unit_test_state *uts)
+{
+	uint8_t sum[ARRAY_SIZE(algos)][HASH_MAX_DIGEST_SIZE];
+	uint8_t *outputs[ARRAY_SIZE(algos)];
+	int fit_size = FIT_BENCH_SIZE + SZ_4K;
+	ulong start, verify, separate, multi;
+	const void *data;
+	size_t size;
+	u8 *buf, *fit;
+	int i, len, noffset;
+
+	buf = malloc(FIT_BENCH_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < FIT_BENCH_SIZE; i++)
+		buf[i] = i * 37 + 11;
+	fit = malloc(fit_size);
+	ut_assertnonnull(fit);
+	noffset = setup_fit(uts, fit, fit_size, buf, FIT_BENCH_SIZE);
+	free(buf);
+	ut_assert(noffset >= 0);
+	ut_assertok(fit_image_get_data_and_size(fit, noffset, &data, &size));
+	ut_asserteq(FIT_BENCH_SIZE, size);
+
+	start = timer_get_us();
+	ut_asserteq(1, fit_image_verify(fit, noffset));
+	verify = timer_get_us() - start;
+	printf("\n");
+
+	start = timer_get_us();
+	for (i = 0; i < ARRAY_SIZE(algos); i++)
+		ut_assertok(calculate_hash(data, size, algos[i], sum[i], &len));
+	separate = timer_get_us() - start;
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++)
+		outputs[i] = sum[i];
+	start = timer_get_us();
+	ut_assertok(hash_block_multi(algos, ARRAY_SIZE(algos), data, size,
+				     outputs, NULL));
+	multi = timer_get_us() - start;
+
+	printf("fit: %zu bytes, crc32+sha1+sha256: verify %lu us, separate %lu us, one pass %lu us\n",
+	       size, verify, separate, multi);
+
+	/* A corrupted image must still fail, whichever way it is hashed */
+	((u8 *)data)[size / 2] ^= 1;
+	ut_asserteq(0, fit_image_verify(fit, noffset));
+	free(fit);
+
+	return 0;
+}
+
+LIB_TEST(lib_hash_fit_bench, 0);
+#endif
@@ -17,22 +17,22 @@ static int check_lmb(struct unit_test_state *uts, struct lmb *lmb,
 {
 	if (ram_size) {
 		ut_asserteq(lmb->memory.cnt, 1);
-		ut_asserteq(lmb->memory.region[0].base, ram_base);
-		ut_asserteq(lmb->memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb->memory)[0].base, ram_base);
+		ut_asserteq(lmb_regions(&lmb->memory)[0].size, ram_size);
 	}
 
 	ut_asserteq(lmb->reserved.cnt, num_reserved);
 	if (num_reserved > 0) {
-		ut_asserteq(lmb->reserved.region[0].base, base1);
-		ut_asserteq(lmb->reserved.region[0].size, size1);
+		ut_asserteq(lmb_regions(&lmb->reserved)[0].base, base1);
+		ut_asserteq(lmb_regions(&lmb->reserved)[0].size, size1);
 	}
 	if (num_reserved > 1) {
-		ut_asserteq(lmb->reserved.region[1].base, base2);
-		ut_asserteq(lmb->reserved.region[1].size, size2);
+		ut_asserteq(lmb_regions(&lmb->reserved)[1].base, base2);
+		ut_asserteq(lmb_regions(&lmb->reserved)[1].size, size2);
 	}
 	if (num_reserved > 2) {
-		ut_asserteq(lmb->reserved.region[2].base, base3);
-		ut_asserteq(lmb->reserved.region[2].size, size3);
+		ut_asserteq(lmb_regions(&lmb->reserved)[2].base, base3);
+		ut_asserteq(lmb_regions(&lmb->reserved)[2].size, size3);
 	}
 	return 0;
 }
@@ -78,14 +78,14 @@ static int test_multi_alloc(struct unit_test_state *uts, const phys_addr_t ram,
 
 	if (ram0_size) {
 		ut_asserteq(lmb.memory.cnt, 2);
-		ut_asserteq(lmb.memory.region[0].base, ram0);
-		ut_asserteq(lmb.memory.region[0].size, ram0_size);
-		ut_asserteq(lmb.memory.region[1].base, ram);
-		ut_asserteq(lmb.memory.region[1].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram0);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram0_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].size, ram_size);
 	} else {
 		ut_asserteq(lmb.memory.cnt, 1);
-		ut_asserteq(lmb.memory.region[0].base, ram);
-		ut_asserteq(lmb.memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram_size);
 	}
 
 	/* reserve 64KiB somewhere */
@@ -156,14 +156,14 @@ static int test_multi_alloc(struct unit_test_state *uts, const phys_addr_t ram,
 
 	if (ram0_size) {
 		ut_asserteq(lmb.memory.cnt, 2);
-		ut_asserteq(lmb.memory.region[0].base, ram0);
-		ut_asserteq(lmb.memory.region[0].size, ram0_size);
-		ut_asserteq(lmb.memory.region[1].base, ram);
-		ut_asserteq(lmb.memory.region[1].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram0);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram0_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].size, ram_size);
 	} else {
 		ut_asserteq(lmb.memory.cnt, 1);
-		ut_asserteq(lmb.memory.region[0].base, ram);
-		ut_asserteq(lmb.memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram_size);
 	}
 
 	return 0;
@@ -655,3 +655,227 @@ static int lib_test_lmb_get_free_size(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_get_free_size,
 	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Reserve many more regions than fit in struct lmb, then allocate in the gaps
+ * between them and free everything again
+ */
+static int test_many_regions(struct unit_test_state *uts, const phys_addr_t ram)
+{
+	const phys_size_t ram_size = 0x20000000;
+	const phys_addr_t ram_end = ram + ram_size;
+	const int count = 1000;
+	const phys_size_t step = 0x10000;
+	struct lmb lmb;
+	phys_addr_t a;
+	long ret;
+	int i;
+
+	/* check for overflow */
+	ut_assert(ram_end == 0 || ram_end > ram);
+
+	lmb_init(&lmb);
+
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+
+	/* reserve the first 4KiB of each 64KiB block, working downwards */
+	for (i = count - 1; i >= 0; i--) {
+		ret = lmb_reserve(&lmb, ram + i * step, 0x1000);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, count);
+	ut_assert(lmb.reserved.max >= count);
+	for (i = 0; i < count; i++) {
+		ut_asserteq(lmb_regions(&lmb.reserved)[i].base, ram + i * step);
+		ut_asserteq(lmb_regions(&lmb.reserved)[i].size, 0x1000);
+	}
+
+	ut_asserteq(1, lmb_is_reserved(&lmb, ram + 500 * step + 0xfff));
+	ut_asserteq(0, lmb_is_reserved(&lmb, ram + 500 * step + 0x1000));
+	ut_asserteq(step - 0x1000,
+		    lmb_get_free_size(&lmb, ram + 500 * step + 0x1000));
+	ut_asserteq(0, lmb_get_free_size(&lmb, ram + 500 * step));
+
+	/* a block too large for any gap goes above the reserved regions */
+	a = lmb_alloc(&lmb, step, 1);
+	ut_asserteq(a, ram_end - step);
+	ret = lmb_free(&lmb, a, step);
+	ut_asserteq(ret, 0);
+
+	/* this fits in the gap below the highest reserved region */
+	a = lmb_alloc_base(&lmb, step - 0x1000, 1,
+			   ram + (count - 1) * step + 0x800);
+	ut_asserteq(a, ram + (count - 2) * step + 0x1000);
+	ut_asserteq(lmb.reserved.cnt, count - 1);
+
+	/* fill the remaining gaps from the bottom, joining the regions */
+	for (i = 0; i < count - 2; i++) {
+		a = lmb_alloc_addr(&lmb, ram + i * step + 0x1000,
+				   step - 0x1000);
+		ut_asserteq(a, ram + i * step + 0x1000);
+	}
+	ut_asserteq(lmb.reserved.cnt, 1);
+	ut_asserteq(lmb_regions(&lmb.reserved)[0].base, ram);
+	ut_asserteq(lmb_regions(&lmb.reserved)[0].size,
+		    (count - 1) * step + 0x1000);
+
+	/* punch holes back in, splitting the region each time */
+	for (i = 0; i < count - 1; i++) {
+		ret = lmb_free(&lmb, ram + i * step + 0x1000, step - 0x1000);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, count);
+
+	for (i = 0; i < count; i++) {
+		ret = lmb_free(&lmb, ram + i * step, 0x1000);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, 0);
+
+	lmb_uninit(&lmb);
+	ut_assertnull(lmb.reserved.grown);
+	ut_assert_noleaks();
+
+	return 0;
+}
+
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	int ret;
+
+	/* simulate 512 MiB RAM beginning at 1GiB */
+	ret = test_many_regions(uts, 0x40000000);
+	if (ret)
+		return ret;
+
+	/* simulate 512 MiB RAM beginning at 1.5GiB */
+	return test_many_regions(uts, 0xE0000000);
+}
+
+DM_TEST(lib_test_lmb_many_regions, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Add many memory banks and check that allocations come from the top one */
+static int lib_test_lmb_many_banks(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t bank_size = 0x100000;
+	const int count = 64;
+	struct lmb lmb;
+	phys_addr_t a;
+	long ret;
+	int i;
+
+	lmb_init(&lmb);
+
+	/* add banks with a gap after each, out of order */
+	for (i = 0; i < count; i++) {
+		ret = lmb_add(&lmb, ram + ((i * 7) % count) * 2 * bank_size,
+			      bank_size);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.memory.cnt, count);
+	for (i = 0; i < count; i++)
+		ut_asserteq(lmb_regions(&lmb.memory)[i].base,
+			    ram + i * 2 * bank_size);
+
+	/* the top bank is used first, then the next one down */
+	a = lmb_alloc(&lmb, bank_size, 1);
+	ut_asserteq(a, ram + (count - 1) * 2 * bank_size);
+	a = lmb_alloc(&lmb, bank_size / 2, 1);
+	ut_asserteq(a, ram + (count - 2) * 2 * bank_size + bank_size / 2);
+
+	/* nothing can be allocated across a gap between banks */
+	a = lmb_alloc_addr(&lmb, ram + bank_size / 2, bank_size);
+	ut_asserteq(a, 0);
+	ut_asserteq(0, lmb_get_free_size(&lmb, ram + bank_size));
+
+	lmb_uninit(&lmb);
+	ut_assert_noleaks();
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_many_banks, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Check that an lmb can be copied by value and used from zeroed memory */
+static int lib_test_lmb_copy(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	struct lmb lmb, copy;
+	long ret;
+
+	memset(&lmb, '\0', sizeof(lmb));
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+	ret = lmb_reserve(&lmb, ram + 0x1000, 0x1000);
+	ut_asserteq(ret, 0);
+
+	copy = lmb;
+	ret = lmb_reserve(&copy, ram + 0x10000, 0x1000);
+	ut_asserteq(ret, 0);
+	ut_asserteq(copy.reserved.cnt, 2);
+	ut_asserteq(lmb_regions(&copy.reserved)[1].base, ram + 0x10000);
+	ut_asserteq(1, lmb_is_reserved(&copy, ram + 0x1000));
+
+	/* the original is not changed by the copy */
+	ut_asserteq(lmb.reserved.cnt, 1);
+	ut_asserteq(0, lmb_is_reserved(&lmb, ram + 0x10000));
+	lmb_uninit(&copy);
+	lmb_uninit(&lmb);
+	ut_assert_noleaks();
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_copy, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Report the time taken per operation with an increasing number of reserved
+ * regions. Since regions are found by bisection, this should grow only
+ * slowly with the number of regions.
+ */
+static int lib_test_lmb_bench(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t step = 0x10000;
+	struct lmb lmb;
+	ulong start, reserve_us, lookup_us, alloc_us;
+	phys_addr_t a;
+	int count, i;
+
+	for (count = 10; count <= 10000; count *= 10) {
+		lmb_init(&lmb);
+		ut_asserteq(0, lmb_add(&lmb, ram, count * step));
+
+		start = timer_get_us();
+		for (i = 0; i < count; i++)
+			ut_asserteq(0, lmb_reserve(&lmb, ram + i * step, 0x1000));
+		reserve_us = timer_get_us() - start;
+
+		start = timer_get_us();
+		for (i = 0; i < count; i++)
+			ut_asserteq(0, lmb_is_reserved(&lmb,
+						       ram + i * step + 0x1000));
+		lookup_us = timer_get_us() - start;
+
+		/* each allocation fills the highest gap */
+		start = timer_get_us();
+		for (i = 0; i < count; i++) {
+			a = lmb_alloc(&lmb, step - 0x1000, 0x1000);
+			ut_asserteq(a, ram + (count - 1 - i) * step + 0x1000);
+		}
+		alloc_us = timer_get_us() - start;
+
+		printf("lmb: %5d regions: reserve %5lu ns, lookup %5lu ns, alloc %5lu ns\n",
+		       count, reserve_us * 1000 / count,
+		       lookup_us * 1000 / count, alloc_us * 1000 / count);
+		lmb_uninit(&lmb);
+	}
+	ut_assert_noleaks();
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the statistics kept about malloc() use
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <malloc_stats.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test that allocations and frees are counted */
+static int lib_malloc_stats(struct unit_test_state *uts)
+{
+	struct malloc_info before, info;
+	ulong size;
+	void *ptr, *ptr2;
+
+	malloc_get_info(&before);
+	ut_assert(before.heap_size > 0);
+
+	/* A 100-byte block is in the bucket for blocks up to 128 bytes */
+	ptr = malloc(100);
+	ut_assertnonnull(ptr);
+	size = malloc_usable_size(ptr);
+	ut_assert(size >= 100);
+	malloc_get_info(&info);
+	ut_asserteq(before.count + 1, info.count);
+	ut_asserteq(before.allocs + 1, info.allocs);
+	ut_asserteq(before.in_use + size, info.in_use);
+	ut_assert(info.peak >= info.in_use);
+	ut_asserteq(128, malloc_stats_bucket_size(3));
+	ut_asserteq(before.bucket_count[3] + 1, info.bucket_count[3]);
+
+	/* Growing a block counts as freeing it and allocating a new one */
+	ptr = realloc(ptr, 3000);
+	ut_assertnonnull(ptr);
+	malloc_get_info(&info);
+	ut_asserteq(before.count + 1, info.count);
+	ut_asserteq(before.in_use + malloc_usable_size(ptr), info.in_use);
+	ut_asserteq(before.bucket_count[3], info.bucket_count[3]);
+
+	ptr2 = memalign(ARCH_DMA_MINALIGN, 40);
+	ut_assertnonnull(ptr2);
+	malloc_get_info(&info);
+	ut_asserteq(before.count + 2, info.count);
+	free(ptr2);
+	free(ptr);
+
+	malloc_get_info(&info);
+	ut_asserteq(before.count, info.count);
+	ut_asserteq(before.in_use, info.in_use);
+	ut_asserteq(before.frees + 3, info.frees);
+	ut_assert(info.peak >= before.in_use + size);
+
+	/* A request larger than the heap fails */
+	size = before.heap_size * 2;
+	ut_assertnull(malloc(size));
+	malloc_get_info(&info);
+	ut_asserteq(before.failures + 1, info.failures);
+	ut_assert(info.largest_failure >= size);
+	ut_asserteq(before.count, info.count);
+
+	malloc_reset_peak();
+	malloc_get_info(&info);
+	ut_asserteq(info.in_use, info.peak);
+
+	return 0;
+}
+
+LIB_TEST(lib_malloc_stats, 0);
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+/* Test that blocks which are not freed are found, with their caller */
+static int lib_malloc_leaks(struct unit_test_state *uts)
+{
+	struct malloc_leak leaks[2];
+	void *ptrs[3];
+	ulong mark, count;
+	int i;
+
+	mark = malloc_leaks_mark();
+	ut_assert_noleaks();
+	for (i = 0; i < ARRAY_SIZE(ptrs); i++) {
+		ptrs[i] = malloc(20 + i);
+		ut_assertnonnull(ptrs[i]);
+	}
+
+	/* All three come from the same caller */
+	ut_asserteq(1, malloc_get_leaks(mark, leaks, ARRAY_SIZE(leaks),
+					&count));
+	ut_asserteq(3, count);
+	ut_asserteq(3, leaks[0].count);
+	ut_assert(leaks[0].bytes >= 20 + 21 + 22);
+	ut_asserteq(3, ut_check_leaks(uts));
+
+	free(ptrs[1]);
+	ut_asserteq(1, malloc_get_leaks(mark, leaks, ARRAY_SIZE(leaks),
+					&count));
+	ut_asserteq(2, count);
+
+	free(ptrs[0]);
+	free(ptrs[2]);
+	ut_asserteq(0, malloc_get_leaks(mark, leaks, ARRAY_SIZE(leaks),
+					&count));
+	ut_asserteq(0, count);
+	ut_assert_noleaks();
+
+	return 0;
+}
+
+LIB_TEST(lib_malloc_leaks, 0);
+#endif
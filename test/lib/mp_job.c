@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for running jobs on secondary CPUs
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/**
+ * struct mp_job_test - Arguments for mp_job_test_run()
+ *
+ * @value:	Value for the job to return
+ * @wait:	true to wait until mp_job_test_go is set before returning
+ */
+struct mp_job_test {
+	int value;
+	bool wait;
+};
+
+static bool mp_job_test_go;
+
+static int mp_job_test_run(void *arg)
+{
+	struct mp_job_test *test = arg;
+
+	while (test->wait &&
+	       !__atomic_load_n(&mp_job_test_go, __ATOMIC_ACQUIRE))
+		;
+
+	return test->value;
+}
+
+/* Test that jobs run on the boot CPU when no other CPU may be used */
+static int lib_mp_job_inline(struct unit_test_state *uts)
+{
+	struct mp_job_test test[3];
+	struct mp_job job[3];
+	int old, i;
+
+	old = mp_job_set_max_cpus(0);
+	ut_asserteq(0, mp_job_cpus());
+	for (i = 0; i < ARRAY_SIZE(job); i++) {
+		test[i].value = i + 1;
+		test[i].wait = false;
+		mp_job_start(&job[i], mp_job_test_run, &test[i]);
+		ut_asserteq(0, job[i].cpu);
+		ut_assert(job[i].done);
+	}
+	for (i = 0; i < ARRAY_SIZE(job); i++)
+		ut_asserteq(i + 1, mp_job_join(&job[i]));
+	mp_job_set_max_cpus(old);
+
+	return 0;
+}
+LIB_TEST(lib_mp_job_inline, 0);
+
+/* Test that jobs are given to free CPUs and the rest run on the boot CPU */
+static int lib_mp_job_cpus(struct unit_test_state *uts)
+{
+	struct mp_job_test test[3];
+	struct mp_job job[3];
+	int old, i;
+
+	old = mp_job_set_max_cpus(2);
+	ut_asserteq(2, mp_job_cpus());
+
+	/* The first two jobs keep their CPUs busy until told to finish */
+	mp_job_test_go = false;
+	for (i = 0; i < ARRAY_SIZE(job); i++) {
+		test[i].value = 10 + i;
+		test[i].wait = i < 2;
+		mp_job_start(&job[i], mp_job_test_run, &test[i]);
+	}
+	ut_asserteq(1, job[0].cpu);
+	ut_asserteq(2, job[1].cpu);
+	ut_asserteq(0, job[2].cpu);
+	ut_assert(job[2].done);
+	ut_asserteq(12, mp_job_join(&job[2]));
+
+	__atomic_store_n(&mp_job_test_go, true, __ATOMIC_RELEASE);
+	ut_asserteq(10, mp_job_join(&job[0]));
+	ut_asserteq(11, mp_job_join(&job[1]));
+	ut_assert(job[0].done);
+	ut_assert(job[1].done);
+
+	/* Joining again does nothing */
+	ut_asserteq(10, mp_job_join(&job[0]));
+
+	/* Once joined, a CPU can run another job */
+	test[0].wait = false;
+	mp_job_start(&job[0], mp_job_test_run, &test[0]);
+	ut_asserteq(1, job[0].cpu);
+	ut_asserteq(10, mp_job_join(&job[0]));
+	mp_job_set_max_cpus(old);
+
+	return 0;
+}
+LIB_TEST(lib_mp_job_cpus, 0);
+
+static int mp_job_test_secondary(void *arg)
+{
+	return mp_job_secondary();
+}
+
+/* Test that a job can tell whether it is running on a secondary CPU */
+static int lib_mp_job_secondary(struct unit_test_state *uts)
+{
+	struct mp_job job;
+	int old;
+
+	ut_assert(!mp_job_secondary());
+
+	old = mp_job_set_max_cpus(1);
+	mp_job_start(&job, mp_job_test_secondary, NULL);
+	ut_asserteq(1, job.cpu);
+	ut_asserteq(1, mp_job_join(&job));
+
+	mp_job_set_max_cpus(0);
+	mp_job_start(&job, mp_job_test_secondary, NULL);
+	ut_asserteq(0, job.cpu);
+	ut_asserteq(0, mp_job_join(&job));
+	mp_job_set_max_cpus(old);
+
+	return 0;
+}
+LIB_TEST(lib_mp_job_secondary, 0);
+
+#define MP_JOB_TEST_ALLOCS	1000
+#define MP_JOB_TEST_KEEP	8
+
+/* Allocate and free blocks, checking that no other job writes to them */
+static int mp_job_test_malloc(void *arg)
+{
+	int seed = *(int *)arg;
+	struct {
+		u8 *ptr;
+		uint size;
+	} keep[MP_JOB_TEST_KEEP] = { };
+	uint size, j;
+	int i, slot;
+
+	for (i = 0; i < MP_JOB_TEST_ALLOCS; i++) {
+		slot = i % MP_JOB_TEST_KEEP;
+		if (keep[slot].ptr) {
+			for (j = 0; j < keep[slot].size; j++) {
+				if (keep[slot].ptr[j] != (u8)seed)
+					return -EFAULT;
+			}
+			free(keep[slot].ptr);
+		}
+		size = 16 + (i * 37 + seed * 101) % 2000;
+		keep[slot].ptr = malloc(size);
+		if (!keep[slot].ptr)
+			return -ENOMEM;
+		keep[slot].size = size;
+		memset(keep[slot].ptr, seed, size);
+	}
+	for (slot = 0; slot < MP_JOB_TEST_KEEP; slot++)
+		free(keep[slot].ptr);
+
+	return 0;
+}
+
+/* Test that jobs can use malloc() at the same time */
+static int lib_mp_job_malloc(struct unit_test_state *uts)
+{
+	int seed[4];
+	struct mp_job job[4];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(job); i++) {
+		seed[i] = i + 1;
+		mp_job_start(&job[i], mp_job_test_malloc, &seed[i]);
+	}
+	for (i = 0; i < ARRAY_SIZE(job); i++)
+		ut_assertok(mp_job_join(&job[i]));
+	ut_assert_noleaks();
+
+	return 0;
+}
+LIB_TEST(lib_mp_job_malloc, 0);
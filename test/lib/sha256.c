@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests and benchmark for sha256
+ *
+ * The known answers are from FIPS 180-2. When an arch-specific block function
+ * is enabled, sha256_update() uses it, so it is also checked against
+ * sha256_blocks_generic().
+ */
+
+#include <common.h>
+#include <mapmem.h>
+#include <u-boot/sha256.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static const struct {
+	const char *msg;
+	uint8_t digest[SHA256_SUM_LEN];
+} sha256_kat[] = {
+	{
+		"",
+		{ 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+		  0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		  0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+		  0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 },
+	}, {
+		"abc",
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	}, {
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+	},
+};
+
+/* SHA256 of one million 'a' characters */
+static const uint8_t sha256_million_a[SHA256_SUM_LEN] = {
+	0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+	0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+	0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+	0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0,
+};
+
+static int lib_sha256(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	sha256_context ctx;
+	uint8_t buf[1003];
+	uint len, total;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sha256_kat); i++) {
+		sha256_csum_wd((const uint8_t *)sha256_kat[i].msg,
+			       strlen(sha256_kat[i].msg), digest,
+			       CHUNKSZ_SHA256);
+		ut_asserteq_mem(sha256_kat[i].digest, digest, SHA256_SUM_LEN);
+	}
+
+	/* Odd-sized updates, so blocks are split across calls */
+	memset(buf, 'a', sizeof(buf));
+	sha256_starts(&ctx);
+	for (i = 0, total = 0; i < 1000; i++, total += len) {
+		len = i & 1 ? 997 : 1003;
+		sha256_update(&ctx, buf, len);
+	}
+	ut_asserteq(1000000, total);
+	sha256_finish(&ctx, digest);
+	ut_asserteq_mem(sha256_million_a, digest, SHA256_SUM_LEN);
+
+	return 0;
+}
+
+LIB_TEST(lib_sha256, 0);
+
+/* Check the block function in use against the generic one */
+static int lib_sha256_blocks(struct unit_test_state *uts)
+{
+	uint8_t buf[64 * 17 + 3];
+	sha256_context ctx;
+	uint32_t state[8];
+	int i, offset;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	/* Unaligned data must work too */
+	for (offset = 0; offset < 4; offset++) {
+		sha256_starts(&ctx);
+		memcpy(state, ctx.state, sizeof(state));
+		sha256_update(&ctx, buf + offset, 64 * 17);
+		sha256_blocks_generic(state, buf + offset, 17);
+		ut_asserteq_mem(state, ctx.state, sizeof(state));
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_sha256_blocks, 0);
+
+/*
+ * Report SHA256 throughput of the block function in use and of the generic
+ * one, over 16MiB of whatever is in RAM from address 0
+ */
+static int lib_sha256_bench(struct unit_test_state *uts)
+{
+	ulong len = min_t(ulong, 16 << 20, gd->ram_size) & ~63UL;
+	uint8_t digest[SHA256_SUM_LEN];
+	ulong start, us, gen_us;
+	uint32_t state[8];
+	const void *buf;
+
+	memset(state, '\0', sizeof(state));
+	buf = map_sysmem(0, len);
+	start = timer_get_us();
+	sha256_csum_wd(buf, len, digest, CHUNKSZ_SHA256);
+	us = timer_get_us() - start;
+
+	start = timer_get_us();
+	sha256_blocks_generic(state, buf, len / 64);
+	gen_us = timer_get_us() - start;
+	unmap_sysmem(buf);
+
+	printf("sha256: %lu bytes: %lu MB/s, generic C %lu MB/s\n", len,
+	       us ? len / us : 0, gen_us ? len / gen_us : 0);
+
+	return 0;
+}
+
+LIB_TEST(lib_sha256_bench, 0);
@@ -11,6 +11,8 @@
 
 #include <common.h>
 #include <command.h>
+#include <malloc.h>
+#include <linux/sizes.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -192,3 +194,121 @@ static int lib_memmove(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_memmove, 0);
+
+/**
+ * lib_memcmp() - unit test for memcmp()
+ *
+ * Test memcmp() with varied alignment and length of the compared buffers,
+ * and with the difference at each position.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcmp(struct unit_test_state *uts)
+{
+	u8 buf1[BUFLEN];
+	u8 buf2[BUFLEN];
+	int offset1, offset2, len, diff;
+
+	init_buffer(buf1, MASK);
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			for (len = 1; len < BUFLEN - SWEEP; ++len) {
+				init_buffer(buf2, MASK);
+				memmove(buf2 + offset2, buf1 + offset1, len);
+				ut_assertok(memcmp(buf1 + offset1,
+						   buf2 + offset2, len));
+				diff = (offset1 * 7 + offset2) % len;
+				buf2[offset2 + diff]++;
+				ut_assert(memcmp(buf1 + offset1,
+						 buf2 + offset2, len) < 0);
+				ut_assert(memcmp(buf2 + offset2,
+						 buf1 + offset1, len) > 0);
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memcmp, 0);
+
+/* Largest size used by the benchmark */
+#define BENCH_MAX_SIZE	SZ_64K
+/* Number of bytes processed for each size and alignment */
+#define BENCH_BYTES	SZ_4M
+
+/**
+ * bench_mb_per_s() - convert a time into a speed
+ *
+ * @us:		time taken to process BENCH_BYTES, in microseconds
+ * Return:	speed in megabytes per second
+ */
+static ulong bench_mb_per_s(ulong us)
+{
+	return us ? BENCH_BYTES / us : 0;
+}
+
+/**
+ * lib_mem_bench() - benchmark memcpy(), memset() and memcmp()
+ *
+ * Report the speed of each function over a range of sizes, with the buffers
+ * aligned and not. This does not fail on a slow result, but shows when a
+ * change makes these functions slower. The results are also checked, since
+ * the sizes are larger than in the tests above.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_mem_bench(struct unit_test_state *uts)
+{
+	static const int sizes[] = { 16, 64, 256, SZ_4K, BENCH_MAX_SIZE };
+	static const int aligns[][2] = { { 0, 0 }, { 1, 1 }, { 0, 3 } };
+	ulong cpy_us, set_us, cmp_us, start;
+	int i, j, loop, loops;
+	u8 *src, *dst;
+	u8 *buf1, *buf2;
+
+	buf1 = malloc(BENCH_MAX_SIZE + SWEEP);
+	buf2 = malloc(BENCH_MAX_SIZE + SWEEP);
+	ut_assertnonnull(buf1);
+	ut_assertnonnull(buf2);
+	for (i = 0; i < BENCH_MAX_SIZE + SWEEP; i++)
+		buf1[i] = i ^ MASK;
+
+	printf("%8s %6s %10s %10s %10s\n", "size", "align", "memcpy",
+	       "memset", "memcmp");
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		loops = BENCH_BYTES / sizes[i];
+		for (j = 0; j < ARRAY_SIZE(aligns); j++) {
+			src = buf1 + aligns[j][0];
+			dst = buf2 + aligns[j][1];
+
+			start = timer_get_us();
+			for (loop = 0; loop < loops; loop++)
+				memcpy(dst, src, sizes[i]);
+			cpy_us = timer_get_us() - start;
+
+			start = timer_get_us();
+			for (loop = 0; loop < loops; loop++)
+				ut_assertok(memcmp(dst, src, sizes[i]));
+			cmp_us = timer_get_us() - start;
+
+			start = timer_get_us();
+			for (loop = 0; loop < loops; loop++)
+				memset(dst, loop, sizes[i]);
+			set_us = timer_get_us() - start;
+			ut_asserteq((u8)(loops - 1), dst[sizes[i] - 1]);
+
+			printf("%8d %3d/%-2d %5lu MB/s %5lu MB/s %5lu MB/s\n",
+			       sizes[i], aligns[j][0], aligns[j][1],
+			       bench_mb_per_s(cpy_us), bench_mb_per_s(set_us),
+			       bench_mb_per_s(cmp_us));
+		}
+	}
+	free(buf1);
+	free(buf2);
+
+	return 0;
+}
+
+LIB_TEST(lib_mem_bench, 0);
@@ -0,0 +1,55 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check the boot timeline of devices which finish probing in the background
+#
+# The sandbox device tree has two async-delay devices, which sandbox starts
+# probing in board_init(). Each records a bootstage span for its wait, and
+# these should overlap rather than follow one another.
+
+import pytest
+
+def get_spans(output):
+    """Get the spans from a bootstage report
+
+    Args:
+        output: Output of the 'bootstage report' command
+
+    Returns:
+        dict of span name to (start, duration) in microseconds
+    """
+    spans = {}
+    in_spans = False
+    for line in output.splitlines():
+        if line.startswith('Spans:'):
+            in_spans = True
+            continue
+        fields = line.split(None, 2)
+        if not in_spans or len(fields) != 3 or not fields[0][0].isdigit():
+            continue
+        start, duration = [int(val.replace(',', '')) for val in fields[:2]]
+        spans[fields[2].strip()] = (start, duration)
+    return spans
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('dm_async_probe')
+@pytest.mark.buildconfigspec('bootstage_probe')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_async_probe_timeline(u_boot_console):
+    """Test that the waits of async devices overlap in the boot timeline"""
+    cons = u_boot_console
+    cons.restart_uboot()
+    output = cons.run_command('bootstage report')
+    assert 'Overflowed' not in output
+    spans = get_spans(output)
+
+    start0, dur0 = spans['async-delay-0 (async)']
+    start1, dur1 = spans['async-delay-1 (async)']
+    assert dur0 >= 20000
+    assert dur1 >= 10000
+
+    # The probe() methods return without waiting
+    assert spans['async-delay-0'][1] < dur0
+    assert spans['async-delay-1'][1] < dur1
+
+    # The second device starts before the first is ready
+    assert start0 <= start1 < start0 + dur0
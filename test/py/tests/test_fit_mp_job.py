@@ -0,0 +1,159 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check the FIT handling which runs on secondary CPUs with CONFIG_MP_JOB
+#
+# On sandbox each secondary CPU is a host thread. The hashes of every image
+# are checked by jobs in fit_all_image_verify(), and bootm decompresses the
+# kernel in a job while it finds the ramdisk and device tree.
+
+import gzip
+import os
+import pytest
+import u_boot_utils as util
+
+its = '''
+/dts-v1/;
+
+/ {
+        description = "Test FIT for jobs on secondary CPUs";
+        #address-cells = <1>;
+
+        images {
+                kernel@1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "gzip";
+                        load = <%(kernel_addr)#x>;
+                        entry = <%(kernel_addr)#x>;
+                        hash@1 {
+                                algo = "crc32";
+                        };
+                        hash@2 {
+                                algo = "sha1";
+                        };
+                };
+                fdt@1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        compression = "none";
+                        hash@1 {
+                                algo = "sha256";
+                        };
+                };
+                ramdisk@1 {
+                        data = /incbin/("%(ramdisk)s");
+                        type = "ramdisk";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "none";
+                        load = <%(ramdisk_addr)#x>;
+                        hash@1 {
+                                algo = "crc32";
+                        };
+                };
+        };
+        configurations {
+                default = "conf@1";
+                conf@1 {
+                        kernel = "kernel@1";
+                        fdt = "fdt@1";
+                        ramdisk = "ramdisk@1";
+                };
+        };
+};
+'''
+
+script = '''
+host load hostfs 0 %(fit_addr)x %(fit)s
+bootm start %(fit_addr)x
+bootm loados
+host save hostfs 0 %(kernel_addr)x %(kernel_out)s %(kernel_size)x
+host save hostfs 0 %(ramdisk_addr)x %(ramdisk_out)s %(ramdisk_size)x
+'''
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('mp_job')
+@pytest.mark.requiredtool('dtc')
+def test_fit_mp_job(u_boot_console):
+    """Test that FIT hashes are checked and the OS is decompressed by jobs"""
+    cons = u_boot_console
+
+    def make_fname(leaf):
+        return os.path.join(cons.config.build_dir, leaf)
+
+    def read_file(fname):
+        with open(fname, 'rb') as fd:
+            return fd.read()
+
+    def make_data(fname, text, lines):
+        data = ''.join('%s %d\n' % (text, i) for i in range(lines))
+        with open(fname, 'w') as fd:
+            fd.write(data)
+        return fname
+
+    def make_fit(params):
+        its_fname = make_fname('test-mp-job.its')
+        fit = make_fname('test-mp-job.fit')
+        with open(its_fname, 'w') as fd:
+            fd.write(its % params)
+        util.run_and_log(cons, [mkimage, '-f', its_fname, fit])
+        return fit
+
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+
+    # The kernel is large enough for the job to take a while
+    kernel = make_data(make_fname('test-mp-job-kernel.bin'),
+                       'this kernel is decompressed on another CPU', 20000)
+    kernel_gz = make_fname('test-mp-job-kernel.gz')
+    with gzip.open(kernel_gz, 'wb') as fd:
+        fd.write(read_file(kernel))
+    ramdisk = make_data(make_fname('test-mp-job-ramdisk.bin'),
+                        'this ramdisk is hashed on another CPU', 1000)
+
+    params = {
+        'fit_addr': 0x1000,
+        'kernel': kernel_gz,
+        'kernel_addr': 0x400000,
+        'kernel_out': make_fname('test-mp-job-kernel-out.bin'),
+        'kernel_size': os.stat(kernel).st_size,
+        'fdt': cons.config.dtb,
+        'ramdisk': ramdisk,
+        'ramdisk_addr': 0x200000,
+        'ramdisk_out': make_fname('test-mp-job-ramdisk-out.bin'),
+        'ramdisk_size': os.stat(ramdisk).st_size,
+    }
+    fit = make_fit(params)
+    params['fit'] = fit
+
+    cons.restart_uboot()
+    with cons.log.section('Check hashes'):
+        cons.run_command('host load hostfs 0 %x %s' %
+                         (params['fit_addr'], fit))
+        output = cons.run_command('iminfo %x' % params['fit_addr'])
+        assert 'Bad hash' not in output
+        assert output.count('crc32+') == 2
+        assert 'sha1+' in output
+        assert 'sha256+' in output
+
+    with cons.log.section('Decompress kernel'):
+        output = cons.run_command_list((script % params).strip().splitlines())
+        assert 'Bad hash' not in '\n'.join(output)
+        assert read_file(kernel) == read_file(params['kernel_out'])
+        assert read_file(ramdisk) == read_file(params['ramdisk_out'])
+
+    # Damage the kernel data in the FIT; the job's hash must not match
+    with cons.log.section('Detect bad hash'):
+        data = bytearray(read_file(fit))
+        pos = data.find(read_file(kernel_gz)[:16])
+        assert pos > 0
+        data[pos + 100] ^= 0xff
+        bad_fit = make_fname('test-mp-job-bad.fit')
+        with open(bad_fit, 'wb') as fd:
+            fd.write(data)
+        cons.run_command('host load hostfs 0 %x %s' %
+                         (params['fit_addr'], bad_fit))
+        output = cons.run_command('iminfo %x' % params['fit_addr'])
+        assert 'Bad hash in FIT image!' in output
@@ -0,0 +1,86 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test of the loadz command, which decompresses a file while it is read
+
+import gzip
+import os
+import pytest
+import random
+import u_boot_utils as util
+
+# Size of the uncompressed test file
+DATA_SIZE = 4 << 20
+
+def make_data():
+    """Build some compressible data, from a pool of random 1KB blocks."""
+    rand = random.Random(1234)
+    pool = [bytearray(rand.getrandbits(8) for i in range(1024))
+            for j in range(64)]
+    return b''.join(bytes(rand.choice(pool))
+                    for i in range(DATA_SIZE // 1024))
+
+def loadz_check(u_boot_console, fname, md5):
+    """Load a compressed file with loadz and check what it decompressed to.
+
+    Returns:
+        The loadz output, with the sizes and time taken.
+    """
+    cons = u_boot_console
+    addr = util.find_ram_base(cons) + 0x100000
+    output = cons.run_command('loadz hostfs - %x %s' % (addr, fname))
+    assert 'bytes decompressed' in output
+    cons.log.info('%s: %s' % (os.path.basename(fname), output))
+    response = cons.run_command('printenv filesize')
+    assert response == 'filesize=%x' % DATA_SIZE
+    response = cons.run_command('md5sum %x $filesize' % addr)
+    assert md5 in response
+    return output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_loadz')
+@pytest.mark.buildconfigspec('cmd_md5sum')
+def test_loadz_gzip(u_boot_console):
+    """Check loadz against the uncompressed reference for a gzip file."""
+    cons = u_boot_console
+    data = make_data()
+    fname = os.path.join(cons.config.persistent_data_dir, 'loadz.bin.gz')
+    with gzip.open(fname, 'wb') as fd:
+        fd.write(data)
+    loadz_check(cons, fname, util.md5sum_data(data))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_loadz')
+@pytest.mark.buildconfigspec('cmd_md5sum')
+@pytest.mark.buildconfigspec('lz4')
+@pytest.mark.requiredtool('lz4')
+def test_loadz_lz4(u_boot_console):
+    """Check loadz against the uncompressed reference for an lz4 file."""
+    cons = u_boot_console
+    data = make_data()
+    fname = os.path.join(cons.config.persistent_data_dir, 'loadz.bin')
+    with open(fname, 'wb') as fd:
+        fd.write(data)
+    util.run_and_log(cons, ['lz4', '-f', '-B5', fname, fname + '.lz4'])
+    loadz_check(cons, fname + '.lz4', util.md5sum_data(data))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_loadz')
+def test_loadz_bad(u_boot_console):
+    """Check that loadz rejects a file which is not compressed, or cut short.
+    """
+    cons = u_boot_console
+    data = make_data()
+    addr = util.find_ram_base(cons) + 0x100000
+    fname = os.path.join(cons.config.persistent_data_dir, 'loadz.raw')
+    with open(fname, 'wb') as fd:
+        fd.write(data)
+    output = cons.run_command('loadz hostfs - %x %s' % (addr, fname))
+    assert 'Unknown compression format' in output
+
+    fname = os.path.join(cons.config.persistent_data_dir, 'loadz.short.gz')
+    with gzip.open(fname, 'wb') as fd:
+        fd.write(data)
+    with open(fname, 'rb+') as fd:
+        fd.truncate(os.path.getsize(fname) // 2)
+    output = cons.run_command('loadz hostfs - %x %s' % (addr, fname))
+    assert 'truncated' in output
@@ -4,8 +4,14 @@
 # Test various network-related functionality, such as the dhcp, ping, and
 # tftpboot commands.
 
+import functools
+import http.server
+import os
 import pytest
+import threading
+import time
 import u_boot_utils
+import zlib
 
 """
 Note: This test relies on boardenv_* containing configuration values to define
@@ -55,6 +61,19 @@ env__net_nfs_readable_file = {
     'size': 5058624,
     'crc32': 'c2244b26',
 }
+
+# Details of an HTTP server which the wget test starts on the host, serving a
+# file of random data that it creates. The address must be one the U-Boot
+# network device can reach, e.g. for sandbox with eth-raw bound to a host or
+# veth interface (not lo, which only passes UDP), that interface's address.
+# This variable may be omitted or set to None if HTTP testing is not possible
+# or desired.
+env__net_wget_server = {
+    'ip': '10.0.0.1',
+    'port': 8080,
+    'addr': 0x10000000,
+    'size': 5058624,
+}
 """
 
 net_set_up = False
@@ -167,6 +186,59 @@ def test_net_tftpboot(u_boot_console):
     output = u_boot_console.run_command('crc32 $fileaddr $filesize')
     assert expected_crc in output
 
+@pytest.mark.buildconfigspec('cmd_net')
+@pytest.mark.buildconfigspec('net_tftp_vars')
+@pytest.mark.parametrize('windowsize', [1, 4, 8, 16])
+def test_net_tftpboot_windowsize(u_boot_console, windowsize):
+    """Test the tftpboot command with the RFC 7440 windowsize option.
+
+    The file from env__net_tftp_readable_file is downloaded with the server
+    allowed to send several blocks per acknowledgement, and its size and
+    optionally its CRC32 are validated. The transfer rate is logged so that
+    window sizes can be compared. A server without windowsize support falls
+    back to one block per acknowledgement, so this passes either way.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console)
+
+    fn = f['fn']
+    u_boot_console.run_command('setenv tftpwindowsize %d' % windowsize)
+    try:
+        start = time.time()
+        output = u_boot_console.run_command('tftpboot %x %s' % (addr, fn))
+        elapsed = time.time() - start
+    finally:
+        u_boot_console.run_command('setenv tftpwindowsize')
+
+    expected_text = 'Bytes transferred = '
+    sz = f.get('size', None)
+    if sz:
+        expected_text += '%d' % sz
+    assert expected_text in output
+    if sz and elapsed:
+        u_boot_console.log.info('tftp windowsize %d: %d bytes in %.2fs, '
+                                '%.1f KiB/s' % (windowsize, sz, elapsed,
+                                                sz / elapsed / 1024))
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        return
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+    assert expected_crc in output
+
 @pytest.mark.buildconfigspec('cmd_nfs')
 def test_net_nfs(u_boot_console):
     """Test the nfs command.
@@ -206,3 +278,62 @@ def test_net_nfs(u_boot_console):
 
     output = u_boot_console.run_command('crc32 %x $filesize' % addr)
     assert expected_crc in output
+
+@pytest.mark.buildconfigspec('cmd_wget')
+def test_net_wget(u_boot_console):
+    """Test the wget command.
+
+    A file of random data is served by a Python HTTP server started on the
+    host and downloaded with wget. Its size and optionally its CRC32 are
+    validated and the transfer rate is logged.
+
+    The details of the server are provided by the boardenv_* file; see the
+    comment at the beginning of this file.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_wget_server', None)
+    if not f:
+        pytest.skip('No HTTP server to start')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console)
+
+    sz = f.get('size', 1 << 20)
+    data = os.urandom(sz)
+    fn = 'ubtest-wget.bin'
+    path = os.path.join(u_boot_console.config.build_dir, fn)
+    with open(path, 'wb') as fd:
+        fd.write(data)
+
+    handler = functools.partial(http.server.SimpleHTTPRequestHandler,
+                                directory=u_boot_console.config.build_dir)
+    server = http.server.ThreadingHTTPServer((f['ip'], f['port']), handler)
+    thread = threading.Thread(target=server.serve_forever)
+    thread.start()
+    try:
+        u_boot_console.run_command('setenv httpdstp %d' % f['port'])
+        start = time.time()
+        output = u_boot_console.run_command('wget %x %s:/%s' %
+                                            (addr, f['ip'], fn))
+        elapsed = time.time() - start
+    finally:
+        u_boot_console.run_command('setenv httpdstp')
+        server.shutdown()
+        thread.join()
+        server.server_close()
+        os.remove(path)
+
+    assert 'Bytes transferred = %d' % sz in output
+    if elapsed:
+        u_boot_console.log.info('wget: %d bytes in %.2fs, %.1f KiB/s' %
+                                (sz, elapsed, sz / elapsed / 1024))
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+    assert '%08x' % zlib.crc32(data) in output
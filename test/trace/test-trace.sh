@@ -23,6 +23,9 @@ trace resume
 hash sha256 0 10000
 trace pause
 trace stats
+trace calls 0 2000000
+trace bootstage
+host save host 0 ${prof} 0 \${profoffset}
 reset
 END
 }
@@ -54,11 +57,39 @@ check_results() {
 	fi
 }
 
+check_profile() {
+	echo "Check profile"
+	proftool="./${OUTPUT_DIR}/tools/proftool -m ${OUTPUT_DIR}/System.map"
+	proftool="${proftool} -p ${prof} -v 0"
+
+	# Function call stacks, with the time spent in each
+	if ! ${proftool} dump-flamegraph | grep -q "initr_dm [0-9]*$"; then
+		fail "no call stacks in flame graph"
+	fi
+
+	# Device probes are recorded as bootstage spans
+	if ! ${proftool} dump-span-flamegraph | \
+			grep -q "^root_driver [0-9]*$"; then
+		fail "no device probe spans in flame graph"
+	fi
+
+	${proftool} dump-chrome >${tmp}
+	if ! python3 -m json.tool ${tmp} >/dev/null; then
+		fail "invalid Chrome trace JSON"
+	fi
+	if ! grep -q '"name":"root_driver","cat":"bootstage","ph":"X"' \
+			${tmp}; then
+		fail "no bootstage spans in Chrome trace"
+	fi
+}
+
 echo "Simple trace test / sanity check using sandbox"
 echo
 tmp="$(tempfile)"
+prof="$(tempfile)"
 build_uboot "${TRACE_OPT}"
 run_trace >${tmp}
 check_results ${tmp}
-rm ${tmp}
+check_profile
+rm ${tmp} ${prof}
 echo "Test passed"
@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <malloc_stats.h>
 #include <test/test.h>
 #include <test/ut.h>
 
@@ -32,3 +33,40 @@ void ut_failf(struct unit_test_state *uts, const char *fname, int line,
 	putc('\n');
 	uts->fail_count++;
 }
+
+#if CONFIG_IS_ENABLED(MALLOC_STATS)
+void ut_leak_start(struct unit_test_state *uts)
+{
+	struct malloc_info info;
+
+	malloc_get_info(&info);
+	uts->malloc_count = info.count;
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+	uts->malloc_mark = malloc_leaks_mark();
+#endif
+}
+
+ulong ut_check_leaks(struct unit_test_state *uts)
+{
+#if CONFIG_IS_ENABLED(MALLOC_TRACK_CALLERS)
+	struct malloc_leak leaks[10];
+	ulong count;
+	int num, i;
+
+	num = malloc_get_leaks(uts->malloc_mark, leaks, ARRAY_SIZE(leaks),
+			       &count);
+	for (i = 0; i < num; i++)
+		printf("Leak: %lu blocks, %lu bytes, allocated at %p\n",
+		       leaks[i].count, leaks[i].bytes, leaks[i].caller);
+
+	return count;
+#else
+	struct malloc_info info;
+
+	malloc_get_info(&info);
+
+	return info.count > uts->malloc_count ?
+		info.count - uts->malloc_count : 0;
+#endif
+}
+#endif
@@ -13,6 +13,7 @@ static data.
 
 import collections
 import copy
+import os
 import sys
 
 import fdt
@@ -547,6 +548,87 @@ class DtbPlatdata(object):
             nodes_to_output.remove(node)
 
 
+    def get_compat_nodes(self, root):
+        """Get all nodes with a compatible string, in order of offset
+
+        Unlike _valid_nodes this includes disabled nodes, since drivers can
+        still bind them explicitly.
+
+        Args:
+            root: Node to scan from
+
+        Returns:
+            List of Node objects
+        """
+        nodes = []
+        for node in root.subnodes:
+            if 'compatible' in node.props:
+                nodes.append(node)
+            nodes += self.get_compat_nodes(node)
+        return nodes
+
+    def generate_devtab(self, name):
+        """Generate a table of device tree nodes for driver model binding
+
+        This writes out a U_BOOT_DEVTAB() declaration listing each node with a
+        compatible string, along with a slot for each different compatible
+        string. U-Boot uses this to match each compatible string against its
+        drivers only once. See struct dm_devtab for details.
+
+        Args:
+            name: Name to use for the table, normally that of the .dtb file
+        """
+        self.out_header()
+        self.out('#include <common.h>\n')
+        self.out('#include <dm/devtab.h>\n')
+        self.out('\n')
+
+        nodes = self.get_compat_nodes(self._fdt.GetRoot())
+        nodes.sort(key=lambda node: node.Offset())
+        strings = {}
+        slot_lists = collections.OrderedDict()
+        for node in nodes:
+            compat = node.props['compatible'].value
+            if not isinstance(compat, list):
+                compat = [compat]
+            slots = []
+            for string in compat:
+                if string not in strings:
+                    strings[string] = len(strings)
+                slots.append(strings[string])
+            slot_lists.setdefault(tuple(slots), len(slot_lists))
+
+        for slots, seq in slot_lists.items():
+            self.out('static const u16 devtab_slots%d[] = {%s};\n' %
+                     (seq, ', '.join(str(slot) for slot in slots)))
+        if slot_lists:
+            self.out('\n')
+
+        self.out('static const struct dm_devtab_node devtab_nodes[] = {\n')
+        for node in nodes:
+            prop = node.props['compatible']
+            compat = prop.value
+            if not isinstance(compat, list):
+                compat = [compat]
+            slots = tuple(strings[string] for string in compat)
+            literal = '\\0" "'.join(compat)
+            self.out('\t/* %s */\n' % node.path)
+            self.out('\t{%#x, "%s", %d, devtab_slots%d},\n' %
+                     (node.Offset(), literal, len(prop.bytes),
+                      slot_lists[slots]))
+        self.out('};\n')
+        self.out('\n')
+        self.out('static struct dm_devtab_match devtab_match[%d];\n' %
+                 len(strings))
+        self.out('\n')
+        self.out('U_BOOT_DEVTAB(%s) = {\n' % name)
+        self.out('\t.nodes\t\t= devtab_nodes,\n')
+        self.out('\t.node_count\t= ARRAY_SIZE(devtab_nodes),\n')
+        self.out('\t.match\t\t= devtab_match,\n')
+        self.out('\t.match_count\t= ARRAY_SIZE(devtab_match),\n')
+        self.out('};\n')
+
+
 def run_steps(args, dtb_file, include_disabled, output):
     """Run all the steps of the dtoc tool
 
@@ -557,7 +639,7 @@ def run_steps(args, dtb_file, include_disabled, output):
         output: Name of output file
     """
     if not args:
-        raise ValueError('Please specify a command: struct, platdata')
+        raise ValueError('Please specify a command: struct, platdata, devtab')
 
     plat = DtbPlatdata(dtb_file, include_disabled)
     plat.scan_dtb()
@@ -572,6 +654,9 @@ def run_steps(args, dtb_file, include_disabled, output):
             plat.generate_structs(structs)
         elif cmd == 'platdata':
             plat.generate_tables()
+        elif cmd == 'devtab':
+            name = os.path.splitext(os.path.basename(dtb_file))[0]
+            plat.generate_devtab(conv_name_to_c(name))
         else:
-            raise ValueError("Unknown command '%s': (use: struct, platdata)" %
-                             cmd)
+            raise ValueError("Unknown command '%s': (use: struct, platdata, "
+                             "devtab)" % cmd)
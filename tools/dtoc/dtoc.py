@@ -23,6 +23,10 @@ This tool is used in U-Boot to provide device tree data to SPL without
 increasing the code size of SPL. This supports the CONFIG_SPL_OF_PLATDATA
 options. For more information about the use of this options and tool please
 see doc/driver-model/of-plat.txt
+
+It can also produce a table of the device tree nodes with a compatible string
+(the 'devtab' command), which U-Boot proper uses to speed up binding devices
+with CONFIG_OF_DEVTAB. See include/dm/devtab.h
 """
 
 from optparse import OptionParser
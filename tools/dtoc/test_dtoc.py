@@ -46,6 +46,15 @@ C_HEADER = '''/*
 #include <dt-structs.h>
 '''
 
+DEVTAB_HEADER = '''/*
+ * DO NOT MODIFY
+ *
+ * This file was generated by dtoc from a .dtb (device tree binary) file.
+ */
+
+#include <common.h>
+#include <dm/devtab.h>
+'''
 
 
 def get_dtb_file(dts_fname, capture_stderr=False):
@@ -433,6 +442,41 @@ U_BOOT_DEVICE(spl_test) = {
 
 ''', data)
 
+    def test_devtab(self):
+        """Test output of a table of nodes for binding"""
+        dtb_file = get_dtb_file('dtoc_test_devtab.dts')
+        output = tools.GetOutputFilename('output')
+        dtb_platdata.run_steps(['devtab'], dtb_file, False, output)
+        with open(output) as infile:
+            data = infile.read()
+        dtb = fdt.FdtScan(dtb_file)
+        offsets = [dtb.GetNode(path).Offset() for path in
+                   ['/bus', '/bus/child@1', '/disabled', '/bus2']]
+        self._CheckStrings(DEVTAB_HEADER + '''
+static const u16 devtab_slots0[] = {0, 1};
+static const u16 devtab_slots1[] = {2};
+
+static const struct dm_devtab_node devtab_nodes[] = {
+\t/* /bus */
+\t{%#x, "vendor,bus\\0" "simple-bus", 22, devtab_slots0},
+\t/* /bus/child@1 */
+\t{%#x, "vendor,child", 13, devtab_slots1},
+\t/* /disabled */
+\t{%#x, "vendor,child", 13, devtab_slots1},
+\t/* /bus2 */
+\t{%#x, "vendor,bus\\0" "simple-bus", 22, devtab_slots0},
+};
+
+static struct dm_devtab_match devtab_match[3];
+
+U_BOOT_DEVTAB(source) = {
+\t.nodes\t\t= devtab_nodes,
+\t.node_count\t= ARRAY_SIZE(devtab_nodes),
+\t.match\t\t= devtab_match,
+\t.match_count\t= ARRAY_SIZE(devtab_match),
+};
+''' % tuple(offsets), data)
+
     def test_addresses64(self):
         """Test output from a node with a 'reg' property with na=2, ns=2"""
         dtb_file = get_dtb_file('dtoc_test_addr64.dts')
@@ -706,5 +750,6 @@ U_BOOT_DEVICE(spl_test2) = {
         output = tools.GetOutputFilename('output')
         with self.assertRaises(ValueError) as e:
             dtb_platdata.run_steps(['invalid-cmd'], dtb_file, False, output)
-        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata)",
+        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata, "
+                      "devtab)",
                       str(e.exception))
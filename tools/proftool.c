@@ -55,6 +55,8 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+struct trace_output_span *span_list;
+int span_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -85,6 +87,12 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-chrome\t\tDump calls and bootstage records in Chrome trace-event\n"
+		"\t\t\tJSON format\n"
+		"   dump-flamegraph\tDump time spent in each call stack in folded-stack\n"
+		"\t\t\tformat\n"
+		"   dump-span-flamegraph\tDump time spent in each stack of bootstage spans\n"
+		"\t\t\tin folded-stack format\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -226,6 +234,21 @@ static int read_calls(FILE *fin, int count)
 	return 0;
 }
 
+static int read_spans(FILE *fin, int count)
+{
+	notice("bootstage record count: %d\n", count);
+	span_list = calloc(count, sizeof(*span_list));
+	if (!span_list) {
+		error("Cannot allocate span_list\n");
+		return -1;
+	}
+	span_count = count;
+	if (count && read_data(fin, span_list, count * sizeof(*span_list)))
+		return 1;
+
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -249,6 +272,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_BOOTSTAGE:
+			if (read_spans(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -532,6 +560,269 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/**
+ * Work out the time of each call in microseconds
+ *
+ * The timestamps in the trace are only 30 bits, so wrap after about 18
+ * minutes. This assumes that no gap between two records is that long.
+ *
+ * @return array of times, indexed like call_list
+ */
+static unsigned long long *get_call_times(void)
+{
+	unsigned long long *times, base = 0;
+	unsigned long prev = 0;
+	struct trace_call *call;
+	int i;
+
+	times = calloc(call_count, sizeof(*times));
+	assert(times || !call_count);
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		unsigned long time = call->flags & FUNCF_TIMESTAMP_MASK;
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (time < prev)
+			base += FUNCF_TIMESTAMP_MASK + 1ULL;
+		prev = time;
+		times[i] = base + time;
+	}
+
+	return times;
+}
+
+/* Get the function for a call, or NULL if it is unknown or excluded */
+static struct func_info *get_traced_func(struct trace_call *call)
+{
+	struct func_info *func;
+
+	if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+	    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+		return NULL;
+	func = find_func_by_offset(call->func);
+	if (!func || !(func->flags & FUNCF_TRACE))
+		return NULL;
+
+	return func;
+}
+
+/* Output a string as a JSON string, with quotes */
+static void out_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/*
+ * Write a Chrome trace-event file, which can be loaded by chrome://tracing or
+ * https://ui.perfetto.dev
+ *
+ * Bootstage records are shown in one thread, with spans as complete ("X")
+ * events and marks as instant ("i") events. Function calls are shown in
+ * another, as begin ("B") and end ("E") events. Bootstage uses
+ * timer_get_boot_us() and function trace uses timer_get_us(), so the two
+ * may not be aligned on all boards.
+ */
+static int make_chrome(void)
+{
+	struct trace_output_span *span;
+	unsigned long long *times;
+	struct trace_call *call;
+	int i;
+
+	printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+	       "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+	       "\"args\":{\"name\":\"bootstage\"}},\n"
+	       "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+	       "\"args\":{\"name\":\"functions\"}}");
+
+	for (i = 0, span = span_list; i < span_count; i++, span++) {
+		printf(",\n{\"name\":");
+		out_json_str(span->name);
+		if (span->flags & TRACE_SPANF_MARK)
+			printf(",\"cat\":\"bootstage\",\"ph\":\"i\",\"s\":\"p\"");
+		else
+			printf(",\"cat\":\"bootstage\",\"ph\":\"X\",\"dur\":%u",
+			       span->duration_us);
+		printf(",\"ts\":%u,\"pid\":1,\"tid\":1}", span->start_us);
+	}
+
+	times = get_call_times();
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = get_traced_func(call);
+
+		if (!func)
+			continue;
+		printf(",\n{\"name\":");
+		out_json_str(func->name);
+		printf(",\"cat\":\"ftrace\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":1,\"tid\":2}",
+		       TRACE_CALL_TYPE(call) == FUNCF_ENTRY ? "B" : "E",
+		       times[i]);
+	}
+	printf("\n]}\n");
+	free(times);
+
+	return 0;
+}
+
+/* A node in a tree of call stacks, used to build a flame graph */
+struct flame_node {
+	const char *name;
+	struct flame_node *parent;
+	struct flame_node *child;	/* First child */
+	struct flame_node *sibling;	/* Next child of the same parent */
+	long long self_us;		/* Time not spent in any child */
+	unsigned long long start_us;	/* Start of the current call */
+	unsigned long long child_us;	/* Time in children of current call */
+};
+
+/* Find the child of a node with a given name, adding it if needed */
+static struct flame_node *flame_child(struct flame_node *node,
+				      const char *name)
+{
+	struct flame_node *child;
+
+	for (child = node->child; child; child = child->sibling) {
+		if (!strcmp(child->name, name))
+			return child;
+	}
+	child = calloc(1, sizeof(*child));
+	assert(child);
+	child->name = name;
+	child->parent = node;
+	child->sibling = node->child;
+	node->child = child;
+
+	return child;
+}
+
+static void out_flame_stack(struct flame_node *node)
+{
+	if (node->parent->parent) {
+		out_flame_stack(node->parent);
+		putchar(';');
+	}
+	printf("%s", node->name);
+}
+
+/*
+ * Write each stack in the tree below root with its self time, in the folded
+ * format used by flamegraph.pl, e.g. 'board_init_r;initr_dm;dm_scan 1234'
+ */
+static void out_flame_tree(struct flame_node *root)
+{
+	struct flame_node *node, *next;
+
+	for (node = root->child; node; node = next) {
+		if (node->self_us > 0) {
+			out_flame_stack(node);
+			printf(" %lld\n", node->self_us);
+		}
+		out_flame_tree(node);
+		next = node->sibling;
+		free(node);
+	}
+	root->child = NULL;
+}
+
+/* Build a flame graph of the time spent in each function call stack */
+static int make_flamegraph(void)
+{
+	struct flame_node root, *node = &root;
+	unsigned long long *times, duration;
+	struct trace_call *call;
+	int i;
+
+	memset(&root, '\0', sizeof(root));
+	times = get_call_times();
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = get_traced_func(call);
+		struct flame_node *match;
+
+		if (!func)
+			continue;
+		if (TRACE_CALL_TYPE(call) == FUNCF_ENTRY) {
+			node = flame_child(node, func->name);
+			node->start_us = times[i];
+			node->child_us = 0;
+			continue;
+		}
+
+		/*
+		 * Records can be dropped when the trace is too deep or the
+		 * buffer fills, so unwind to the matching call if there is
+		 * one, and ignore the exit if not
+		 */
+		for (match = node; match != &root; match = match->parent) {
+			if (!strcmp(match->name, func->name))
+				break;
+		}
+		if (match == &root)
+			continue;
+		node = match;
+		duration = times[i] - node->start_us;
+		if (duration > node->child_us)
+			node->self_us += duration - node->child_us;
+		node = node->parent;
+		node->child_us += duration;
+	}
+	free(times);
+	out_flame_tree(&root);
+
+	return 0;
+}
+
+static int h_cmp_span_start(const void *v1, const void *v2)
+{
+	const struct trace_output_span *s1 = v1, *s2 = v2;
+
+	if (s1->start_us != s2->start_us)
+		return s1->start_us < s2->start_us ? -1 : 1;
+
+	return s1->depth - s2->depth;
+}
+
+/* Build a flame graph of the time spent in each stack of bootstage spans */
+static int make_span_flamegraph(void)
+{
+	struct flame_node root, *node, **stack;
+	struct trace_output_span *span;
+	int i, depth = 0;
+
+	memset(&root, '\0', sizeof(root));
+	stack = calloc(span_count + 1, sizeof(*stack));
+	assert(stack);
+	stack[0] = &root;
+	qsort(span_list, span_count, sizeof(*span_list), h_cmp_span_start);
+	for (i = 0, span = span_list; i < span_count; i++, span++) {
+		if (span->flags & TRACE_SPANF_MARK)
+			continue;
+
+		/* A span nests inside the last one started at the depth above */
+		if (span->depth < depth)
+			depth = span->depth;
+		span->name[TRACE_SPAN_NAME_LEN - 1] = '\0';
+		node = flame_child(stack[depth], span->name);
+		node->self_us += span->duration_us;
+		if (depth)
+			node->parent->self_us -= span->duration_us;
+		stack[++depth] = node;
+	}
+	out_flame_tree(&root);
+	free(stack);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -552,6 +843,12 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-chrome"))
+			err = make_chrome();
+		else if (0 == strcmp(cmd, "dump-flamegraph"))
+			err = make_flamegraph();
+		else if (0 == strcmp(cmd, "dump-span-flamegraph"))
+			err = make_span_flamegraph();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}